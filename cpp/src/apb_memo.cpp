@@ -0,0 +1,91 @@
+#include "apb_memo.hpp"
+
+#include <stdexcept>
+
+namespace app {
+
+ApbMemo::ApbMemo(size_t capacity)
+    : capacity_(capacity) {
+    if (capacity == 0) {
+        throw std::runtime_error("APB memo capacity must be positive");
+    }
+}
+
+std::string ApbMemo::make_key(const Kernel& kernel, const KernelSuperGroup& supergroup) {
+    std::string key = std::to_string(static_cast<int>(kernel.size())) + "@" +
+                      std::to_string(supergroup.x()) + "," + std::to_string(supergroup.y()) + "," +
+                      std::to_string(supergroup.size_x()) + "," + std::to_string(supergroup.size_y());
+    for (const auto& vrd : kernel.vrds()) {
+        key += "|" + vrd.name + ":" + std::to_string(vrd.element_size) + ":" +
+               std::to_string(vrd.num_elements) + ":" +
+               std::to_string(static_cast<int>(vrd.allocation_type)) +
+               (vrd.dma_channel_required ? ":dma" : "");
+    }
+    return key;
+}
+
+std::shared_ptr<const std::vector<BirdCommandSequence>> ApbMemo::get_or_generate(
+    const Kernel& kernel, const KernelSuperGroup& supergroup) {
+    std::string key = make_key(kernel, supergroup);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            ++hits_;
+            uses_.splice(uses_.begin(), uses_, it->second.use);
+            return it->second.sequences;
+        }
+        ++misses_;
+    }
+
+    // Generate outside the lock; a concurrent miss on the same key simply
+    // produces an identical copy and the first one stored wins
+    auto sequences = std::make_shared<const std::vector<BirdCommandSequence>>(
+        kernel.generate_apb_sequences(supergroup));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto inserted = entries_.emplace(key, Entry{std::move(sequences), uses_.end()});
+    if (!inserted.second) {
+        return inserted.first->second.sequences;
+    }
+    uses_.push_front(std::move(key));
+    inserted.first->second.use = uses_.begin();
+    auto cached = inserted.first->second.sequences;
+    while (entries_.size() > capacity_) {
+        entries_.erase(uses_.back());
+        uses_.pop_back();
+        ++evictions_;
+    }
+    return cached;
+}
+
+size_t ApbMemo::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+size_t ApbMemo::hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+size_t ApbMemo::misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
+
+size_t ApbMemo::evictions() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return evictions_;
+}
+
+void ApbMemo::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    uses_.clear();
+    hits_ = 0;
+    misses_ = 0;
+    evictions_ = 0;
+}
+
+} // namespace app
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bird.hpp"
+#include "kernel.hpp"
+#include "kernel_types.hpp"
+
+namespace app {
+
+/**
+ * @brief Thread-safe memo of kernel APB settings
+ *
+ * APB settings only depend on the kernel size, its VRD components and the
+ * supergroup, so kernels that are compiled again and again (or deployed on
+ * the same supergroup in several applications) share one generated copy.
+ * The least recently used settings are dropped beyond the capacity, which
+ * bounds a long-running compiler serving many applications.
+ */
+class ApbMemo {
+public:
+    /**
+     * @param capacity Number of settings kept
+     */
+    explicit ApbMemo(size_t capacity = 1024);
+
+    /**
+     * @brief Return the APB settings of a kernel, generating them on first use
+     *
+     * @param kernel Kernel to configure
+     * @param supergroup Supergroup the kernel is deployed to
+     */
+    std::shared_ptr<const std::vector<BirdCommandSequence>> get_or_generate(
+        const Kernel& kernel, const KernelSuperGroup& supergroup);
+
+    size_t capacity() const { return capacity_; }
+    size_t size() const;
+    size_t hits() const;
+    size_t misses() const;
+    size_t evictions() const;
+    void clear();
+
+private:
+    struct Entry {
+        std::shared_ptr<const std::vector<BirdCommandSequence>> sequences;
+        std::list<std::string>::iterator use;
+    };
+
+    size_t capacity_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::list<std::string> uses_;   // Most recently used first
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+    size_t evictions_ = 0;
+
+    static std::string make_key(const Kernel& kernel, const KernelSuperGroup& supergroup);
+};
+
+} // namespace app
@@ -0,0 +1,454 @@
+#include "app_compiler.hpp"
+
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "app_initializer.hpp"
+#include "compile_cache.hpp"
+#include "template_encoder.hpp"
+
+namespace app {
+
+namespace {
+
+std::string resolve_path(const std::string& base_dir, const std::string& path) {
+    if (base_dir.empty() || path.empty() || path[0] == '/') {
+        return path;
+    }
+    return base_dir + "/" + path;
+}
+
+std::string parent_directory(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    if (slash == std::string::npos) {
+        return "";
+    }
+    return path.substr(0, slash == 0 ? 1 : slash);
+}
+
+uint32_t parse_number(const std::string& token, size_t line_number,
+                      uint32_t max = std::numeric_limits<uint32_t>::max()) {
+    try {
+        size_t consumed = 0;
+        unsigned long long value = std::stoull(token, &consumed, 0);
+        if (consumed != token.size() || token[0] == '-' || value > max) {
+            throw std::invalid_argument(token);
+        }
+        return static_cast<uint32_t>(value);
+    } catch (const std::logic_error&) {
+        throw std::runtime_error("Line " + std::to_string(line_number) + ": invalid number '" + token + "'");
+    }
+}
+
+int parse_coordinate(const std::string& token, size_t line_number) {
+    return static_cast<int>(parse_number(token, line_number, std::numeric_limits<int>::max()));
+}
+
+KernelSpec& find_kernel(ApplicationManifest& manifest, const std::string& name, size_t line_number) {
+    for (auto& kernel : manifest.kernels) {
+        if (kernel.name == name) {
+            return kernel;
+        }
+    }
+    throw std::runtime_error("Line " + std::to_string(line_number) + ": unknown kernel '" + name + "'");
+}
+
+// Everything the template depends on: the manifest without VRD data files,
+// the stamps of all binaries and the options that change the output
+std::string template_key(const ApplicationManifest& manifest, const BuildOptions& options) {
+    std::ostringstream key;
+    key << manifest.name << '\n' << target_profile(manifest).to_string()
+        << (options.deduplicate_binaries ? "dedup" : "nodedup") << '\n'
+        << (options.prioritize ? "prioritize" : "deployment order") << '\n';
+    for (const auto& kernel : manifest.kernels) {
+        key << "kernel " << kernel.name << ' ' << static_cast<int>(kernel.size) << '\n';
+        for (const auto& binary : kernel.binaries) {
+            FileStamp stamp = file_stamp(binary);
+            key << "binary " << binary << ' ' << stamp.mtime_ns << ' ' << stamp.size << '\n';
+        }
+        for (const auto& vrd : kernel.vrds) {
+            key << "vrd " << vrd.component.name << ' ' << vrd.component.element_size << ' '
+                << vrd.component.num_elements << ' ' << static_cast<int>(vrd.component.allocation_type) << ' '
+                << vrd.component.dma_channel_required << '\n';
+        }
+    }
+    for (const auto& deployment : manifest.deployments) {
+        key << "deploy " << deployment.kernel << ' ' << deployment.x << ' ' << deployment.y << ' '
+            << deployment.size_x << ' ' << deployment.size_y << ' ' << deployment.weight << '\n';
+    }
+    return key.str();
+}
+
+// Map the end of every kernel span onto the final image, skipping the
+// checkpoints and trailer that have no template command
+std::vector<KernelReady> kernel_ready_offsets(const ApplicationManifest& manifest, const BuildResult& build,
+                                              const CommandIndex& index) {
+    std::vector<KernelReady> ready;
+    size_t generated = 0;
+    size_t i = 0;
+    for (const auto& span : build.kernel_spans) {
+        while (generated < span.end_command && i < index.size()) {
+            CommandType type = index[i].type;
+            if (type != CommandType::CHECKPOINT && type != CommandType::IMAGE_CHECKSUM) {
+                ++generated;
+            }
+            ++i;
+        }
+        if (generated < span.end_command) {
+            throw std::runtime_error("Image has fewer commands than the build");
+        }
+        const CommandEntry& last = index[i - 1];
+        ready.push_back(KernelReady{
+            span.deployment,
+            manifest.deployments[span.deployment].kernel,
+            i,
+            last.offset + last.size()
+        });
+    }
+    return ready;
+}
+
+// Normalize the final image of a result to rules; checksums, index and DMA
+// stats then describe the returned image, the result keeps the input
+NormalizedImage normalize_final(CompileResult& result, const DmaRules& rules, const CompileOptions& options) {
+    auto normalized = normalize_dma(result.init_sequence.data(), result.init_sequence.size(), rules,
+                                    &result.integrity, options.index_commands ? &result.index : nullptr);
+    if (!options.generate.command_checksums) {
+        result.integrity.command_checksums.clear();
+    }
+    result.dma_stats = normalized.stats;
+    return normalized;
+}
+
+} // namespace
+
+ApplicationManifest parse_manifest(std::istream& input, const std::string& base_dir) {
+    ApplicationManifest manifest;
+    manifest.name = "Application";
+
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(input, line)) {
+        ++line_number;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+
+        std::istringstream tokens(line);
+        std::vector<std::string> args;
+        for (std::string token; tokens >> token;) {
+            args.push_back(token);
+        }
+        if (args.empty()) {
+            continue;
+        }
+
+        const std::string& keyword = args[0];
+        auto expect_args = [&](size_t min_count, size_t max_count) {
+            if (args.size() < min_count || args.size() > max_count) {
+                throw std::runtime_error("Line " + std::to_string(line_number) + ": wrong number of arguments for '" + keyword + "'");
+            }
+        };
+
+        if (keyword == "application") {
+            expect_args(2, 2);
+            manifest.name = args[1];
+        } else if (keyword == "target") {
+            expect_args(2, 2);
+            bool builtin = args[1] == "chip" || args[1] == "haps";
+            manifest.target = builtin ? args[1] : resolve_path(base_dir, args[1]);
+        } else if (keyword == "grid") {
+            expect_args(2, 2);
+            manifest.grid = args[1];
+        } else if (keyword == "kernel") {
+            expect_args(3, 3);
+            for (const auto& kernel : manifest.kernels) {
+                if (kernel.name == args[1]) {
+                    throw std::runtime_error("Line " + std::to_string(line_number) + ": duplicate kernel '" + args[1] + "'");
+                }
+            }
+            manifest.kernels.push_back(KernelSpec{args[1], parse_kernel_size(args[2]), {}, {}});
+        } else if (keyword == "binary") {
+            expect_args(3, 3);
+            find_kernel(manifest, args[1], line_number).binaries.push_back(resolve_path(base_dir, args[2]));
+        } else if (keyword == "vrd") {
+            expect_args(6, 8);
+            VrdSpec vrd{
+                VrdComponent{
+                    args[2],
+                    parse_number(args[3], line_number),
+                    parse_number(args[4], line_number),
+                    parse_allocation_type(args[5]),
+                    false
+                },
+                ""
+            };
+            for (size_t i = 6; i < args.size(); ++i) {
+                if (args[i] == "dma") {
+                    vrd.component.dma_channel_required = true;
+                } else {
+                    vrd.data_file = resolve_path(base_dir, args[i]);
+                }
+            }
+            find_kernel(manifest, args[1], line_number).vrds.push_back(std::move(vrd));
+        } else if (keyword == "deploy") {
+            expect_args(6, 7);
+            find_kernel(manifest, args[1], line_number);
+            manifest.deployments.push_back(DeploymentSpec{
+                args[1],
+                parse_coordinate(args[2], line_number),
+                parse_coordinate(args[3], line_number),
+                parse_coordinate(args[4], line_number),
+                parse_coordinate(args[5], line_number),
+                args.size() > 6 ? parse_number(args[6], line_number) : 0
+            });
+        } else {
+            throw std::runtime_error("Line " + std::to_string(line_number) + ": unknown keyword '" + keyword + "'");
+        }
+    }
+
+    return manifest;
+}
+
+ApplicationManifest load_manifest(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open manifest: " + path);
+    }
+    return parse_manifest(file, parent_directory(path));
+}
+
+Grid make_grid(const std::string& grid_name) {
+    if (grid_name == "chip") {
+        return Grid::chip();
+    }
+    if (grid_name == "haps") {
+        return Grid::haps();
+    }
+    size_t separator = grid_name.find('x');
+    if (separator != std::string::npos) {
+        try {
+            return Grid(std::stoi(grid_name.substr(0, separator)), std::stoi(grid_name.substr(separator + 1)));
+        } catch (const std::logic_error&) {
+        }
+    }
+    throw std::runtime_error("Unknown grid: " + grid_name);
+}
+
+TargetProfile target_profile(const ApplicationManifest& manifest) {
+    TargetProfile profile;
+    if (!manifest.target.empty()) {
+        profile = TargetProfile::resolve(manifest.target);
+    } else {
+        profile = manifest.grid == "haps" ? TargetProfile::haps() : TargetProfile::chip();
+    }
+    if (!manifest.grid.empty()) {
+        Grid grid = make_grid(manifest.grid);
+        profile.size_x = grid.size_x();
+        profile.size_y = grid.size_y();
+    }
+    return profile;
+}
+
+std::optional<DmaRules> dma_rules_for(const ApplicationManifest& manifest, const DmaOptions& options) {
+    DmaRules rules = target_profile(manifest).dma_rules();
+    if (!options.max_burst && !options.alignment && !options.pad && rules.max_burst == 0) {
+        return std::nullopt;
+    }
+    rules.max_burst = options.max_burst.value_or(rules.max_burst);
+    rules.alignment = options.alignment.value_or(rules.alignment);
+    rules.pad = options.pad;
+    return rules;
+}
+
+std::vector<uint8_t> read_binary_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open file: " + path);
+    }
+    return std::vector<uint8_t>(
+        std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>()
+    );
+}
+
+AppCompiler::AppCompiler()
+    : cache_(std::make_shared<CompileCache>()) {}
+
+AppCompiler::AppCompiler(std::shared_ptr<CompileCache> cache)
+    : cache_(std::move(cache)) {}
+
+std::shared_ptr<const CompiledTemplate> AppCompiler::build_template(
+    const ApplicationManifest& manifest, const BuildOptions& options) const {
+    std::unordered_map<std::string, std::shared_ptr<Kernel>> kernels;
+    for (const auto& spec : manifest.kernels) {
+        auto kernel = std::make_shared<Kernel>(spec.name, spec.size);
+        for (const auto& binary : spec.binaries) {
+            kernel->add_binary(cache_->image(binary));
+        }
+        for (const auto& vrd : spec.vrds) {
+            kernel->add_vrd(vrd.component);
+        }
+        kernels.emplace(spec.name, kernel);
+    }
+
+    Application application(manifest.name, Grid(target_profile(manifest)));
+    for (const auto& deployment : manifest.deployments) {
+        auto kernel = kernels.at(deployment.kernel);
+        application.add_kernel(kernel, KernelSuperGroup(
+            deployment.x, deployment.y, deployment.size_x, deployment.size_y, kernel->size()), deployment.weight);
+    }
+
+    BuildOptions build_options = options;
+    if (!build_options.apb_memo) {
+        build_options.apb_memo = &cache_->apb_memo();
+    }
+    BuildResult build = application.build(build_options);
+    auto template_sequence = encode_init_template(build.sequences);
+    AppInitializer initializer(template_sequence);
+
+    return std::make_shared<const CompiledTemplate>(CompiledTemplate{
+        std::move(template_sequence),
+        std::move(build),
+        std::move(initializer)
+    });
+}
+
+CompileResult AppCompiler::compile(const ApplicationManifest& manifest, const CompileOptions& options) const {
+    CompileResult result;
+    if (!options.bind_vrds) {
+        auto compiled = find_or_build_template(manifest, options.build, &result.template_cached);
+        result.template_sequence = compiled->template_sequence;
+        result.build = compiled->build;
+        return result;
+    }
+
+    auto dma_rules = dma_rules_for(manifest, options.dma);
+    bool index_final = options.index_commands && !dma_rules;
+    result.init_sequence = bind(manifest, options.build, &result).generate_init_sequence(
+        options.generate, &result.integrity, index_final ? &result.index : nullptr);
+    if (index_final) {
+        result.kernel_ready = kernel_ready_offsets(manifest, result.build, result.index);
+    } else {
+        result.kernel_ready = kernel_ready_offsets(
+            manifest, result.build, CommandIndex::build(result.init_sequence.data(), result.init_sequence.size()));
+    }
+    if (!dma_rules) {
+        if (options.estimate_load) {
+            result.load_estimate = CostModel(target_profile(manifest)).estimate(
+                result.build, result.init_sequence.data(), result.init_sequence.size());
+        }
+        return result;
+    }
+
+    // Ready offsets then describe the normalized image as well
+    auto normalized = normalize_final(result, *dma_rules, options);
+    for (auto& ready : result.kernel_ready) {
+        size_t last = ready.command_count - 1;
+        ready.command_count = normalized.end_command[last] + 1;
+        ready.offset = normalized.end_offset[last];
+    }
+    if (options.estimate_load) {
+        result.load_estimate = CostModel(target_profile(manifest)).estimate(
+            result.build, result.init_sequence.data(), result.init_sequence.size(), normalized);
+    }
+    result.init_sequence = std::move(normalized.data);
+    return result;
+}
+
+CompileResult AppCompiler::resume(const ApplicationManifest& manifest, size_t first_command,
+                                  const CompileOptions& options) const {
+    CompileResult result;
+    auto dma_rules = dma_rules_for(manifest, options.dma);
+    bool index_final = options.index_commands && !dma_rules;
+    result.init_sequence = bind(manifest, options.build, &result).generate_resume_sequence(
+        first_command, options.generate, &result.integrity, index_final ? &result.index : nullptr);
+    if (dma_rules) {
+        result.init_sequence = normalize_final(result, *dma_rules, options).data;
+    }
+    return result;
+}
+
+VerifyResult AppCompiler::verify(const ApplicationManifest& manifest, const uint8_t* data, size_t size,
+                                 const CompileOptions& options) const {
+    VerifyResult verified;
+    if (!dma_rules_for(manifest, options.dma)) {
+        SourceVerifyOptions source_options;
+        source_options.num_threads = options.build.num_threads;
+        verified = verify_against_source(bind(manifest, options.build), data, size, source_options);
+        if (!verified.ok) {
+            return verified;
+        }
+    }
+    return verify_init_sequence(data, size);
+}
+
+std::shared_ptr<const CompiledTemplate> AppCompiler::find_or_build_template(
+    const ApplicationManifest& manifest, const BuildOptions& options, bool* cached) const {
+    std::string key = template_key(manifest, options);
+    auto compiled = cache_->find_template(key);
+    *cached = compiled != nullptr;
+    if (!compiled) {
+        compiled = cache_->store_template(key, build_template(manifest, options));
+    }
+    return compiled;
+}
+
+AppInitializer AppCompiler::bind(const ApplicationManifest& manifest, const BuildOptions& options,
+                                 CompileResult* result) const {
+    bool cached = false;
+    auto compiled = find_or_build_template(manifest, options, &cached);
+    if (result) {
+        result->template_sequence = compiled->template_sequence;
+        result->build = compiled->build;
+        result->template_cached = cached;
+    }
+
+    AppInitializer initializer = compiled->initializer;
+    for (const auto& spec : manifest.kernels) {
+        // Slot names and part sizes only depend on the VRD components
+        Kernel kernel(spec.name, spec.size);
+        for (const auto& vrd : spec.vrds) {
+            kernel.add_vrd(vrd.component);
+        }
+        auto resources = kernel.allocate_vrd_resources();
+
+        for (size_t v = 0; v < spec.vrds.size(); ++v) {
+            const auto& vrd = spec.vrds[v];
+            if (!initializer.has_vrd(kernel.vrd_slot_name(vrd.component.name, 0))) {
+                continue;  // Kernel is not deployed
+            }
+            if (vrd.data_file.empty()) {
+                throw std::runtime_error("No data file for VRD " + vrd.component.name + " of kernel " + spec.name);
+            }
+
+            auto data = read_binary_file(vrd.data_file);
+            if (data.size() != vrd.component.total_size()) {
+                throw std::runtime_error(
+                    "VRD data size mismatch for " + vrd.data_file +
+                    ". Expected: " + std::to_string(vrd.component.total_size()) +
+                    ", Got: " + std::to_string(data.size())
+                );
+            }
+
+            // Each allocated part receives the matching slice of the file
+            size_t offset = 0;
+            for (size_t i = 0; i < resources[v].size(); ++i) {
+                size_t length = resources[v][i].length;
+                initializer.load_vrd_data(
+                    kernel.vrd_slot_name(vrd.component.name, i),
+                    std::vector<uint8_t>(data.begin() + offset, data.begin() + offset + length)
+                );
+                offset += length;
+            }
+        }
+    }
+
+    return initializer;
+}
+
+} // namespace app
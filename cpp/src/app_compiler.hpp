@@ -0,0 +1,230 @@
+#pragma once
+
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "application.hpp"
+#include "command_index.hpp"
+#include "compile_cache.hpp"
+#include "cost_model.hpp"
+#include "dma_normalizer.hpp"
+#include "image_verifier.hpp"
+#include "kernel.hpp"
+#include "target_profile.hpp"
+
+namespace app {
+
+// VRD declared in a manifest, with the file holding its data
+struct VrdSpec {
+    VrdComponent component;
+    std::string data_file;   // Empty if the data is bound later
+};
+
+// Kernel declared in a manifest
+struct KernelSpec {
+    std::string name;
+    KernelSize size;
+    std::vector<std::string> binaries;
+    std::vector<VrdSpec> vrds;
+};
+
+// Placement of a kernel on a supergroup
+struct DeploymentSpec {
+    std::string kernel;
+    int x;
+    int y;
+    int size_x;
+    int size_y;
+    uint32_t weight = 0;   // Load priority, see BuildOptions::prioritize
+};
+
+/**
+ * @brief Application description read from a manifest file
+ *
+ * The manifest is line based; '#' starts a comment and relative paths are
+ * resolved against the manifest's directory:
+ *
+ *     application <name>
+ *     target chip|haps|<profile file>            # device limits, see TargetProfile
+ *     grid chip|haps|<size_x>x<size_y>           # overrides the target's grid size
+ *     kernel <name> <size>                       # size as in kernel JSON, e.g. 2x2, 1Vcore
+ *     binary <kernel> <file>                     # .ePM/.eDMw/.eVM/.eDM
+ *     vrd <kernel> <name> <element_size> <num_elements> <allocation_type> [<data file>] [dma]
+ *     deploy <kernel> <x> <y> <size_x> <size_y> [<weight>]   # higher weights load first when prioritized
+ */
+struct ApplicationManifest {
+    std::string name;
+    std::string target;   // Empty for the profile matching grid
+    std::string grid;     // Empty for the target's grid
+    std::vector<KernelSpec> kernels;
+    std::vector<DeploymentSpec> deployments;
+};
+
+/**
+ * @brief Parse a manifest
+ *
+ * @param input Manifest text
+ * @param base_dir Directory relative paths are resolved against
+ * @throw std::runtime_error on syntax errors, with the line number
+ */
+ApplicationManifest parse_manifest(std::istream& input, const std::string& base_dir);
+
+/**
+ * @brief Read and parse a manifest file
+ *
+ * @throw std::runtime_error if the file cannot be opened or is invalid
+ */
+ApplicationManifest load_manifest(const std::string& path);
+
+// DMA transfer rules requested for the final image; rules left unset come from the target
+struct DmaOptions {
+    std::optional<uint32_t> max_burst;   // Largest DMA payload in bytes, 0 for no limit
+    std::optional<uint32_t> alignment;
+    bool pad = false;                    // See DmaRules::pad
+};
+
+// Options for AppCompiler::compile
+struct CompileOptions {
+    BuildOptions build;
+    GenerateOptions generate;  // Checksums and trailer of the final image
+    bool bind_vrds = true;     // Load VRD data files and produce the final image
+    bool index_commands = false;  // Emit a CommandIndex of the final image
+    DmaOptions dma;               // Final image's DMA rules on top of the target's, see dma_rules_for
+    bool estimate_load = false;   // Estimate the final image's load time on the manifest's target
+};
+
+// Point in the final image after which a deployed kernel is fully initialized
+struct KernelReady {
+    size_t deployment;      // Index into ApplicationManifest::deployments
+    std::string kernel;
+    size_t command_count;   // Image commands up to and including the kernel's last one
+    size_t offset;          // Image bytes that must be loaded before the kernel can start
+};
+
+// Output of AppCompiler::compile
+struct CompileResult {
+    std::vector<uint8_t> template_sequence;   // Binary sequence with VRD slots
+    std::vector<uint8_t> init_sequence;       // Final image, empty if VRDs are not bound
+    ImageIntegrity integrity;                 // Checksums of the final image
+    CommandIndex index;                       // Index of the final image, if requested
+    std::vector<KernelReady> kernel_ready;    // In load order, if the final image was generated
+    DmaStats dma_stats;                       // Changes made by DMA normalization, if any
+    LoadEstimate load_estimate;               // Estimated load time of the final image, if requested
+    BuildResult build;
+    bool template_cached = false;             // Template came from the compile cache
+};
+
+/**
+ * @brief Native end-to-end application compiler
+ *
+ * Builds the application described by a manifest with all optimization
+ * passes and turns it into the initialization image, replacing the Python
+ * Application/Kernel/Grid front end followed by AppInitializer.
+ *
+ * Compilers sharing a CompileCache reuse decoded images, APB settings and
+ * templates; compile may be called concurrently.
+ */
+class AppCompiler {
+public:
+    AppCompiler();
+    explicit AppCompiler(std::shared_ptr<CompileCache> cache);
+
+    /**
+     * @brief Compile a manifest into a template and, if requested, a final image
+     *
+     * @throw std::runtime_error on invalid manifests, unreadable files or
+     *        placement failures
+     */
+    CompileResult compile(const ApplicationManifest& manifest, const CompileOptions& options = CompileOptions()) const;
+
+    /**
+     * @brief Compile the final image from a command on, see AppInitializer::generate_resume_sequence
+     *
+     * DMAs are normalized like compile's. Kernel ready offsets and load
+     * estimates are not produced.
+     *
+     * @param first_command Ordinal of the first template command to generate
+     * @throw std::out_of_range if first_command exceeds the template's commands
+     * @throw std::runtime_error like compile
+     */
+    CompileResult resume(const ApplicationManifest& manifest, size_t first_command,
+                         const CompileOptions& options = CompileOptions()) const;
+
+    /**
+     * @brief Check an image compiled from a manifest
+     *
+     * Images whose DMAs are left as generated are compared with the
+     * template and VRD data, which locates the bad command. Normalized
+     * images no longer match the template command for command and are
+     * checked against their own checksums only.
+     *
+     * @param options Build options, also giving the comparison's threads, and DMA rules of the image
+     * @throw std::runtime_error like bind
+     */
+    VerifyResult verify(const ApplicationManifest& manifest, const uint8_t* data, size_t size,
+                        const CompileOptions& options = CompileOptions()) const;
+
+    /**
+     * @brief Build the template, or reuse it, and bind all VRD data files
+     *
+     * The returned initializer generates the image as built, e.g. straight
+     * into shared memory with SharedImage::generate; the final image is
+     * that image normalized to dma_rules_for, if the target asks for it.
+     *
+     * @param result If not null, receives the template and build output
+     * @throw std::runtime_error like compile, or if a VRD has no data file
+     */
+    AppInitializer bind(const ApplicationManifest& manifest, const BuildOptions& options = BuildOptions(),
+                        CompileResult* result = nullptr) const;
+
+    const std::shared_ptr<CompileCache>& cache() const { return cache_; }
+
+private:
+    std::shared_ptr<CompileCache> cache_;
+
+    std::shared_ptr<const CompiledTemplate> build_template(const ApplicationManifest& manifest,
+                                                           const BuildOptions& options) const;
+    std::shared_ptr<const CompiledTemplate> find_or_build_template(const ApplicationManifest& manifest,
+                                                                   const BuildOptions& options, bool* cached) const;
+};
+
+/**
+ * @brief Create the grid named in a manifest
+ *
+ * @throw std::runtime_error for unknown grid names
+ */
+Grid make_grid(const std::string& grid_name);
+
+/**
+ * @brief Target profile of a manifest
+ *
+ * Without a target, a grid named haps selects the haps profile and any
+ * other grid the chip profile. A grid line overrides the profile's size.
+ *
+ * @throw std::runtime_error for unknown grids or unreadable profiles
+ */
+TargetProfile target_profile(const ApplicationManifest& manifest);
+
+/**
+ * @brief DMA rules the final image of a manifest is normalized to
+ *
+ * DMAs are normalized if the options set any rule or the target limits
+ * bursts; rules the options leave unset come from the target profile.
+ *
+ * @return The rules, or nothing if DMAs are left as generated
+ * @throw std::runtime_error like target_profile
+ */
+std::optional<DmaRules> dma_rules_for(const ApplicationManifest& manifest, const DmaOptions& options);
+
+/**
+ * @brief Read a whole file into memory
+ *
+ * @throw std::runtime_error if the file cannot be opened
+ */
+std::vector<uint8_t> read_binary_file(const std::string& path);
+
+} // namespace app
@@ -1,7 +1,33 @@
 #include "app_initializer.hpp"
 
+#include <cstring>
+
+#include "command_index.hpp"
+#include "crc32c.hpp"
+#include "register_shadow.hpp"
+
 namespace app {
 
+namespace {
+
+// IMAGE_CHECKSUM: type, length, command count, checksum
+constexpr size_t kTrailerSize = 1 + 4 + 8;
+// CHECKPOINT: type, length, ordinal of the next command
+constexpr size_t kCheckpointSize = 1 + 4 + 4;
+
+// Commands that only describe a generated image; they are regenerated, never copied
+bool is_generated_marker(CommandType type) {
+    return type == CommandType::IMAGE_CHECKSUM || type == CommandType::CHECKPOINT;
+}
+
+// Checkpoints precede every Nth command, except where the output starts
+bool has_checkpoint_before(size_t ordinal, size_t first_command, const GenerateOptions& options) {
+    return options.checkpoint_interval > 0 && ordinal > first_command &&
+           ordinal % options.checkpoint_interval == 0;
+}
+
+} // namespace
+
 AppInitializer::AppInitializer(const std::string& binary_file) {
     std::ifstream file(binary_file, std::ios::binary);
     if (!file) {
@@ -18,6 +44,11 @@ AppInitializer::AppInitializer(const std::string& binary_file) {
     parse_binary_sequence();
 }
 
+AppInitializer::AppInitializer(std::vector<uint8_t> binary_sequence)
+    : binary_sequence_(std::move(binary_sequence)) {
+    parse_binary_sequence();
+}
+
 void AppInitializer::load_vrd_data(const std::string& vrd_name, const std::vector<uint8_t>& data) {
     auto it = vrd_map_.find(vrd_name);
     if (it == vrd_map_.end()) {
@@ -37,14 +68,87 @@ void AppInitializer::load_vrd_data(const std::string& vrd_name, const std::vecto
 }
 
 std::vector<uint8_t> AppInitializer::generate_init_sequence() const {
-    // Verify all VRDs are loaded
-    for (const auto& vrd_pair : vrd_map_) {
-        if (!vrd_pair.second.is_loaded) {
-            throw std::runtime_error("VRD data not loaded: " + vrd_pair.first);
+    return generate_init_sequence(GenerateOptions());
+}
+
+std::vector<uint8_t> AppInitializer::generate_init_sequence(const GenerateOptions& options, ImageIntegrity* integrity,
+                                                            CommandIndex* index) const {
+    std::vector<uint8_t> init_sequence(init_sequence_size(options));
+    write_init_sequence(init_sequence.data(), options, integrity, index);
+    return init_sequence;
+}
+
+size_t AppInitializer::init_sequence_size(const GenerateOptions& options) const {
+    return output_size(0, 0, options);
+}
+
+void AppInitializer::write_init_sequence(uint8_t* out, const GenerateOptions& options, ImageIntegrity* integrity,
+                                         CommandIndex* index) const {
+    write_output(out, 0, std::vector<uint8_t>(), options, integrity, index);
+}
+
+size_t AppInitializer::command_count() const {
+    size_t count = 0;
+    size_t pos = 0;
+
+    while (pos < binary_sequence_.size()) {
+        CommandType cmd_type = static_cast<CommandType>(binary_sequence_[pos++]);
+        uint32_t length = read_uint32(pos);
+        pos += 4 + length;
+
+        if (!is_generated_marker(cmd_type)) {
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+RegisterShadow AppInitializer::register_state(size_t first_command) const {
+    if (first_command > command_count()) {
+        throw std::out_of_range("Command " + std::to_string(first_command) + " out of range");
+    }
+
+    RegisterShadow shadow;
+    size_t ordinal = 0;
+    size_t pos = 0;
+
+    while (pos < binary_sequence_.size() && ordinal < first_command) {
+        CommandType cmd_type = static_cast<CommandType>(binary_sequence_[pos++]);
+        uint32_t length = read_uint32(pos);
+        pos += 4;
+
+        if (cmd_type == CommandType::APB_WRITE || cmd_type == CommandType::SAFE_APB_WRITE) {
+            shadow.apply(read_uint32(pos), read_uint32(pos + 4), cmd_type == CommandType::SAFE_APB_WRITE);
         }
+        if (!is_generated_marker(cmd_type)) {
+            ++ordinal;
+        }
+
+        pos += length;
     }
 
-    std::vector<uint8_t> init_sequence;
+    return shadow;
+}
+
+std::vector<uint8_t> AppInitializer::generate_resume_sequence(size_t first_command, const GenerateOptions& options,
+                                                              ImageIntegrity* integrity, CommandIndex* index) const {
+    check_vrds_loaded();
+
+    // Registers written by the skipped commands come first, compacted
+    std::vector<uint8_t> prefix;
+    register_state(first_command).encode(prefix);
+
+    std::vector<uint8_t> sequence(output_size(first_command, prefix.size(), options));
+    write_output(sequence.data(), first_command, prefix, options, integrity, index);
+    return sequence;
+}
+
+size_t AppInitializer::output_size(size_t first_command, size_t prefix_size, const GenerateOptions& options) const {
+    check_vrds_loaded();
+
+    size_t total_size = prefix_size;
+    size_t ordinal = 0;
     size_t pos = 0;
 
     while (pos < binary_sequence_.size()) {
@@ -52,12 +156,130 @@ std::vector<uint8_t> AppInitializer::generate_init_sequence() const {
         uint32_t length = read_uint32(pos);
         pos += 4;
 
+        if (!is_generated_marker(cmd_type)) {
+            if (ordinal >= first_command) {
+                if (has_checkpoint_before(ordinal, first_command, options)) {
+                    total_size += kCheckpointSize;
+                }
+                if (cmd_type == CommandType::VRD_INFO) {
+                    // Replaced by a DMA write of the VRD data
+                    std::string vrd_name(
+                        reinterpret_cast<const char*>(&binary_sequence_[pos]),
+                        length - 8
+                    );
+                    total_size += 1 + 4 + 8 + vrd_map_.at(vrd_name).data.size();
+                } else {
+                    total_size += 1 + 4 + length;
+                }
+            }
+            ++ordinal;
+        }
+
+        pos += length;
+    }
+
+    if (options.checksum_trailer) {
+        total_size += kTrailerSize;
+    }
+    return total_size;
+}
+
+void AppInitializer::write_output(uint8_t* out, size_t first_command, const std::vector<uint8_t>& prefix,
+                                  const GenerateOptions& options, ImageIntegrity* integrity,
+                                  CommandIndex* index) const {
+    check_vrds_loaded();
+
+    uint8_t* const image_start = out;
+    if (index) {
+        *index = CommandIndex();
+    }
+
+    bool track_image = integrity || options.checksum_trailer;
+    bool track_commands = integrity && options.command_checksums;
+    uint32_t image_checksum = 0;
+    uint32_t command_count = 0;
+    if (track_commands) {
+        integrity->command_checksums.clear();
+    }
+
+    // Checksum and index each command while it is still in cache
+    auto finish_command = [&](uint8_t* command_start, CommandType type, uint32_t dst_addr, uint32_t dst_size) {
+        size_t command_size = static_cast<size_t>(out - command_start);
+        if (track_image) {
+            image_checksum = crc32c(image_checksum, command_start, command_size);
+        }
+        if (track_commands) {
+            integrity->command_checksums.push_back(crc32c(0, command_start, command_size));
+        }
+        if (index) {
+            index->add(CommandEntry{
+                static_cast<uint64_t>(command_start - image_start),
+                type,
+                static_cast<uint32_t>(command_size - 5),
+                dst_addr,
+                dst_size
+            });
+        }
+        ++command_count;
+    };
+
+    // Register state prefix of a resumed sequence: APB writes only
+    for (size_t prefix_pos = 0; prefix_pos < prefix.size(); prefix_pos += 13) {
+        uint8_t* command_start = out;
+        std::memcpy(out, &prefix[prefix_pos], 13);
+        out += 13;
+        uint32_t dst_addr = static_cast<uint32_t>(prefix[prefix_pos + 5]) |
+                            (static_cast<uint32_t>(prefix[prefix_pos + 6]) << 8) |
+                            (static_cast<uint32_t>(prefix[prefix_pos + 7]) << 16) |
+                            (static_cast<uint32_t>(prefix[prefix_pos + 8]) << 24);
+        finish_command(command_start, static_cast<CommandType>(prefix[prefix_pos]), dst_addr, 4);
+    }
+
+    size_t ordinal = 0;
+    size_t pos = 0;
+
+    while (pos < binary_sequence_.size()) {
+        CommandType cmd_type = static_cast<CommandType>(binary_sequence_[pos++]);
+        uint32_t length = read_uint32(pos);
+        pos += 4;
+
+        if (is_generated_marker(cmd_type)) {
+            // Stale trailers and checkpoints no longer describe the output
+            pos += length;
+            continue;
+        }
+        if (ordinal < first_command) {
+            // Covered by the register state prefix
+            ++ordinal;
+            pos += length;
+            continue;
+        }
+
+        if (has_checkpoint_before(ordinal, first_command, options)) {
+            uint8_t* checkpoint_start = out;
+            *out++ = static_cast<uint8_t>(CommandType::CHECKPOINT);
+            out = put_uint32(out, 4);
+            out = put_uint32(out, static_cast<uint32_t>(ordinal));
+            finish_command(checkpoint_start, CommandType::CHECKPOINT, 0, 0);
+        }
+
+        uint8_t* command_start = out;
+        uint32_t dst_addr = 0;
+        uint32_t dst_size = 0;
+
         switch (cmd_type) {
             case CommandType::APB_WRITE:
-                // Copy APB write command as is
-                init_sequence.push_back(static_cast<uint8_t>(cmd_type));
-                append_uint32(init_sequence, length);
-                copy_bytes(init_sequence, pos, length);
+            case CommandType::SAFE_APB_WRITE:
+            case CommandType::DMA_WRITE:
+                // Copy APB and DMA write commands as is
+                *out++ = static_cast<uint8_t>(cmd_type);
+                out = put_uint32(out, length);
+                std::memcpy(out, &binary_sequence_[pos], length);
+                out += length;
+                if (length >= 8) {
+                    dst_addr = read_uint32(pos);
+                    dst_size = cmd_type == CommandType::DMA_WRITE ? read_uint32(pos + 4) : 4;
+                }
                 break;
 
             case CommandType::VRD_INFO: {
@@ -72,33 +294,61 @@ std::vector<uint8_t> AppInitializer::generate_init_sequence() const {
                 const auto& vrd = vrd_map_.at(vrd_name);
                 
                 // Generate DMA write command for VRD data
-                init_sequence.push_back(static_cast<uint8_t>(CommandType::DMA_WRITE));
-                append_uint32(init_sequence, vrd.data.size() + 8);  // data size + addr + length
-                append_uint32(init_sequence, vrd.dst_addr);
-                append_uint32(init_sequence, vrd.data.size());
-                init_sequence.insert(
-                    init_sequence.end(),
-                    vrd.data.begin(),
-                    vrd.data.end()
-                );
+                *out++ = static_cast<uint8_t>(CommandType::DMA_WRITE);
+                out = put_uint32(out, vrd.data.size() + 8);  // data size + addr + length
+                out = put_uint32(out, vrd.dst_addr);
+                out = put_uint32(out, vrd.data.size());
+                if (!vrd.data.empty()) {
+                    std::memcpy(out, vrd.data.data(), vrd.data.size());
+                }
+                out += vrd.data.size();
+                dst_addr = vrd.dst_addr;
+                dst_size = static_cast<uint32_t>(vrd.data.size());
+                cmd_type = CommandType::DMA_WRITE;
                 break;
             }
 
-            case CommandType::DMA_WRITE:
-                // Copy DMA write command as is
-                init_sequence.push_back(static_cast<uint8_t>(cmd_type));
-                append_uint32(init_sequence, length);
-                copy_bytes(init_sequence, pos, length);
-                break;
-
             default:
                 throw std::runtime_error("Unknown command type: " + std::to_string(static_cast<int>(cmd_type)));
         }
 
+        finish_command(command_start, cmd_type, dst_addr, dst_size);
+        ++ordinal;
         pos += length;
     }
 
-    return init_sequence;
+    if (options.checksum_trailer) {
+        uint8_t* trailer_start = out;
+        *out++ = static_cast<uint8_t>(CommandType::IMAGE_CHECKSUM);
+        out = put_uint32(out, 8);
+        out = put_uint32(out, command_count);
+        out = put_uint32(out, image_checksum);
+        image_checksum = crc32c(image_checksum, trailer_start, kTrailerSize);
+        if (index) {
+            index->add(CommandEntry{
+                static_cast<uint64_t>(trailer_start - image_start),
+                CommandType::IMAGE_CHECKSUM,
+                8,
+                0,
+                0
+            });
+        }
+    }
+    if (integrity) {
+        integrity->image_checksum = image_checksum;
+    }
+    if (index) {
+        index->finish(static_cast<size_t>(out - image_start));
+    }
+}
+
+void AppInitializer::check_vrds_loaded() const {
+    // Verify all VRDs are loaded
+    for (const auto& vrd_pair : vrd_map_) {
+        if (!vrd_pair.second.is_loaded) {
+            throw std::runtime_error("VRD data not loaded: " + vrd_pair.first);
+        }
+    }
 }
 
 void AppInitializer::parse_binary_sequence() {
@@ -143,19 +393,12 @@ uint32_t AppInitializer::read_uint32(size_t pos) const {
            (static_cast<uint32_t>(binary_sequence_[pos + 3]) << 24);
 }
 
-void AppInitializer::append_uint32(std::vector<uint8_t>& vec, uint32_t value) {
-    vec.push_back(static_cast<uint8_t>(value));
-    vec.push_back(static_cast<uint8_t>(value >> 8));
-    vec.push_back(static_cast<uint8_t>(value >> 16));
-    vec.push_back(static_cast<uint8_t>(value >> 24));
-}
-
-void AppInitializer::copy_bytes(std::vector<uint8_t>& dest, size_t src_pos, size_t length) const {
-    dest.insert(
-        dest.end(),
-        binary_sequence_.begin() + src_pos,
-        binary_sequence_.begin() + src_pos + length
-    );
+uint8_t* AppInitializer::put_uint32(uint8_t* out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+    out[2] = static_cast<uint8_t>(value >> 16);
+    out[3] = static_cast<uint8_t>(value >> 24);
+    return out + 4;
 }
 
 } // namespace app 
\ No newline at end of file
@@ -15,7 +15,28 @@ enum class CommandType : uint8_t {
     APB_WRITE = 0x01,  // Single APB register write
     VRD_INFO = 0x02,   // Variable Resident Data information
     PM_BINARY = 0x03,  // Program Memory binary (deprecated)
-    DMA_WRITE = 0x04   // DMA write command
+    DMA_WRITE = 0x04,  // DMA write command
+    SAFE_APB_WRITE = 0x05, // APB register write that must complete before the next command
+    IMAGE_CHECKSUM = 0x06, // Trailer: command count and CRC32C of all preceding bytes
+    CHECKPOINT = 0x07,     // Resume point: ordinal of the next command
+    FENCE_SIGNAL = 0x08,   // Stream image: mark a fence id as reached
+    FENCE_WAIT = 0x09      // Stream image: block until a fence id is signaled
+};
+
+class CommandIndex;
+class RegisterShadow;
+
+// Options for generating the final initialization sequence
+struct GenerateOptions {
+    bool command_checksums = false;   // Record the CRC32C of every command
+    bool checksum_trailer = false;    // Append an IMAGE_CHECKSUM command
+    size_t checkpoint_interval = 0;   // Emit a CHECKPOINT before every Nth command, 0 for none
+};
+
+// Checksums computed while the sequence is generated
+struct ImageIntegrity {
+    uint32_t image_checksum = 0;              // CRC32C of the whole sequence, trailer included
+    std::vector<uint32_t> command_checksums;  // CRC32C of every command except the trailer
 };
 
 // Structure to hold VRD information
@@ -43,6 +64,13 @@ public:
      */
     explicit AppInitializer(const std::string& binary_file);
 
+    /**
+     * @brief Construct a new App Initializer object from an in-memory sequence
+     * 
+     * @param binary_sequence Binary sequence, e.g. produced by encode_init_template
+     */
+    explicit AppInitializer(std::vector<uint8_t> binary_sequence);
+
     /**
      * @brief Load data for a specific VRD
      * 
@@ -60,6 +88,84 @@ public:
      */
     std::vector<uint8_t> generate_init_sequence() const;
 
+    /**
+     * @brief Generate the final initialization sequence with integrity data
+     * 
+     * Checksums are computed command by command while the output is still
+     * in cache, so they cost no extra pass over the image.
+     * 
+     * @param options Checksums to compute and whether to append a trailer
+     * @param integrity If not null, receives the computed checksums
+     * @param index If not null, receives the index of the generated commands
+     * @return std::vector<uint8_t> The complete initialization sequence
+     * @throw std::runtime_error if any VRD is not loaded
+     */
+    std::vector<uint8_t> generate_init_sequence(const GenerateOptions& options, ImageIntegrity* integrity = nullptr,
+                                                CommandIndex* index = nullptr) const;
+
+    /**
+     * @brief Size of the final initialization sequence in bytes
+     * 
+     * @param options Generation options, the trailer adds a command
+     * @return size_t Number of bytes write_init_sequence produces
+     * @throw std::runtime_error if any VRD is not loaded
+     */
+    size_t init_sequence_size(const GenerateOptions& options = GenerateOptions()) const;
+
+    /**
+     * @brief Generate the final initialization sequence into caller memory
+     * 
+     * Lets the image be written straight into its destination, e.g. a
+     * shared memory region, without an intermediate vector. IMAGE_CHECKSUM
+     * and CHECKPOINT commands in the binary sequence are dropped and
+     * regenerated as requested.
+     * 
+     * @param out Destination of at least init_sequence_size(options) bytes
+     * @param options Checksums to compute and whether to append a trailer
+     * @param integrity If not null, receives the computed checksums
+     * @param index If not null, receives the index of the generated commands
+     * @throw std::runtime_error if any VRD is not loaded
+     */
+    void write_init_sequence(uint8_t* out, const GenerateOptions& options = GenerateOptions(),
+                             ImageIntegrity* integrity = nullptr, CommandIndex* index = nullptr) const;
+
+    /**
+     * @brief Number of commands the template generates
+     * 
+     * Command ordinals used for resuming count these commands only;
+     * checkpoints, trailers and register state prefixes are not counted.
+     */
+    size_t command_count() const;
+
+    /**
+     * @brief Register state left behind by the commands before first_command
+     * 
+     * @param first_command Ordinal of the first command not applied
+     * @throw std::out_of_range if first_command exceeds command_count()
+     */
+    RegisterShadow register_state(size_t first_command) const;
+
+    /**
+     * @brief Generate the sequence from a command on, e.g. the ordinal of
+     *        the last CHECKPOINT the device reached
+     * 
+     * The skipped commands' memory writes are assumed to have landed; the
+     * register state they leave behind is re-established by one compacted
+     * write per register, followed by the remaining commands. Recovery
+     * cost therefore scales with the remaining work.
+     * 
+     * @param first_command Ordinal of the first command to generate
+     * @param options Checksums, trailer and checkpoints of the output
+     * @param integrity If not null, receives the computed checksums
+     * @param index If not null, receives the index of the generated commands
+     * @throw std::out_of_range if first_command exceeds command_count()
+     * @throw std::runtime_error if any VRD is not loaded
+     */
+    std::vector<uint8_t> generate_resume_sequence(size_t first_command,
+                                                  const GenerateOptions& options = GenerateOptions(),
+                                                  ImageIntegrity* integrity = nullptr,
+                                                  CommandIndex* index = nullptr) const;
+
     /**
      * @brief Get the number of VRDs in the sequence
      * 
@@ -92,14 +198,22 @@ public:
         return it->second;
     }
 
+    /**
+     * @brief The binary sequence (template) the initializer was created from
+     */
+    const std::vector<uint8_t>& binary_sequence() const { return binary_sequence_; }
+
 private:
     std::vector<uint8_t> binary_sequence_;
     std::unordered_map<std::string, VrdInfo> vrd_map_;
 
     void parse_binary_sequence();
+    void check_vrds_loaded() const;
+    size_t output_size(size_t first_command, size_t prefix_size, const GenerateOptions& options) const;
+    void write_output(uint8_t* out, size_t first_command, const std::vector<uint8_t>& prefix,
+                      const GenerateOptions& options, ImageIntegrity* integrity, CommandIndex* index) const;
     uint32_t read_uint32(size_t pos) const;
-    static void append_uint32(std::vector<uint8_t>& vec, uint32_t value);
-    void copy_bytes(std::vector<uint8_t>& dest, size_t src_pos, size_t length) const;
+    static uint8_t* put_uint32(uint8_t* out, uint32_t value);
 };
 
 } // namespace app 
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "application.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+#include "parallel.hpp"
+
+namespace app {
+
+Application::Application(std::string name, Grid grid)
+    : name_(std::move(name)), grid_(std::move(grid)) {}
+
+void Application::add_kernel(std::shared_ptr<const Kernel> kernel, const KernelSuperGroup& supergroup,
+                             uint32_t weight) {
+    if (kernel->size() != supergroup.kernel_size()) {
+        throw std::runtime_error("Kernel size of " + kernel->name() + " does not match supergroup kernel size");
+    }
+
+    for (const auto& location : supergroup.get_kernel_locations()) {
+        if (!grid_.allocate_kernel(kernel->size(), location)) {
+            throw std::runtime_error(
+                "Cannot place kernel " + kernel->name() + " at (" +
+                std::to_string(location.x) + ", " + std::to_string(location.y) + ")"
+            );
+        }
+    }
+
+    // Create broadcast networks for the supergroup
+    const NetworkType network_types[] = {
+        NetworkType{BroadcastType::SUPER_PE_BRCST, GridDestinationType::VCORE},
+        NetworkType{BroadcastType::SUPER_MSS_BRCST, GridDestinationType::MSS},
+        NetworkType{BroadcastType::SUPER_PE_BRCST, GridDestinationType::APB}
+    };
+    for (const auto& network_type : network_types) {
+        grid_.add_broadcast_network(supergroup, network_type);
+    }
+
+    kernels_.push_back(KernelDeployment{std::move(kernel), supergroup, weight});
+}
+
+std::vector<size_t> Application::load_order(const BuildOptions& options) const {
+    std::vector<size_t> order(kernels_.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (options.prioritize) {
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return kernels_[a].weight > kernels_[b].weight;
+        });
+    }
+    return order;
+}
+
+BuildResult Application::build(const BuildOptions& options) const {
+    BuildResult result;
+
+    // Deduplication depends on load order, so binaries are claimed up front
+    // in load order before any block is generated
+    auto order = load_order(options);
+    std::vector<std::vector<std::shared_ptr<const KernelImage>>> emitted_binaries(kernels_.size());
+    BinaryDeduplicator dedup;
+    for (size_t i : order) {
+        const auto& deployment = kernels_[i];
+        if (deployment.kernel->binaries().empty()) {
+            throw std::runtime_error("Kernel " + deployment.kernel->name() + " is not built. Add PM binary before deployment.");
+        }
+        for (const auto& binary : deployment.kernel->binaries()) {
+            if (!options.deduplicate_binaries || dedup.claim(KernelImage::load_network(), binary)) {
+                emitted_binaries[i].push_back(binary);
+            }
+        }
+    }
+    result.dedup_stats = dedup.stats();
+
+    // Generate each kernel's command block in parallel
+    std::vector<std::vector<BirdCommandSequence>> blocks(kernels_.size());
+    parallel_for(kernels_.size(), options.num_threads, [&](size_t i) {
+        const auto& deployment = kernels_[i];
+        std::vector<BirdCommandSequence> block;
+        if (options.apb_memo) {
+            block = *options.apb_memo->get_or_generate(*deployment.kernel, deployment.supergroup);
+        } else {
+            block = deployment.kernel->generate_apb_sequences(deployment.supergroup);
+        }
+        for (const auto& binary : emitted_binaries[i]) {
+            block.push_back(binary->generate_bird_sequence());
+        }
+        for (auto& vrd_seq : deployment.kernel->generate_vrd_sequences()) {
+            block.push_back(std::move(vrd_seq));
+        }
+        blocks[i] = std::move(block);
+    });
+
+    // Stitch blocks in load order, switching networks when needed
+    result.sequences.push_back(grid_.get_apb_settings());
+    size_t command_count = result.sequences.back().commands.size();
+    bool has_network = false;
+    NetworkType current_network{BroadcastType::DIRECT, GridDestinationType::APB};
+
+    for (size_t i : order) {
+        KernelSpan span{i, result.sequences.size(), 0, command_count, 0};
+        for (auto& sequence : blocks[i]) {
+            if (!has_network || sequence.network_type != current_network) {
+                result.network_switches.push_back(result.sequences.size());
+                result.sequences.push_back(grid_.get_network_switch(sequence.network_type));
+                command_count += result.sequences.back().commands.size();
+                current_network = sequence.network_type;
+                has_network = true;
+            }
+            command_count += sequence.commands.size();
+            result.sequences.push_back(std::move(sequence));
+        }
+        span.end_sequence = result.sequences.size();
+        span.end_command = command_count;
+        result.kernel_spans.push_back(span);
+    }
+
+    return result;
+}
+
+} // namespace app
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "apb_memo.hpp"
+#include "binary_dedup.hpp"
+#include "bird.hpp"
+#include "grid.hpp"
+#include "kernel.hpp"
+#include "kernel_types.hpp"
+
+namespace app {
+
+// Options for Application::build
+struct BuildOptions {
+    size_t num_threads = 0;             // Worker threads, 0 for hardware concurrency
+    bool deduplicate_binaries = true;   // Skip binaries already resident in the broadcast domain
+    ApbMemo* apb_memo = nullptr;        // Shared APB settings, generated per build if null
+    bool prioritize = false;            // Stitch kernels by descending weight instead of deployment order
+};
+
+// Kernel placed on a supergroup
+struct KernelDeployment {
+    std::shared_ptr<const Kernel> kernel;
+    KernelSuperGroup supergroup;
+    uint32_t weight = 0;   // Load priority with BuildOptions::prioritize, higher first
+};
+
+// Range of stitched sequences [first_sequence, end_sequence) belonging to one
+// deployment, and the commands [first_command, end_command) they hold
+struct KernelSpan {
+    size_t deployment;
+    size_t first_sequence;
+    size_t end_sequence;
+    size_t first_command;
+    size_t end_command;
+};
+
+// Output of Application::build
+struct BuildResult {
+    std::vector<BirdCommandSequence> sequences;
+    std::vector<KernelSpan> kernel_spans;   // In stitched order
+    std::vector<size_t> network_switches;   // Indices of the inserted network switch sequences
+    DedupStats dedup_stats;
+};
+
+/**
+ * @brief Native application builder (mirrors application.Application)
+ *
+ * Kernel command blocks are generated in parallel on a thread pool and then
+ * stitched in deployment order with network switches in between, so the
+ * output is identical for any thread count.
+ *
+ * With BuildOptions::prioritize, blocks are stitched by descending weight
+ * instead (ties keep deployment order), so latency-critical kernels have
+ * their settings, binaries and VRDs loaded before unrelated kernels.
+ */
+class Application {
+public:
+    Application(std::string name, Grid grid);
+
+    /**
+     * @brief Deploy a kernel on every location of a supergroup
+     *
+     * @param weight Load priority used when building with BuildOptions::prioritize
+     * @throw std::runtime_error if the kernel size does not match the
+     *        supergroup or a location is already taken
+     */
+    void add_kernel(std::shared_ptr<const Kernel> kernel, const KernelSuperGroup& supergroup, uint32_t weight = 0);
+
+    const std::string& name() const { return name_; }
+    const Grid& grid() const { return grid_; }
+    const std::vector<KernelDeployment>& kernels() const { return kernels_; }
+
+    /**
+     * @brief Deployment indices in the order their blocks are stitched
+     */
+    std::vector<size_t> load_order(const BuildOptions& options = BuildOptions()) const;
+
+    /**
+     * @brief Generate and stitch the command blocks of all kernels
+     *
+     * @param options Thread count and optimization switches
+     * @return BuildResult Stitched sequences with per-kernel spans
+     */
+    BuildResult build(const BuildOptions& options = BuildOptions()) const;
+
+    /**
+     * @brief Generate the complete BIRD sequence for the application
+     */
+    std::vector<BirdCommandSequence> generate_bird_sequence(const BuildOptions& options = BuildOptions()) const {
+        return build(options).sequences;
+    }
+
+private:
+    std::string name_;
+    Grid grid_;
+    std::vector<KernelDeployment> kernels_;
+};
+
+} // namespace app
@@ -0,0 +1,68 @@
+#include "binary_dedup.hpp"
+
+#include <algorithm>
+
+namespace app {
+
+bool BinaryDeduplicator::claim(const NetworkType& network, const std::shared_ptr<const KernelImage>& image) {
+    ++stats_.images_seen;
+
+    Domain& domain = find_or_add_domain(network);
+
+    for (const auto& resident : domain.residents) {
+        if (resident.image == image || resident.image->same_contents(*image)) {
+            ++stats_.images_deduplicated;
+            stats_.bytes_saved += image->size_bytes();
+            return false;
+        }
+    }
+
+    // Address span covered by the new image
+    uint32_t begin = 0;
+    uint64_t end = 0;
+    if (!image->segments().empty()) {
+        begin = image->segments().front().addr;
+        for (const auto& segment : image->segments()) {
+            end = std::max<uint64_t>(end, static_cast<uint64_t>(segment.addr) + segment.data.size());
+        }
+    }
+
+    domain.residents.erase(
+        std::remove_if(domain.residents.begin(), domain.residents.end(),
+            [begin, end](const ResidentImage& resident) {
+                return resident.begin < end && begin < resident.end;
+            }),
+        domain.residents.end()
+    );
+    domain.residents.push_back(ResidentImage{image, begin, end});
+    ++stats_.images_emitted;
+    return true;
+}
+
+std::vector<BirdCommandSequence> BinaryDeduplicator::generate_bird_sequences(
+    const std::vector<std::shared_ptr<const KernelImage>>& binaries) {
+    std::vector<BirdCommandSequence> sequences;
+    for (const auto& binary : binaries) {
+        if (claim(KernelImage::load_network(), binary)) {
+            sequences.push_back(binary->generate_bird_sequence());
+        }
+    }
+    return sequences;
+}
+
+void BinaryDeduplicator::reset() {
+    domains_.clear();
+    stats_ = DedupStats();
+}
+
+BinaryDeduplicator::Domain& BinaryDeduplicator::find_or_add_domain(const NetworkType& network_type) {
+    for (auto& domain : domains_) {
+        if (domain.network_type == network_type) {
+            return domain;
+        }
+    }
+    domains_.push_back(Domain{network_type, {}});
+    return domains_.back();
+}
+
+} // namespace app
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include "bird.hpp"
+#include "kernel_image.hpp"
+#include "kernel_types.hpp"
+
+namespace app {
+
+// Counters reported by BinaryDeduplicator
+struct DedupStats {
+    size_t images_seen = 0;          // Images offered for emission
+    size_t images_emitted = 0;       // Images that produced DMA commands
+    size_t images_deduplicated = 0;  // Images skipped because already resident
+    size_t bytes_saved = 0;          // DMA payload bytes not re-sent
+};
+
+/**
+ * @brief Content-hash based deduplication of kernel binary loads
+ *
+ * Kernel binaries are DMAed over a broadcast network that reaches every
+ * kernel on it, so an image only needs to be sent once per network. The
+ * deduplicator remembers which images are resident on each network and
+ * skips repeated loads of identical contents, whether they come from the
+ * same kernel or from any other kernel loaded over the network.
+ *
+ * A resident image is forgotten as soon as a different image is loaded over
+ * any part of its address range on the same network, so a skipped load
+ * never leaves stale memory behind.
+ */
+class BinaryDeduplicator {
+public:
+    /**
+     * @brief Decide whether an image has to be loaded over a network
+     *
+     * @param network Network the image is broadcast over
+     * @param image Image to load
+     * @return true if the caller must emit the image, false if identical
+     *         contents are already resident on the network
+     */
+    bool claim(const NetworkType& network, const std::shared_ptr<const KernelImage>& image);
+
+    /**
+     * @brief Generate the load sequences for a kernel's binaries, skipping
+     *        images that are already resident on the load network
+     *
+     * @param binaries Kernel binaries in load order
+     * @return One sequence per image that still needs loading
+     */
+    std::vector<BirdCommandSequence> generate_bird_sequences(
+        const std::vector<std::shared_ptr<const KernelImage>>& binaries);
+
+    const DedupStats& stats() const { return stats_; }
+
+    /**
+     * @brief Forget all resident images and reset the counters
+     */
+    void reset();
+
+private:
+    struct ResidentImage {
+        std::shared_ptr<const KernelImage> image;
+        uint32_t begin;
+        uint64_t end;
+    };
+
+    struct Domain {
+        NetworkType network_type;
+        std::vector<ResidentImage> residents;
+    };
+
+    std::vector<Domain> domains_;
+    DedupStats stats_;
+
+    Domain& find_or_add_domain(const NetworkType& network_type);
+};
+
+} // namespace app
@@ -0,0 +1,66 @@
+#include "bird.hpp"
+
+#include <stdexcept>
+
+namespace app {
+
+namespace {
+
+const char* broadcast_type_name(BroadcastType type) {
+    switch (type) {
+        case BroadcastType::DIRECT: return "direct";
+        case BroadcastType::PEG_MSS_BRCST: return "peg_mss_broadcast";
+        case BroadcastType::PEG_PE_BRCST: return "peg_pe_broadcast";
+        case BroadcastType::SUPER_PE_ID_BRCST: return "supergroup_pe_id_broadcast";
+        case BroadcastType::SUPER_PE_BRCST: return "supergroup_pe_broadcast";
+        case BroadcastType::SUPER_MSS_BRCST: return "supergroup_mss_broadcast";
+    }
+    return "unknown";
+}
+
+const char* destination_type_name(GridDestinationType type) {
+    switch (type) {
+        case GridDestinationType::VCORE: return "vcore";
+        case GridDestinationType::MSS: return "mss";
+        case GridDestinationType::APB: return "apb";
+    }
+    return "unknown";
+}
+
+} // namespace
+
+std::string NetworkType::value() const {
+    return std::string(broadcast_type_name(broadcast_type)) + "_" +
+           destination_type_name(destination_type);
+}
+
+void BirdCommandSequence::add_single_command(uint32_t dst_addr, uint32_t data, bool safe) {
+    commands.push_back(BirdCommand{
+        safe ? BirdCommandType::SAFE_SINGLE : BirdCommandType::SINGLE,
+        dst_addr,
+        data,
+        {},
+        {}
+    });
+}
+
+void BirdCommandSequence::add_dma_command(uint32_t dst_addr, std::vector<uint8_t> data) {
+    if (data.size() % 16 != 0) {
+        throw std::runtime_error("Data must be a multiple of 16 bytes");
+    }
+    commands.push_back(BirdCommand{BirdCommandType::DMA, dst_addr, 0, std::move(data), {}});
+}
+
+void BirdCommandSequence::add_vrd_command(uint32_t dst_addr, uint32_t size, std::string vrd_name) {
+    commands.push_back(BirdCommand{BirdCommandType::VRD, dst_addr, size, {}, std::move(vrd_name)});
+}
+
+size_t BirdCommandSequence::dma_payload_size() const {
+    size_t total = 0;
+    for (const auto& cmd : commands) {
+        total += cmd.data.size();
+    }
+    return total;
+}
+
+} // namespace app
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace app {
+
+// Broadcast network types (mirrors bird.BroadcastType)
+enum class BroadcastType : uint8_t {
+    DIRECT = 0,
+    PEG_MSS_BRCST = 1,
+    PEG_PE_BRCST = 2,
+    SUPER_PE_ID_BRCST = 3,
+    SUPER_PE_BRCST = 4,
+    SUPER_MSS_BRCST = 5
+};
+
+// Destination types on the grid (mirrors bird.GridDestinationType)
+enum class GridDestinationType : uint8_t {
+    VCORE = 0,
+    MSS = 1,
+    APB = 2
+};
+
+// BIRD command types (mirrors bird.BirdCommandType)
+enum class BirdCommandType : uint8_t {
+    SINGLE = 0,       // Single 32-bit register write
+    SAFE_SINGLE = 1,  // Single write that must complete before the next command
+    DMA = 2,          // DMA write of a 16-byte aligned block
+    VRD = 3           // Slot for VRD data bound at load time
+};
+
+/**
+ * @brief Network configuration with broadcast type and destination
+ */
+struct NetworkType {
+    BroadcastType broadcast_type;
+    GridDestinationType destination_type;
+
+    bool operator==(const NetworkType& other) const {
+        return broadcast_type == other.broadcast_type &&
+               destination_type == other.destination_type;
+    }
+    bool operator!=(const NetworkType& other) const { return !(*this == other); }
+
+    /**
+     * @brief String form matching NetworkType.value on the Python side
+     */
+    std::string value() const;
+};
+
+struct NetworkTypeHash {
+    size_t operator()(const NetworkType& network) const {
+        return (static_cast<size_t>(network.broadcast_type) << 8) |
+               static_cast<size_t>(network.destination_type);
+    }
+};
+
+// Single BIRD command
+struct BirdCommand {
+    BirdCommandType type;
+    uint32_t dst_addr;
+    uint32_t value;               // Register value for SINGLE / SAFE_SINGLE, size for VRD
+    std::vector<uint8_t> data;    // Payload for DMA
+    std::string vrd_name;         // VRD identifier for VRD
+};
+
+/**
+ * @brief Ordered list of BIRD commands sent over one network
+ */
+struct BirdCommandSequence {
+    std::string description;
+    NetworkType network_type;
+    std::vector<BirdCommand> commands;
+
+    /**
+     * @brief Append a register write
+     *
+     * @param dst_addr Register address
+     * @param data 32-bit value
+     * @param safe Emit a SAFE_SINGLE instead of a SINGLE
+     */
+    void add_single_command(uint32_t dst_addr, uint32_t data, bool safe = false);
+
+    /**
+     * @brief Append a DMA write
+     *
+     * @param dst_addr Destination address
+     * @param data Raw bytes to be transferred
+     * @throw std::runtime_error if data is not a multiple of 16 bytes
+     */
+    void add_dma_command(uint32_t dst_addr, std::vector<uint8_t> data);
+
+    /**
+     * @brief Append a slot for VRD data that is bound at load time
+     *
+     * @param dst_addr Destination address
+     * @param size VRD size in bytes
+     * @param vrd_name VRD identifier, unique within the application
+     */
+    void add_vrd_command(uint32_t dst_addr, uint32_t size, std::string vrd_name);
+
+    /**
+     * @brief Total number of DMA payload bytes in this sequence
+     */
+    size_t dma_payload_size() const;
+};
+
+} // namespace app
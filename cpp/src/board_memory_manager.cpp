@@ -0,0 +1,242 @@
+#include "board_memory_manager.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "parallel.hpp"
+
+namespace app {
+
+namespace {
+
+// First address of the free ranges where size bytes fit
+bool first_fit(const std::vector<std::pair<uint64_t, uint64_t>>& ranges, uint64_t size, uint64_t& address) {
+    for (const auto& range : ranges) {
+        if (range.second - range.first >= size) {
+            address = range.first;
+            return true;
+        }
+    }
+    return false;
+}
+
+BoardRecord chip_record(int chip, const RequirementRecord& record) {
+    BoardRecord result;
+    result.requirement = BoardRequirement{DimensionRequirement::specific(chip), record.requirement};
+    result.fulfilled = record.fulfilled;
+    if (record.fulfilled) {
+        result.chips.push_back(chip);
+        result.address = record.placement.address;
+    }
+    return result;
+}
+
+} // namespace
+
+BoardMemoryManager::BoardMemoryManager(uint32_t chip_count, uint32_t pe_count, uint32_t mss_per_pe,
+                                       uint32_t slices_per_mss, uint64_t slice_size) {
+    if (chip_count == 0) {
+        throw std::runtime_error("Board must have at least one chip");
+    }
+    chips_.reserve(chip_count);
+    for (uint32_t chip = 0; chip < chip_count; ++chip) {
+        chips_.emplace_back(pe_count, mss_per_pe, slices_per_mss, slice_size);
+    }
+}
+
+BoardMemoryManager BoardMemoryManager::from_profile(const TargetProfile& profile, uint32_t chip_count,
+                                                    uint32_t pe_count) {
+    MemoryManager chip = MemoryManager::from_profile(profile, pe_count);
+    return BoardMemoryManager(chip_count, chip.pe_count(), chip.mss_per_pe(), chip.slices_per_mss(),
+                              chip.slice_size());
+}
+
+void BoardMemoryManager::validate(const BoardRequirement& requirement) const {
+    const DimensionRequirement& chip = requirement.chip;
+    uint32_t count = chip_count();
+    if (chip.scope == DimensionScope::SPECIFIC && (chip.value < -1 || chip.value >= static_cast<int>(count))) {
+        throw std::runtime_error("Chip " + std::to_string(chip.value) + " out of range (" + std::to_string(count) +
+                                 " available)");
+    }
+    if (chip.scope == DimensionScope::GROUP && (chip.mask == 0 || (count < 64 && chip.mask >> count != 0))) {
+        std::ostringstream message;
+        message << "Chip mask 0x" << std::hex << chip.mask << std::dec << " does not fit " << count << " chips";
+        throw std::runtime_error(message.str());
+    }
+    chips_.front().validate(requirement.requirement);
+}
+
+void BoardMemoryManager::set_trace_sink(TraceSink* sink) {
+    auto shared = sink ? std::make_unique<SynchronizedSink>(*sink) : nullptr;
+    for (auto& chip : chips_) {
+        chip.set_trace_sink(shared.get());
+    }
+    trace_ = std::move(shared);
+}
+
+bool BoardMemoryManager::allocate(const BoardRequirement& requirement) {
+    validate(requirement);
+    if (requirement.chip.needs_selection()) {
+        return place_automatic(requirement);
+    }
+    std::vector<int> chips = requirement.chip.values(chip_count());
+    if (chips.size() > 1) {
+        return place_across(requirement, chips);
+    }
+    MemoryManager& chip = chips_[static_cast<size_t>(chips[0])];
+    bool success = chip.allocate(requirement.requirement);
+    records_.push_back(chip_record(chips[0], chip.requirements().back()));
+    return success;
+}
+
+bool BoardMemoryManager::place_across(const BoardRequirement& requirement, const std::vector<int>& chips) {
+    records_.push_back(BoardRecord{requirement, false, {}, 0});
+
+    // Resolve on every chip, then take the first address free on all of them
+    std::vector<MemoryRequirement> resolved(chips.size(), requirement.requirement);
+    std::vector<std::pair<uint64_t, uint64_t>> common;
+    for (size_t i = 0; i < chips.size(); ++i) {
+        const MemoryManager& chip = chips_[static_cast<size_t>(chips[i])];
+        if (!chip.resolve(resolved[i])) {
+            return false;
+        }
+        std::vector<std::pair<uint64_t, uint64_t>> ranges = chip.free_ranges(resolved[i]);
+        common = i == 0 ? std::move(ranges) : intersect_ranges(common, ranges);
+    }
+    uint64_t address = 0;
+    if (!first_fit(common, chips_.front().slice_allocation_size(requirement.requirement), address)) {
+        return false;
+    }
+    for (size_t i = 0; i < chips.size(); ++i) {
+        chips_[static_cast<size_t>(chips[i])].allocate_at(resolved[i], address);
+    }
+
+    BoardRecord& record = records_.back();
+    record.fulfilled = true;
+    record.chips = chips;
+    record.address = address;
+    return true;
+}
+
+bool BoardMemoryManager::place_automatic(const BoardRequirement& requirement) {
+    records_.push_back(BoardRecord{requirement, false, {}, 0});
+
+    // The chips with the most free memory are tried first
+    std::vector<int> order(chips_.size());
+    std::vector<uint64_t> free(chips_.size());
+    for (size_t chip = 0; chip < chips_.size(); ++chip) {
+        order[chip] = static_cast<int>(chip);
+        free[chip] = chips_[chip].summary().free_bytes;
+    }
+    std::stable_sort(order.begin(), order.end(), [&free](int a, int b) {
+        return free[static_cast<size_t>(a)] > free[static_cast<size_t>(b)];
+    });
+
+    for (int index : order) {
+        MemoryManager& chip = chips_[static_cast<size_t>(index)];
+        MemoryRequirement resolved = requirement.requirement;
+        uint64_t address = 0;
+        if (chip.resolve(resolved) &&
+            first_fit(chip.free_ranges(resolved), chip.slice_allocation_size(resolved), address)) {
+            chip.allocate_at(resolved, address);
+            BoardRecord& record = records_.back();
+            record.fulfilled = true;
+            record.chips.push_back(index);
+            record.address = address;
+            return true;
+        }
+    }
+    return false;
+}
+
+void BoardMemoryManager::collect(const BoardRequirement& requirement) {
+    validate(requirement);
+    collected_.push_back(requirement);
+}
+
+BoardBatchResult BoardMemoryManager::allocate_all(size_t num_threads) {
+    std::vector<BoardRequirement> collected;
+    collected.swap(collected_);
+
+    // Requirements on one chip join that chip's batch
+    std::vector<const BoardRequirement*> across;
+    std::vector<const BoardRequirement*> automatic;
+    for (const auto& requirement : collected) {
+        if (requirement.chip.needs_selection()) {
+            automatic.push_back(&requirement);
+        } else if (requirement.chip.values(chip_count()).size() > 1) {
+            across.push_back(&requirement);
+        } else {
+            chips_[static_cast<size_t>(requirement.chip.values(chip_count())[0])].collect(requirement.requirement);
+        }
+    }
+
+    BoardBatchResult result;
+    auto count = [&result](bool success) {
+        if (success) {
+            ++result.successful;
+        } else {
+            ++result.failed;
+        }
+    };
+
+    // Broadest first: most chips, then largest
+    std::stable_sort(across.begin(), across.end(), [this](const BoardRequirement* a, const BoardRequirement* b) {
+        size_t chips_a = a->chip.values(chip_count()).size();
+        size_t chips_b = b->chip.values(chip_count()).size();
+        return chips_a != chips_b ? chips_a > chips_b : a->requirement.size > b->requirement.size;
+    });
+    for (const BoardRequirement* requirement : across) {
+        count(place_across(*requirement, requirement->chip.values(chip_count())));
+    }
+
+    // Chips share nothing, so their batches run in parallel
+    std::vector<BatchResult> batches(chips_.size());
+    parallel_for(chips_.size(), num_threads, [&](size_t chip) { batches[chip] = chips_[chip].allocate_all(); });
+    for (size_t chip = 0; chip < chips_.size(); ++chip) {
+        for (const BatchStep& step : batches[chip].steps) {
+            records_.push_back(chip_record(static_cast<int>(chip), chips_[chip].requirements()[step.requirement]));
+            count(step.success);
+        }
+    }
+
+    std::stable_sort(automatic.begin(), automatic.end(), [](const BoardRequirement* a, const BoardRequirement* b) {
+        return a->requirement.size > b->requirement.size;
+    });
+    for (const BoardRequirement* requirement : automatic) {
+        count(place_automatic(*requirement));
+    }
+    result.coordinated = across.size() + automatic.size();
+    return result;
+}
+
+MemorySummary BoardMemoryManager::summary() const {
+    MemorySummary total;
+    for (const auto& chip : chips_) {
+        MemorySummary summary = chip.summary();
+        total.mappings += summary.mappings;
+        total.forks += summary.forks;
+        total.requirements += summary.requirements;
+        total.fulfilled += summary.fulfilled;
+        total.pending += summary.pending;
+        total.allocated_bytes += summary.allocated_bytes;
+        total.free_bytes += summary.free_bytes;
+        total.requested_bytes += summary.requested_bytes;
+        total.forks_avoided += summary.forks_avoided;
+        total.merges += summary.merges;
+    }
+
+    // Failed coordinator requirements reached no shard
+    for (const auto& record : records_) {
+        const DimensionRequirement& chip = record.requirement.chip;
+        if (!record.fulfilled && (chip.needs_selection() || chip.values(chip_count()).size() > 1)) {
+            ++total.requirements;
+            ++total.pending;
+        }
+    }
+    return total;
+}
+
+} // namespace app
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "memory_manager.hpp"
+#include "target_profile.hpp"
+#include "trace_events.hpp"
+
+namespace app {
+
+// Memory requirement on a board of chips
+struct BoardRequirement {
+    DimensionRequirement chip;        // Every chip, one chip, auto, or a group of chips
+    MemoryRequirement requirement;    // Within every covered chip
+};
+
+struct BoardRecord {
+    BoardRequirement requirement;     // Requirements on one chip name that chip
+    bool fulfilled = false;
+    std::vector<int> chips;           // Chips holding the buffer
+    uint64_t address = 0;             // The same on every chip
+};
+
+struct BoardBatchResult {
+    size_t successful = 0;
+    size_t failed = 0;
+    size_t coordinated = 0;   // Requirements placed by the coordinator
+};
+
+/**
+ * @brief Memory managers for the chips of a board
+ *
+ * Every chip is an independent MemoryManager shard. Requirements on one
+ * chip go straight to its shard. The coordinator places requirements over
+ * several chips at one address free on all of them, and picks the chip
+ * for auto-selected ones. allocate_all() runs the shards' batches in
+ * parallel, so planning time follows the busiest chip, not the chip count.
+ * A sink set on one chip with chip(i).set_trace_sink is called from that
+ * chip's batch thread, so each chip needs its own; set_trace_sink shares
+ * one sink between all chips.
+ */
+class BoardMemoryManager {
+public:
+    BoardMemoryManager(uint32_t chip_count, uint32_t pe_count, uint32_t mss_per_pe = 4,
+                       uint32_t slices_per_mss = 8, uint64_t slice_size = 1024 * 1024);
+
+    /**
+     * @brief Board of chips with a profile's memory geometry
+     * @param pe_count 0 for every node of the profile's grid
+     */
+    static BoardMemoryManager from_profile(const TargetProfile& profile, uint32_t chip_count, uint32_t pe_count = 0);
+
+    /**
+     * @brief Receive the events of every chip on one sink; null (the
+     *        default) disables them
+     *
+     * Emits from the parallel chip batches are serialized, so the sink
+     * need not be thread safe. It must outlive the manager or be unset.
+     */
+    void set_trace_sink(TraceSink* sink);
+
+    uint32_t chip_count() const { return static_cast<uint32_t>(chips_.size()); }
+    MemoryManager& chip(int chip) { return chips_.at(static_cast<size_t>(chip)); }
+    const MemoryManager& chip(int chip) const { return chips_.at(static_cast<size_t>(chip)); }
+
+    /**
+     * @brief Place one requirement, recording it in requirements()
+     * @return false if no chip, resource combination or address fits
+     * @throw std::runtime_error if the requirement does not fit the board
+     */
+    bool allocate(const BoardRequirement& requirement);
+
+    // Queue a requirement for allocate_all()
+    void collect(const BoardRequirement& requirement);
+
+    /**
+     * @brief Allocate the collected requirements: those over several chips
+     *        first, broadest first, then every chip's own batch in parallel,
+     *        then those with an auto-selected chip, largest first
+     * @param num_threads Threads for the chip batches, 0 for hardware concurrency
+     * @throw std::runtime_error if a requirement does not fit the board
+     */
+    BoardBatchResult allocate_all(size_t num_threads = 0);
+
+    // In allocation order
+    const std::vector<BoardRecord>& requirements() const { return records_; }
+
+    // Totals over every chip; a buffer on several chips counts once per chip,
+    // a failed requirement placed by the coordinator counts once
+    MemorySummary summary() const;
+
+    /**
+     * @throw std::runtime_error if the requirement does not fit the board
+     */
+    void validate(const BoardRequirement& requirement) const;
+
+private:
+    std::vector<MemoryManager> chips_;
+    std::vector<BoardRecord> records_;
+    std::vector<BoardRequirement> collected_;
+    std::unique_ptr<SynchronizedSink> trace_;   // Shared by every chip
+
+    bool place_across(const BoardRequirement& requirement, const std::vector<int>& chips);
+    bool place_automatic(const BoardRequirement& requirement);
+};
+
+} // namespace app
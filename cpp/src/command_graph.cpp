@@ -0,0 +1,336 @@
+#include "command_graph.hpp"
+
+#include <algorithm>
+#include <map>
+#include <queue>
+#include <stdexcept>
+
+#include "kernel_image.hpp"
+
+namespace app {
+
+namespace {
+
+constexpr size_t kNoNode = std::numeric_limits<size_t>::max();
+
+AccessSpace destination_space(GridDestinationType type) {
+    switch (type) {
+        case GridDestinationType::APB: return AccessSpace::APB;
+        case GridDestinationType::MSS: return AccessSpace::MSS;
+        case GridDestinationType::VCORE: return AccessSpace::VCORE;
+    }
+    return AccessSpace::APB;
+}
+
+// One resource per network in the bridge space
+AddressRange bridge_range(const NetworkType& network) {
+    uint64_t id = static_cast<uint64_t>(network.broadcast_type) * 16 +
+                  static_cast<uint64_t>(network.destination_type);
+    return AddressRange{AccessSpace::BRIDGE, kGlobalScope, id, id + 1};
+}
+
+// Deployment whose kernel block holds a sequence, or kGlobalScope
+size_t sequence_scope(const BuildResult& build, size_t sequence) {
+    auto span = std::upper_bound(build.kernel_spans.begin(), build.kernel_spans.end(), sequence,
+                                 [](size_t value, const KernelSpan& s) { return value < s.first_sequence; });
+    if (span == build.kernel_spans.begin()) {
+        return kGlobalScope;
+    }
+    --span;
+    return sequence < span->end_sequence ? span->deployment : kGlobalScope;
+}
+
+bool is_network_switch(const BuildResult& build, size_t sequence) {
+    return std::binary_search(build.network_switches.begin(), build.network_switches.end(), sequence);
+}
+
+// Disjoint ranges of one address space and scope with their last writer and
+// the readers since that write
+class IntervalMap {
+public:
+    template <typename Fn>
+    void visit(uint64_t begin, uint64_t end, Fn fn) const {
+        auto it = intervals_.upper_bound(begin);
+        if (it != intervals_.begin()) {
+            --it;
+        }
+        for (; it != intervals_.end() && it->first < end; ++it) {
+            if (it->second.end > begin) {
+                fn(it->second);
+            }
+        }
+    }
+
+    void write(uint64_t begin, uint64_t end, size_t node) {
+        split(begin);
+        split(end);
+        intervals_.erase(intervals_.lower_bound(begin), intervals_.lower_bound(end));
+        intervals_.emplace(begin, Interval{end, node, {}});
+    }
+
+    void read(uint64_t begin, uint64_t end, size_t node) {
+        split(begin);
+        split(end);
+        uint64_t pos = begin;
+        auto it = intervals_.lower_bound(begin);
+        while (pos < end) {
+            if (it == intervals_.end() || it->first > pos) {
+                // Gap nobody wrote yet
+                uint64_t gap_end = it == intervals_.end() ? end : std::min(end, it->first);
+                intervals_.emplace_hint(it, pos, Interval{gap_end, kNoNode, {node}});
+                pos = gap_end;
+            } else {
+                it->second.readers.push_back(node);
+                pos = it->second.end;
+                ++it;
+            }
+        }
+    }
+
+    struct Interval {
+        uint64_t end;
+        size_t writer;
+        std::vector<size_t> readers;
+    };
+
+private:
+    std::map<uint64_t, Interval> intervals_;
+
+    void split(uint64_t at) {
+        auto it = intervals_.upper_bound(at);
+        if (it == intervals_.begin()) {
+            return;
+        }
+        --it;
+        if (it->first < at && at < it->second.end) {
+            Interval tail = it->second;
+            it->second.end = at;
+            intervals_.emplace_hint(std::next(it), at, std::move(tail));
+        }
+    }
+};
+
+void add_range(std::vector<AddressRange>& ranges, AccessSpace space, size_t scope, uint64_t begin, uint64_t size) {
+    if (size > 0) {
+        ranges.push_back(AddressRange{space, scope, begin, begin + size});
+    }
+}
+
+// Sort and merge touching ranges of the same space and scope
+void merge_ranges(std::vector<AddressRange>& ranges) {
+    std::sort(ranges.begin(), ranges.end(), [](const AddressRange& a, const AddressRange& b) {
+        if (a.space != b.space) return a.space < b.space;
+        if (a.scope != b.scope) return a.scope < b.scope;
+        return a.begin < b.begin;
+    });
+    size_t out = 0;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        if (out > 0 && ranges[out - 1].space == ranges[i].space && ranges[out - 1].scope == ranges[i].scope &&
+            ranges[i].begin <= ranges[out - 1].end) {
+            ranges[out - 1].end = std::max(ranges[out - 1].end, ranges[i].end);
+        } else {
+            ranges[out++] = ranges[i];
+        }
+    }
+    ranges.resize(out);
+}
+
+} // namespace
+
+AccessSet sequence_accesses(const BuildResult& build, size_t sequence) {
+    const BirdCommandSequence& seq = build.sequences.at(sequence);
+    AccessSet accesses;
+
+    if (is_network_switch(build, sequence)) {
+        // A switch selects the network of the sequence it precedes
+        if (sequence + 1 < build.sequences.size()) {
+            accesses.writes.push_back(bridge_range(build.sequences[sequence + 1].network_type));
+        }
+        accesses.idempotent = true;
+        return accesses;
+    }
+
+    // Binaries go over one network shared by every kernel, see BinaryDeduplicator
+    size_t scope = seq.network_type == KernelImage::load_network() ? kGlobalScope : sequence_scope(build, sequence);
+    AccessSpace space = destination_space(seq.network_type.destination_type);
+    accesses.reads.push_back(bridge_range(seq.network_type));
+    for (const auto& command : seq.commands) {
+        switch (command.type) {
+            case BirdCommandType::SAFE_SINGLE:
+                accesses.barrier = true;
+                add_range(accesses.writes, space, scope, command.dst_addr, 4);
+                break;
+            case BirdCommandType::SINGLE:
+                add_range(accesses.writes, space, scope, command.dst_addr, 4);
+                break;
+            case BirdCommandType::DMA:
+                add_range(accesses.writes, space, scope, command.dst_addr, command.data.size());
+                break;
+            case BirdCommandType::VRD:
+                add_range(accesses.writes, space, scope, command.dst_addr, command.value);
+                break;
+        }
+    }
+    merge_ranges(accesses.writes);
+    return accesses;
+}
+
+CommandGraph CommandGraph::build(const BuildResult& build) {
+    CommandGraph graph;
+    size_t node_count = build.sequences.size();
+    graph.predecessors_.resize(node_count);
+    graph.successors_.resize(node_count);
+    graph.levels_.assign(node_count, 0);
+
+    // Interval maps per address space and scope
+    std::map<std::pair<AccessSpace, size_t>, IntervalMap> maps;
+    size_t last_barrier = kNoNode;
+    std::vector<size_t> since_barrier;
+    std::vector<size_t> seen(node_count, kNoNode);
+
+    for (size_t node = 0; node < node_count; ++node) {
+        AccessSet accesses = sequence_accesses(build, node);
+        auto& preds = graph.predecessors_[node];
+        auto depend = [&](size_t pred) {
+            if (pred != kNoNode && pred != node && seen[pred] != node) {
+                seen[pred] = node;
+                preds.push_back(pred);
+            }
+        };
+
+        if (accesses.barrier) {
+            for (size_t pred : since_barrier) {
+                depend(pred);
+            }
+        }
+        depend(last_barrier);
+
+        // Global ranges overlap every scope of their space, scoped ranges
+        // their own scope and the global one
+        auto visit = [&](const AddressRange& range, bool write) {
+            auto check = [&](const IntervalMap& map) {
+                map.visit(range.begin, range.end, [&](const IntervalMap::Interval& interval) {
+                    depend(interval.writer);
+                    if (write && !accesses.idempotent) {
+                        for (size_t reader : interval.readers) {
+                            depend(reader);
+                        }
+                    }
+                });
+            };
+            if (range.scope == kGlobalScope) {
+                auto first = maps.lower_bound({range.space, 0});
+                for (auto it = first; it != maps.end() && it->first.first == range.space; ++it) {
+                    check(it->second);
+                }
+            } else {
+                auto own = maps.find({range.space, range.scope});
+                if (own != maps.end()) {
+                    check(own->second);
+                }
+                auto global = maps.find({range.space, kGlobalScope});
+                if (global != maps.end()) {
+                    check(global->second);
+                }
+            }
+        };
+        for (const auto& range : accesses.reads) {
+            visit(range, false);
+        }
+        for (const auto& range : accesses.writes) {
+            visit(range, true);
+        }
+
+        std::sort(preds.begin(), preds.end());
+        for (size_t pred : preds) {
+            graph.successors_[pred].push_back(node);
+            graph.levels_[node] = std::max(graph.levels_[node], graph.levels_[pred] + 1);
+        }
+        graph.edge_count_ += preds.size();
+        graph.depth_ = std::max(graph.depth_, graph.levels_[node] + 1);
+
+        if (accesses.barrier) {
+            // Everything before is ordered by the barrier already
+            maps.clear();
+            since_barrier.clear();
+            last_barrier = node;
+            continue;
+        }
+        since_barrier.push_back(node);
+        for (const auto& range : accesses.reads) {
+            maps[{range.space, range.scope}].read(range.begin, range.end, node);
+        }
+        for (const auto& range : accesses.writes) {
+            maps[{range.space, range.scope}].write(range.begin, range.end, node);
+        }
+    }
+
+    return graph;
+}
+
+std::vector<std::vector<size_t>> CommandGraph::parallel_levels() const {
+    std::vector<std::vector<size_t>> groups(depth_);
+    for (size_t node = 0; node < size(); ++node) {
+        groups[levels_[node]].push_back(node);
+    }
+    return groups;
+}
+
+bool CommandGraph::is_legal_order(const std::vector<size_t>& order) const {
+    if (order.size() != size()) {
+        return false;
+    }
+    std::vector<size_t> position(size(), kNoNode);
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (order[i] >= size() || position[order[i]] != kNoNode) {
+            return false;
+        }
+        position[order[i]] = i;
+    }
+    for (size_t node = 0; node < size(); ++node) {
+        for (size_t pred : predecessors_[node]) {
+            if (position[pred] > position[node]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<size_t> CommandGraph::topological_order(const std::vector<uint32_t>& priority) const {
+    if (!priority.empty() && priority.size() != size()) {
+        throw std::runtime_error("Priority needs one entry per node");
+    }
+
+    // Highest priority first, then lowest node index
+    auto later = [&](size_t a, size_t b) {
+        uint32_t pa = priority.empty() ? 0 : priority[a];
+        uint32_t pb = priority.empty() ? 0 : priority[b];
+        return pa != pb ? pa < pb : a > b;
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(later)> ready(later);
+
+    std::vector<size_t> remaining(size());
+    for (size_t node = 0; node < size(); ++node) {
+        remaining[node] = predecessors_[node].size();
+        if (remaining[node] == 0) {
+            ready.push(node);
+        }
+    }
+
+    std::vector<size_t> order;
+    order.reserve(size());
+    while (!ready.empty()) {
+        size_t node = ready.top();
+        ready.pop();
+        order.push_back(node);
+        for (size_t next : successors_[node]) {
+            if (--remaining[next] == 0) {
+                ready.push(next);
+            }
+        }
+    }
+    return order;
+}
+
+} // namespace app
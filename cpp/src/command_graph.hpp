@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "application.hpp"
+#include "bird.hpp"
+
+namespace app {
+
+// Address space a command block reads or writes
+enum class AccessSpace : uint8_t {
+    APB,      // Registers behind the APB networks
+    MSS,      // MSS memory
+    VCORE,    // Program and data memory of the vcores
+    BRIDGE    // Bridge selecting a network; one resource per network
+};
+
+// Scope of accesses outside any kernel block; overlaps every kernel's scope
+constexpr size_t kGlobalScope = std::numeric_limits<size_t>::max();
+
+// Half-open range [begin, end) of one address space. Kernel blocks address
+// the locations of their own deployment, so ranges only overlap within the
+// same scope, or when one of them is global. Binary loads reach every kernel
+// on the load network, so they are global.
+struct AddressRange {
+    AccessSpace space;
+    size_t scope;
+    uint64_t begin;
+    uint64_t end;
+};
+
+// What a command block reads and writes
+struct AccessSet {
+    std::vector<AddressRange> reads;
+    std::vector<AddressRange> writes;
+    bool barrier = false;      // Orders against every other block
+    bool idempotent = false;   // Writes store what earlier writes stored, so readers need not finish first
+};
+
+/**
+ * @brief Accesses of one stitched sequence
+ *
+ * Writes cover the destination of every command, adjacent ranges merged.
+ * A sequence reads the bridge of its network, which a network switch
+ * writes. Every switch to a network writes the same bridge settings, so
+ * switches are idempotent: sequences wait for the switch before them, but
+ * a later switch does not wait for them. A sequence holding a SAFE_SINGLE
+ * is a barrier; the safe write closing a network switch only orders that
+ * switch's bridge.
+ *
+ * @param build Build the sequence belongs to
+ * @param sequence Index into build.sequences
+ */
+AccessSet sequence_accesses(const BuildResult& build, size_t sequence);
+
+/**
+ * @brief Dependency DAG over the stitched sequences of a build
+ *
+ * Node i is build.sequences[i]. An edge p -> i means p must complete
+ * before i starts: i writes what p wrote, i reads what p wrote, i writes
+ * what p read (unless i is idempotent), or one of them is a barrier. Any
+ * topological order loads the same state as the stitched order.
+ *
+ * Construction walks the sequences once, keeping the last writer and the
+ * readers since of every address range in an interval map; a barrier
+ * clears the maps, as it already orders everything before it.
+ */
+class CommandGraph {
+public:
+    /**
+     * @brief Build the graph of a build's stitched sequences
+     */
+    static CommandGraph build(const BuildResult& build);
+
+    size_t size() const { return predecessors_.size(); }
+    size_t edge_count() const { return edge_count_; }
+
+    // Nodes that must complete first, ascending
+    const std::vector<size_t>& predecessors(size_t node) const { return predecessors_.at(node); }
+    // Nodes waiting for this one, ascending
+    const std::vector<size_t>& successors(size_t node) const { return successors_.at(node); }
+
+    /**
+     * @brief Length of the longest dependency chain ending at a node, minus one
+     *
+     * Nodes on the same level never depend on each other.
+     */
+    size_t level(size_t node) const { return levels_.at(node); }
+
+    // Number of levels: the critical path length in nodes
+    size_t depth() const { return depth_; }
+
+    /**
+     * @brief Nodes grouped by level; each group can be loaded in parallel
+     *        once the previous groups are done
+     */
+    std::vector<std::vector<size_t>> parallel_levels() const;
+
+    /**
+     * @brief Check that an order lists every node once, after its predecessors
+     */
+    bool is_legal_order(const std::vector<size_t>& order) const;
+
+    /**
+     * @brief Legal order that starts the highest priority ready node first
+     *
+     * @param priority Per-node priority, higher first; ties and an empty
+     *        vector keep the stitched order
+     * @throw std::runtime_error if priority is neither empty nor one per node
+     */
+    std::vector<size_t> topological_order(const std::vector<uint32_t>& priority = {}) const;
+
+private:
+    std::vector<std::vector<size_t>> predecessors_;
+    std::vector<std::vector<size_t>> successors_;
+    std::vector<size_t> levels_;
+    size_t edge_count_ = 0;
+    size_t depth_ = 0;
+};
+
+} // namespace app
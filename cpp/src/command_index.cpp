@@ -0,0 +1,215 @@
+#include "command_index.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace app {
+
+namespace {
+
+constexpr size_t kRecordSize = 24;
+constexpr uint32_t kIndexMagic = 0x58444943;   // "CIDX"
+
+uint32_t read_uint32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) |
+           (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) |
+           (static_cast<uint32_t>(in[3]) << 24);
+}
+
+uint64_t read_uint64(const uint8_t* in) {
+    return static_cast<uint64_t>(read_uint32(in)) | (static_cast<uint64_t>(read_uint32(in + 4)) << 32);
+}
+
+void append_uint32(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 24));
+}
+
+void append_uint64(std::vector<uint8_t>& out, uint64_t value) {
+    append_uint32(out, static_cast<uint32_t>(value));
+    append_uint32(out, static_cast<uint32_t>(value >> 32));
+}
+
+} // namespace
+
+const char* command_type_name(CommandType type) {
+    switch (type) {
+        case CommandType::APB_WRITE: return "APB_WRITE";
+        case CommandType::VRD_INFO: return "VRD_INFO";
+        case CommandType::PM_BINARY: return "PM_BINARY";
+        case CommandType::DMA_WRITE: return "DMA_WRITE";
+        case CommandType::SAFE_APB_WRITE: return "SAFE_APB_WRITE";
+        case CommandType::IMAGE_CHECKSUM: return "IMAGE_CHECKSUM";
+        case CommandType::CHECKPOINT: return "CHECKPOINT";
+        case CommandType::FENCE_SIGNAL: return "FENCE_SIGNAL";
+        case CommandType::FENCE_WAIT: return "FENCE_WAIT";
+    }
+    return "UNKNOWN";
+}
+
+CommandIndex CommandIndex::build(const uint8_t* data, size_t size) {
+    CommandIndex index;
+
+    size_t pos = 0;
+    while (pos < size) {
+        if (size - pos < 5) {
+            throw std::runtime_error("Truncated command header at offset " + std::to_string(pos));
+        }
+        CommandType type = static_cast<CommandType>(data[pos]);
+        uint32_t length = read_uint32(data + pos + 1);
+        if (size - pos - 5 < length) {
+            throw std::runtime_error("Command at offset " + std::to_string(pos) + " runs past the end");
+        }
+
+        const uint8_t* payload = data + pos + 5;
+        CommandEntry entry{pos, type, length, 0, 0};
+        switch (type) {
+            case CommandType::APB_WRITE:
+            case CommandType::SAFE_APB_WRITE:
+                if (length >= 8) {
+                    entry.dst_addr = read_uint32(payload);
+                    entry.dst_size = 4;
+                }
+                break;
+            case CommandType::DMA_WRITE:
+                if (length >= 8) {
+                    entry.dst_addr = read_uint32(payload);
+                    entry.dst_size = read_uint32(payload + 4);
+                }
+                break;
+            case CommandType::VRD_INFO:
+                // Name first, then size and destination
+                if (length >= 8) {
+                    entry.dst_size = read_uint32(payload + length - 8);
+                    entry.dst_addr = read_uint32(payload + length - 4);
+                }
+                break;
+            default:
+                break;
+        }
+        index.add(entry);
+        pos += entry.size();
+    }
+
+    index.finish(size);
+    return index;
+}
+
+void CommandIndex::add(const CommandEntry& entry) {
+    entries_.push_back(entry);
+}
+
+void CommandIndex::finish(size_t sequence_size) {
+    sequence_size_ = sequence_size;
+
+    by_address_.clear();
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        if (entries_[i].dst_size > 0) {
+            by_address_.push_back(i);
+        }
+    }
+    std::stable_sort(by_address_.begin(), by_address_.end(), [this](size_t a, size_t b) {
+        return entries_[a].dst_addr < entries_[b].dst_addr;
+    });
+
+    max_end_.resize(by_address_.size());
+    uint64_t max_end = 0;
+    for (size_t i = 0; i < by_address_.size(); ++i) {
+        max_end = std::max(max_end, entries_[by_address_[i]].dst_end());
+        max_end_[i] = max_end;
+    }
+}
+
+const CommandEntry& CommandIndex::at(size_t ordinal) const {
+    if (ordinal >= entries_.size()) {
+        throw std::out_of_range("Command " + std::to_string(ordinal) + " out of range");
+    }
+    return entries_[ordinal];
+}
+
+size_t CommandIndex::ordinal_at_offset(uint64_t offset) const {
+    if (offset >= sequence_size_ || entries_.empty()) {
+        throw std::out_of_range("Offset " + std::to_string(offset) + " out of range");
+    }
+    auto it = std::upper_bound(entries_.begin(), entries_.end(), offset,
+                               [](uint64_t value, const CommandEntry& entry) { return value < entry.offset; });
+    return static_cast<size_t>(it - entries_.begin()) - 1;
+}
+
+std::pair<uint64_t, uint64_t> CommandIndex::byte_range(size_t first, size_t last) const {
+    if (first > last || last > entries_.size()) {
+        throw std::out_of_range("Invalid command range");
+    }
+    uint64_t begin = first < entries_.size() ? entries_[first].offset : sequence_size_;
+    uint64_t end = last < entries_.size() ? entries_[last].offset : sequence_size_;
+    return {begin, end};
+}
+
+std::vector<size_t> CommandIndex::find_writes(uint64_t begin, uint64_t end) const {
+    std::vector<size_t> ordinals;
+    if (begin >= end) {
+        return ordinals;
+    }
+
+    // Candidates start below end; walking down, stop once no earlier
+    // command can reach past begin
+    auto upper = std::partition_point(by_address_.begin(), by_address_.end(), [&](size_t ordinal) {
+        return entries_[ordinal].dst_addr < end;
+    });
+    for (size_t i = static_cast<size_t>(upper - by_address_.begin()); i > 0 && max_end_[i - 1] > begin; --i) {
+        const CommandEntry& entry = entries_[by_address_[i - 1]];
+        if (entry.dst_end() > begin) {
+            ordinals.push_back(by_address_[i - 1]);
+        }
+    }
+
+    std::sort(ordinals.begin(), ordinals.end());
+    return ordinals;
+}
+
+std::vector<uint8_t> CommandIndex::serialize() const {
+    std::vector<uint8_t> out;
+    out.reserve(16 + entries_.size() * kRecordSize);
+    append_uint32(out, kIndexMagic);
+    append_uint32(out, static_cast<uint32_t>(entries_.size()));
+    append_uint64(out, sequence_size_);
+    for (const auto& entry : entries_) {
+        append_uint64(out, entry.offset);
+        append_uint32(out, static_cast<uint32_t>(entry.type));
+        append_uint32(out, entry.length);
+        append_uint32(out, entry.dst_addr);
+        append_uint32(out, entry.dst_size);
+    }
+    return out;
+}
+
+CommandIndex CommandIndex::deserialize(const std::vector<uint8_t>& data) {
+    if (data.size() < 16 || read_uint32(data.data()) != kIndexMagic) {
+        throw std::runtime_error("Not a command index");
+    }
+    size_t count = read_uint32(data.data() + 4);
+    if (data.size() != 16 + count * kRecordSize) {
+        throw std::runtime_error("Command index size does not match its entry count");
+    }
+
+    CommandIndex index;
+    index.entries_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* record = data.data() + 16 + i * kRecordSize;
+        index.add(CommandEntry{
+            read_uint64(record),
+            static_cast<CommandType>(read_uint32(record + 8)),
+            read_uint32(record + 12),
+            read_uint32(record + 16),
+            read_uint32(record + 20)
+        });
+    }
+    index.finish(static_cast<size_t>(read_uint64(data.data() + 8)));
+    return index;
+}
+
+} // namespace app
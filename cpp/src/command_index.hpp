@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "app_initializer.hpp"
+
+namespace app {
+
+// Position and destination of one command in a binary or initialization sequence
+struct CommandEntry {
+    uint64_t offset;       // Byte offset of the command type
+    CommandType type;
+    uint32_t length;       // Payload length, without the 5-byte header
+    uint32_t dst_addr;     // First address written, 0 if the command writes nothing
+    uint32_t dst_size;     // Bytes written at dst_addr, 0 if the command writes nothing
+
+    size_t size() const { return 5 + static_cast<size_t>(length); }
+    uint64_t dst_end() const { return static_cast<uint64_t>(dst_addr) + dst_size; }
+};
+
+// Name of a command type, e.g. "DMA_WRITE", or "UNKNOWN"
+const char* command_type_name(CommandType type);
+
+/**
+ * @brief Side index of the commands in a sequence
+ *
+ * Gives random access by ordinal, byte offset and destination address, so
+ * tools can seek into huge images, replay part of them or find every
+ * command touching a register range without walking the sequence. The
+ * index can be built by scanning a sequence or emitted by
+ * AppInitializer::write_init_sequence while generating.
+ */
+class CommandIndex {
+public:
+    CommandIndex() = default;
+
+    /**
+     * @brief Index a sequence by walking its command headers
+     *
+     * @throw std::runtime_error if a command runs past the end of the data
+     */
+    static CommandIndex build(const uint8_t* data, size_t size);
+
+    size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+    const CommandEntry& operator[](size_t ordinal) const { return entries_[ordinal]; }
+    const std::vector<CommandEntry>& entries() const { return entries_; }
+
+    // Size of the indexed sequence in bytes
+    size_t sequence_size() const { return sequence_size_; }
+
+    /**
+     * @brief Command by ordinal
+     *
+     * @throw std::out_of_range if there is no such command
+     */
+    const CommandEntry& at(size_t ordinal) const;
+
+    /**
+     * @brief Ordinal of the command containing a byte offset
+     *
+     * @throw std::out_of_range if the offset is past the end of the sequence
+     */
+    size_t ordinal_at_offset(uint64_t offset) const;
+
+    /**
+     * @brief Byte range [begin, end) covering commands [first, last)
+     *
+     * @throw std::out_of_range if the ordinals are invalid
+     */
+    std::pair<uint64_t, uint64_t> byte_range(size_t first, size_t last) const;
+
+    /**
+     * @brief Ordinals of all commands writing into [begin, end), in sequence order
+     */
+    std::vector<size_t> find_writes(uint64_t begin, uint64_t end) const;
+
+    /**
+     * @brief Append a command; entries must be added in sequence order
+     */
+    void add(const CommandEntry& entry);
+
+    /**
+     * @brief Complete an index filled with add and prepare address lookups
+     *
+     * @param sequence_size Size of the indexed sequence in bytes
+     */
+    void finish(size_t sequence_size);
+
+    /**
+     * @brief Fixed-size little endian records, 24 bytes per command
+     */
+    std::vector<uint8_t> serialize() const;
+
+    /**
+     * @throw std::runtime_error if the data is not a serialized index
+     */
+    static CommandIndex deserialize(const std::vector<uint8_t>& data);
+
+private:
+    std::vector<CommandEntry> entries_;
+    size_t sequence_size_ = 0;
+
+    // Writing commands sorted by dst_addr, with the running maximum of
+    // their end addresses, for interval queries
+    std::vector<size_t> by_address_;
+    std::vector<uint64_t> max_end_;
+};
+
+} // namespace app
@@ -0,0 +1,101 @@
+#include "compile_cache.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+
+namespace app {
+
+FileStamp file_stamp(const std::string& path) {
+    std::error_code error;
+    auto mtime = std::filesystem::last_write_time(path, error);
+    if (error) {
+        throw std::runtime_error("Failed to stat file: " + path);
+    }
+    auto size = std::filesystem::file_size(path, error);
+    if (error) {
+        throw std::runtime_error("Failed to stat file: " + path);
+    }
+    return FileStamp{
+        static_cast<int64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count()),
+        static_cast<uint64_t>(size)
+    };
+}
+
+CompileCache::CompileCache(size_t max_templates, size_t max_apb_settings)
+    : max_templates_(max_templates),
+      apb_memo_(max_apb_settings) {}
+
+std::shared_ptr<const KernelImage> CompileCache::image(const std::string& path) {
+    FileStamp stamp = file_stamp(path);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = images_.find(path);
+        if (it != images_.end() && it->second.stamp == stamp) {
+            ++stats_.image_hits;
+            return it->second.image;
+        }
+        ++stats_.image_misses;
+    }
+
+    // Decode outside the lock so different binaries decode concurrently
+    auto image = std::make_shared<const KernelImage>(KernelImage::from_file(path));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    images_[path] = ImageEntry{stamp, image};
+    return image;
+}
+
+std::shared_ptr<const CompiledTemplate> CompileCache::find_template(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = templates_.find(key);
+    if (it == templates_.end()) {
+        ++stats_.template_misses;
+        return nullptr;
+    }
+    ++stats_.template_hits;
+    return it->second;
+}
+
+std::shared_ptr<const CompiledTemplate> CompileCache::store_template(
+    const std::string& key, std::shared_ptr<const CompiledTemplate> compiled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto inserted = templates_.emplace(key, std::move(compiled));
+    auto cached = inserted.first->second;
+    if (inserted.second) {
+        template_order_.push_back(key);
+        while (templates_.size() > max_templates_ && !template_order_.empty()) {
+            templates_.erase(template_order_.front());
+            template_order_.pop_front();
+        }
+    }
+    return cached;
+}
+
+CompileCacheStats CompileCache::stats() const {
+    CompileCacheStats stats;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats = stats_;
+    }
+    stats.apb_hits = apb_memo_.hits();
+    stats.apb_misses = apb_memo_.misses();
+    stats.apb_entries = apb_memo_.size();
+    stats.apb_evictions = apb_memo_.evictions();
+    return stats;
+}
+
+void CompileCache::clear() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        images_.clear();
+        templates_.clear();
+        template_order_.clear();
+        stats_ = CompileCacheStats();
+    }
+    apb_memo_.clear();
+}
+
+} // namespace app
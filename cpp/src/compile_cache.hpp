@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "apb_memo.hpp"
+#include "app_initializer.hpp"
+#include "application.hpp"
+#include "kernel_image.hpp"
+
+namespace app {
+
+// Modification time and size of a file, used to detect stale cache entries
+struct FileStamp {
+    int64_t mtime_ns;
+    uint64_t size;
+
+    bool operator==(const FileStamp& other) const {
+        return mtime_ns == other.mtime_ns && size == other.size;
+    }
+    bool operator!=(const FileStamp& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Read the stamp of a file
+ *
+ * @throw std::runtime_error if the file does not exist
+ */
+FileStamp file_stamp(const std::string& path);
+
+// Application built up to the template, ready for VRD binding
+struct CompiledTemplate {
+    std::vector<uint8_t> template_sequence;
+    BuildResult build;
+    AppInitializer initializer;   // Parsed template, copied for every binding
+};
+
+// Hit and miss counters of a CompileCache
+struct CompileCacheStats {
+    size_t image_hits = 0;
+    size_t image_misses = 0;
+    size_t apb_hits = 0;
+    size_t apb_misses = 0;
+    size_t apb_entries = 0;       // APB settings held by the memo
+    size_t apb_evictions = 0;
+    size_t template_hits = 0;
+    size_t template_misses = 0;
+};
+
+/**
+ * @brief Thread-safe caches shared by compilations
+ *
+ * Holds decoded kernel images (revalidated against the file stamp on every
+ * lookup), the APB memo and built templates, so a long-running compiler
+ * only redoes the work whose inputs changed.
+ */
+class CompileCache {
+public:
+    /**
+     * @param max_templates Number of templates kept; the oldest is dropped first
+     * @param max_apb_settings Number of kernel APB settings kept; the least recently used is dropped first
+     */
+    explicit CompileCache(size_t max_templates = 64, size_t max_apb_settings = 1024);
+
+    /**
+     * @brief Decoded image of a kernel binary, decoded again if the file changed
+     *
+     * @throw std::runtime_error if the file cannot be read
+     */
+    std::shared_ptr<const KernelImage> image(const std::string& path);
+
+    /**
+     * @brief Look up a template by key
+     *
+     * @return Null if the template is not cached
+     */
+    std::shared_ptr<const CompiledTemplate> find_template(const std::string& key);
+
+    /**
+     * @brief Store a template, keeping the existing entry if another thread won the race
+     *
+     * @return The cached template for the key
+     */
+    std::shared_ptr<const CompiledTemplate> store_template(const std::string& key,
+                                                           std::shared_ptr<const CompiledTemplate> compiled);
+
+    ApbMemo& apb_memo() { return apb_memo_; }
+
+    CompileCacheStats stats() const;
+    void clear();
+
+private:
+    struct ImageEntry {
+        FileStamp stamp;
+        std::shared_ptr<const KernelImage> image;
+    };
+
+    size_t max_templates_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, ImageEntry> images_;
+    std::unordered_map<std::string, std::shared_ptr<const CompiledTemplate>> templates_;
+    std::deque<std::string> template_order_;   // Insertion order for eviction
+    ApbMemo apb_memo_;
+    CompileCacheStats stats_;
+};
+
+} // namespace app
@@ -0,0 +1,388 @@
+#include "compile_server.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "parallel.hpp"
+
+namespace app {
+
+namespace {
+
+constexpr size_t kMaxRequestSize = 64 * 1024;
+
+std::runtime_error system_error(const std::string& what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+sockaddr_un make_address(const std::string& socket_path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path too long: " + socket_path);
+    }
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+    return address;
+}
+
+void send_all(int fd, const void* data, size_t length) {
+    const char* bytes = static_cast<const char*>(data);
+    while (length > 0) {
+        ssize_t n = ::send(fd, bytes, length, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw system_error("Failed to send");
+        }
+        bytes += n;
+        length -= static_cast<size_t>(n);
+    }
+}
+
+void recv_all(int fd, void* data, size_t length) {
+    char* bytes = static_cast<char*>(data);
+    while (length > 0) {
+        ssize_t n = ::recv(fd, bytes, length, 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw system_error("Failed to receive");
+        }
+        if (n == 0) {
+            throw std::runtime_error("Connection closed");
+        }
+        bytes += n;
+        length -= static_cast<size_t>(n);
+    }
+}
+
+void encode_uint32(uint8_t* out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+    out[2] = static_cast<uint8_t>(value >> 16);
+    out[3] = static_cast<uint8_t>(value >> 24);
+}
+
+uint32_t decode_uint32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) |
+           (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) |
+           (static_cast<uint32_t>(in[3]) << 24);
+}
+
+// Response header, with the image descriptor attached if there is one
+void send_response(int fd, bool ok, const std::string& message, int image_fd) {
+    uint8_t header[5];
+    header[0] = ok ? 0 : 1;
+    encode_uint32(header + 1, static_cast<uint32_t>(message.size()));
+
+    iovec iov{header, sizeof(header)};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    if (image_fd >= 0) {
+        std::memset(control, 0, sizeof(control));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(cmsg), &image_fd, sizeof(int));
+    }
+
+    ssize_t n;
+    do {
+        n = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        throw system_error("Failed to send response");
+    }
+    if (static_cast<size_t>(n) < sizeof(header)) {
+        send_all(fd, header + n, sizeof(header) - static_cast<size_t>(n));
+    }
+    send_all(fd, message.data(), message.size());
+}
+
+uint32_t parse_uint32(const std::string& key, const std::string& value) {
+    if (value.empty() || value.size() > 10 || value.find_first_not_of("0123456789") != std::string::npos ||
+        std::stoull(value) > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("Invalid value for request field " + key + ": " + value);
+    }
+    return static_cast<uint32_t>(std::stoull(value));
+}
+
+std::string format_request(const CompileRequest& request) {
+    std::ostringstream text;
+    text << "manifest " << request.manifest_path << '\n'
+         << "threads " << request.num_threads << '\n'
+         << "dedup " << (request.deduplicate_binaries ? 1 : 0) << '\n'
+         << "prioritize " << (request.prioritize ? 1 : 0) << '\n'
+         << "trailer " << (request.checksum_trailer ? 1 : 0) << '\n';
+    if (!request.target.empty()) {
+        text << "target " << request.target << '\n';
+    }
+    if (request.dma.max_burst) {
+        text << "dma_burst " << *request.dma.max_burst << '\n';
+    }
+    if (request.dma.alignment) {
+        text << "dma_align " << *request.dma.alignment << '\n';
+    }
+    if (request.dma.pad) {
+        text << "dma_pad 1\n";
+    }
+    return text.str();
+}
+
+CompileRequest parse_request(const std::string& text) {
+    CompileRequest request;
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        size_t space = line.find(' ');
+        std::string key = line.substr(0, space);
+        std::string value = space == std::string::npos ? "" : line.substr(space + 1);
+        if (key == "manifest") {
+            request.manifest_path = value;
+        } else if (key == "threads") {
+            request.num_threads = std::stoul(value);
+        } else if (key == "dedup") {
+            request.deduplicate_binaries = value != "0";
+        } else if (key == "prioritize") {
+            request.prioritize = value != "0";
+        } else if (key == "trailer") {
+            request.checksum_trailer = value != "0";
+        } else if (key == "target") {
+            request.target = value;
+        } else if (key == "dma_burst") {
+            request.dma.max_burst = parse_uint32(key, value);
+        } else if (key == "dma_align") {
+            request.dma.alignment = parse_uint32(key, value);
+        } else if (key == "dma_pad") {
+            request.dma.pad = value != "0";
+        } else if (!key.empty()) {
+            throw std::runtime_error("Unknown request field: " + key);
+        }
+    }
+    if (request.manifest_path.empty()) {
+        throw std::runtime_error("Request without manifest");
+    }
+    return request;
+}
+
+} // namespace
+
+CompileServer::CompileServer(std::string socket_path, std::shared_ptr<CompileCache> cache, size_t num_workers)
+    : socket_path_(std::move(socket_path)),
+      cache_(cache ? std::move(cache) : std::make_shared<CompileCache>()),
+      num_workers_(resolve_thread_count(num_workers, static_cast<size_t>(-1))) {}
+
+CompileServer::~CompileServer() {
+    stop();
+}
+
+void CompileServer::start() {
+    sockaddr_un address = make_address(socket_path_);
+
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        throw system_error("Failed to create socket");
+    }
+    ::unlink(socket_path_.c_str());
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        ::listen(listen_fd_, SOMAXCONN) < 0) {
+        auto error = system_error("Failed to listen on " + socket_path_);
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        throw error;
+    }
+
+    stopping_ = false;
+    for (size_t i = 0; i < num_workers_; ++i) {
+        workers_.emplace_back(&CompileServer::worker_loop, this);
+    }
+    accept_thread_ = std::thread(&CompileServer::accept_loop, this);
+}
+
+void CompileServer::stop() {
+    if (listen_fd_ < 0) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        stopping_ = true;
+    }
+    // Shutting the socket down wakes the blocked accept
+    ::shutdown(listen_fd_, SHUT_RDWR);
+    accept_thread_.join();
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+
+    queue_cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    ::unlink(socket_path_.c_str());
+}
+
+void CompileServer::accept_loop() {
+    while (!stopping_) {
+        int client_fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            pending_clients_.push_back(client_fd);
+        }
+        queue_cv_.notify_one();
+    }
+}
+
+void CompileServer::worker_loop() {
+    for (;;) {
+        int client_fd;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            queue_cv_.wait(lock, [this] { return stopping_ || !pending_clients_.empty(); });
+            if (pending_clients_.empty()) {
+                return;
+            }
+            client_fd = pending_clients_.front();
+            pending_clients_.pop_front();
+        }
+        serve_client(client_fd);
+        ::close(client_fd);
+    }
+}
+
+void CompileServer::serve_client(int client_fd) {
+    try {
+        uint8_t length_bytes[4];
+        recv_all(client_fd, length_bytes, sizeof(length_bytes));
+        uint32_t length = decode_uint32(length_bytes);
+        if (length > kMaxRequestSize) {
+            send_response(client_fd, false, "Request too large", -1);
+            return;
+        }
+        std::string text(length, '\0');
+        recv_all(client_fd, &text[0], length);
+
+        try {
+            CompileRequest request = parse_request(text);
+            CompileOptions options;
+            options.build.num_threads = request.num_threads;
+            options.build.deduplicate_binaries = request.deduplicate_binaries;
+            options.build.prioritize = request.prioritize;
+            options.generate.checksum_trailer = request.checksum_trailer;
+            options.dma = request.dma;
+
+            AppCompiler compiler(cache_);
+            CompileResult result;
+            auto manifest = load_manifest(request.manifest_path);
+            if (!request.target.empty()) {
+                manifest.target = request.target;
+            }
+            SharedImage image;
+            if (dma_rules_for(manifest, options.dma)) {
+                result = compiler.compile(manifest, options);
+                image = SharedImage::create(result.init_sequence, ++generation_);
+            } else {
+                auto initializer = compiler.bind(manifest, options.build, &result);
+                image = SharedImage::generate(initializer, ++generation_, options.generate);
+            }
+
+            std::string summary = "generation " + std::to_string(image.generation()) +
+                                  ", template " + (result.template_cached ? "cached" : "built") +
+                                  ", " + std::to_string(image.size()) + " bytes";
+            send_response(client_fd, true, summary, image.fd());
+        } catch (const std::exception& e) {
+            send_response(client_fd, false, e.what(), -1);
+        }
+    } catch (const std::exception&) {
+        // Client went away; nothing left to report to
+    }
+}
+
+CompileResponse request_compile(const std::string& socket_path, const CompileRequest& request) {
+    sockaddr_un address = make_address(socket_path);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw system_error("Failed to create socket");
+    }
+
+    CompileResponse response;
+    try {
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+            throw system_error("Failed to connect to " + socket_path);
+        }
+
+        std::string text = format_request(request);
+        uint8_t length_bytes[4];
+        encode_uint32(length_bytes, static_cast<uint32_t>(text.size()));
+        send_all(fd, length_bytes, sizeof(length_bytes));
+        send_all(fd, text.data(), text.size());
+
+        uint8_t header[5];
+        iovec iov{header, sizeof(header)};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        ssize_t n;
+        do {
+            n = ::recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+        } while (n < 0 && errno == EINTR);
+        if (n < 0) {
+            throw system_error("Failed to receive response");
+        }
+        if (n == 0) {
+            throw std::runtime_error("Connection closed");
+        }
+
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+                int image_fd;
+                std::memcpy(&image_fd, CMSG_DATA(cmsg), sizeof(int));
+                response.image = SharedImage::adopt(image_fd);
+            }
+        }
+        if (static_cast<size_t>(n) < sizeof(header)) {
+            recv_all(fd, header + n, sizeof(header) - static_cast<size_t>(n));
+        }
+
+        response.ok = header[0] == 0;
+        response.message.resize(decode_uint32(header + 1));
+        recv_all(fd, &response.message[0], response.message.size());
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+
+    if (response.ok && !response.image.valid()) {
+        throw std::runtime_error("Server response carries no image");
+    }
+    return response;
+}
+
+} // namespace app
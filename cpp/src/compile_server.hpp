@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "app_compiler.hpp"
+#include "compile_cache.hpp"
+#include "shared_image.hpp"
+
+namespace app {
+
+// Compile job sent to a CompileServer
+struct CompileRequest {
+    std::string manifest_path;          // Resolved by the server, so preferably absolute
+    size_t num_threads = 0;             // Build threads, 0 for hardware concurrency
+    bool deduplicate_binaries = true;
+    bool prioritize = false;            // Load kernels by descending deployment weight
+    bool checksum_trailer = false;      // Append an IMAGE_CHECKSUM command to the image
+    std::string target;                 // Target profile overriding the manifest's, empty for none
+    DmaOptions dma;                     // DMA rules on top of the target's
+};
+
+// Answer of a CompileServer
+struct CompileResponse {
+    bool ok = false;
+    std::string message;                // Error text, or a short summary on success
+    SharedImage image;                  // Final image with header, valid if ok
+};
+
+/**
+ * @brief Local compile daemon listening on a UNIX socket
+ *
+ * Keeps decoded kernel images, APB settings and templates warm in a shared
+ * CompileCache and serves requests on a pool of worker threads. Images are
+ * generated straight into sealed memfds (see SharedImage), numbered with
+ * increasing generation ids and passed over the socket (SCM_RIGHTS). Images
+ * whose DMAs are normalized (see dma_rules_for) are normalized first and
+ * then copied into the memfd.
+ *
+ * Wire format, all integers little endian:
+ *     request:  [u32 length][text: "manifest <path>\n", "threads <n>\n", "dedup 0|1\n", "trailer 0|1\n",
+ *               "prioritize 0|1\n", optional "target <name|path>\n", "dma_burst <n>\n",
+ *               "dma_align <n>\n", "dma_pad 0|1\n"]
+ *     response: [u8 status (0 = ok)][u32 length][message], memfd attached on success
+ */
+class CompileServer {
+public:
+    /**
+     * @param socket_path Filesystem path of the listening socket
+     * @param cache Cache to serve from, a new one if null
+     * @param num_workers Worker threads, 0 for hardware concurrency
+     */
+    CompileServer(std::string socket_path, std::shared_ptr<CompileCache> cache = nullptr, size_t num_workers = 0);
+    ~CompileServer();
+
+    CompileServer(const CompileServer&) = delete;
+    CompileServer& operator=(const CompileServer&) = delete;
+
+    /**
+     * @brief Bind the socket and start serving in the background
+     *
+     * A stale socket file left behind by a previous server is replaced.
+     *
+     * @throw std::runtime_error if the socket cannot be bound
+     */
+    void start();
+
+    /**
+     * @brief Stop accepting, finish queued requests and remove the socket file
+     */
+    void stop();
+
+    const std::string& socket_path() const { return socket_path_; }
+    const std::shared_ptr<CompileCache>& cache() const { return cache_; }
+
+private:
+    std::string socket_path_;
+    std::shared_ptr<CompileCache> cache_;
+    size_t num_workers_;
+    int listen_fd_ = -1;
+    std::atomic<bool> stopping_{false};
+    std::atomic<uint64_t> generation_{0};   // Id of the last image served
+
+    std::thread accept_thread_;
+    std::vector<std::thread> workers_;
+    std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::deque<int> pending_clients_;
+
+    void accept_loop();
+    void worker_loop();
+    void serve_client(int client_fd);
+};
+
+/**
+ * @brief Send a compile request to a running server and wait for the answer
+ *
+ * @throw std::runtime_error if the server cannot be reached or the
+ *        connection breaks; compile errors are returned in the response
+ */
+CompileResponse request_compile(const std::string& socket_path, const CompileRequest& request);
+
+} // namespace app
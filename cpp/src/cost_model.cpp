@@ -0,0 +1,182 @@
+#include "cost_model.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace app {
+
+namespace {
+
+constexpr size_t kNone = std::numeric_limits<size_t>::max();
+
+LoadCost& network_cost(LoadEstimate& estimate, const NetworkType& network) {
+    for (auto& entry : estimate.by_network) {
+        if (entry.first == network) {
+            return entry.second;
+        }
+    }
+    estimate.by_network.emplace_back(network, LoadCost());
+    return estimate.by_network.back().second;
+}
+
+} // namespace
+
+CostModel::CostModel(const TargetProfile& profile)
+    : profile_(profile) {
+    profile_.validate();
+}
+
+uint64_t CostModel::transfer_ns(uint64_t bytes, uint32_t mbps) const {
+    // MB/s are bytes per microsecond; round up to whole nanoseconds
+    return (bytes * 1000 + mbps - 1) / mbps;
+}
+
+uint64_t CostModel::command_ns(const CommandEntry& entry) const {
+    uint64_t ns = profile_.command_overhead_ns;
+    switch (entry.type) {
+        case CommandType::APB_WRITE:
+            return ns + transfer_ns(entry.size(), profile_.link_mbps) + profile_.apb_write_ns;
+        case CommandType::SAFE_APB_WRITE:
+            return ns + transfer_ns(entry.size(), profile_.link_mbps) + profile_.apb_write_ns +
+                   profile_.safe_write_ns;
+        case CommandType::DMA_WRITE:
+        case CommandType::PM_BINARY: {
+            uint64_t payload = entry.type == CommandType::DMA_WRITE ? entry.dst_size : entry.length;
+            uint64_t header = entry.size() - payload;
+            return ns + transfer_ns(header, profile_.link_mbps) +
+                   std::max(transfer_ns(payload, profile_.link_mbps), transfer_ns(payload, profile_.dma_mbps));
+        }
+        default:
+            return ns + transfer_ns(entry.size(), profile_.link_mbps);
+    }
+}
+
+LoadEstimate CostModel::estimate(const uint8_t* data, size_t size) const {
+    LoadEstimate estimate;
+    CommandIndex index = CommandIndex::build(data, size);
+    for (const auto& entry : index.entries()) {
+        uint64_t ns = command_ns(entry);
+        estimate.total.add(ns, entry.size());
+        estimate.by_type[entry.type].add(ns, entry.size());
+    }
+    return estimate;
+}
+
+LoadEstimate CostModel::estimate(const BuildResult& build, const uint8_t* data, size_t size) const {
+    return estimate_attributed(build, data, size, nullptr);
+}
+
+LoadEstimate CostModel::estimate(const BuildResult& build, const uint8_t* data, size_t size,
+                                 const NormalizedImage& normalized) const {
+    return estimate_attributed(build, data, size, &normalized);
+}
+
+LoadEstimate CostModel::estimate_attributed(const BuildResult& build, const uint8_t* data, size_t size,
+                                            const NormalizedImage* normalized) const {
+    // Build sequence of every source command, skipping the ones the
+    // generator adds
+    CommandIndex source = CommandIndex::build(data, size);
+    std::vector<size_t> sequence_end(build.sequences.size());
+    size_t command_count = 0;
+    for (size_t q = 0; q < build.sequences.size(); ++q) {
+        command_count += build.sequences[q].commands.size();
+        sequence_end[q] = command_count;
+    }
+    std::vector<size_t> source_sequence(source.size(), kNone);
+    size_t sequence = 0;
+    size_t generated = 0;
+    for (size_t i = 0; i < source.size(); ++i) {
+        CommandType type = source[i].type;
+        if (type == CommandType::CHECKPOINT || type == CommandType::IMAGE_CHECKSUM) {
+            continue;
+        }
+        while (sequence < sequence_end.size() && generated >= sequence_end[sequence]) {
+            ++sequence;
+        }
+        if (sequence == sequence_end.size()) {
+            throw std::runtime_error("Image has more commands than the build");
+        }
+        source_sequence[i] = sequence;
+        ++generated;
+    }
+    if (generated != command_count) {
+        throw std::runtime_error("Image has fewer commands than the build");
+    }
+
+    // Output commands and the source command each one belongs to
+    CommandIndex output;
+    std::vector<size_t> owner;
+    if (normalized) {
+        output = CommandIndex::build(normalized->data.data(), normalized->data.size());
+        owner.assign(output.size(), kNone);
+        size_t next = 0;
+        for (size_t i = 0; i < source.size() && i < normalized->end_command.size(); ++i) {
+            size_t end = normalized->end_command[i];
+            for (; next <= end && next < output.size(); ++next) {
+                owner[next] = i;
+            }
+            // Later members of a merged run take over the command completing them
+            if (end < output.size()) {
+                owner[end] = i;
+            }
+        }
+    } else {
+        output = std::move(source);
+        owner.resize(output.size());
+        for (size_t i = 0; i < owner.size(); ++i) {
+            owner[i] = i;
+        }
+    }
+
+    std::vector<size_t> sequence_span(build.sequences.size(), kNone);
+    for (size_t s = 0; s < build.kernel_spans.size(); ++s) {
+        for (size_t q = build.kernel_spans[s].first_sequence; q < build.kernel_spans[s].end_sequence; ++q) {
+            sequence_span[q] = s;
+        }
+    }
+    std::vector<bool> is_switch(build.sequences.size(), false);
+    for (size_t i : build.network_switches) {
+        is_switch.at(i) = true;
+    }
+
+    LoadEstimate estimate;
+    for (const auto& span : build.kernel_spans) {
+        estimate.kernels.push_back(KernelLoadCost{span.deployment, LoadCost(), 0});
+    }
+
+    for (size_t k = 0; k < output.size(); ++k) {
+        const CommandEntry& entry = output[k];
+        size_t seq = owner[k] == kNone ? kNone : source_sequence[owner[k]];
+        uint64_t ns = command_ns(entry);
+
+        // A switch settles once, after its last command
+        bool switch_command = seq != kNone && is_switch[seq];
+        bool last_of_switch = switch_command &&
+            (k + 1 == output.size() || owner[k + 1] == kNone || source_sequence[owner[k + 1]] != seq);
+        if (last_of_switch) {
+            ns += profile_.switch_ns;
+        }
+
+        estimate.total.add(ns, entry.size());
+        estimate.by_type[entry.type].add(ns, entry.size());
+        if (seq == kNone) {
+            estimate.unattributed.add(ns, entry.size());
+            continue;
+        }
+        network_cost(estimate, build.sequences[seq].network_type).add(ns, entry.size());
+        if (switch_command) {
+            estimate.switches.add(ns, entry.size());
+        }
+        if (sequence_span[seq] == kNone) {
+            estimate.setup.add(ns, entry.size());
+        } else {
+            auto& kernel = estimate.kernels[sequence_span[seq]];
+            kernel.cost.add(ns, entry.size());
+            kernel.ready_ns = estimate.total.ns;
+        }
+    }
+    return estimate;
+}
+
+} // namespace app
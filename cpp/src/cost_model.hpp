@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "application.hpp"
+#include "command_index.hpp"
+#include "dma_normalizer.hpp"
+#include "target_profile.hpp"
+
+namespace app {
+
+// Estimated cost of a group of commands
+struct LoadCost {
+    uint64_t ns = 0;
+    size_t commands = 0;
+    uint64_t bytes = 0;   // Image bytes, headers included
+
+    void add(uint64_t command_ns, uint64_t command_bytes) {
+        ns += command_ns;
+        ++commands;
+        bytes += command_bytes;
+    }
+};
+
+// Estimated cost of one deployed kernel's block
+struct KernelLoadCost {
+    size_t deployment;    // Index into the build's deployments
+    LoadCost cost;
+    uint64_t ready_ns;    // Time from the start of the load until the block is loaded
+};
+
+/**
+ * @brief Estimated load time of an image with its breakdown
+ *
+ * Without a build only the total and by_type are filled. With one, kernels,
+ * setup and unattributed partition the total; switches is the part of
+ * the kernels spent on network switches.
+ */
+struct LoadEstimate {
+    LoadCost total;
+    std::map<CommandType, LoadCost> by_type;
+    std::vector<std::pair<NetworkType, LoadCost>> by_network;   // In order of first use
+    std::vector<KernelLoadCost> kernels;                        // In load order
+    LoadCost setup;          // Grid configuration before the first kernel
+    LoadCost switches;       // Network switches, settling time included
+    LoadCost unattributed;   // Commands without a build sequence: checkpoints, trailer, fences
+};
+
+/**
+ * @brief Load time model of a target, parametrized by its TargetProfile
+ *
+ * A command costs the loader's fixed overhead plus the time its bytes take
+ * over the command link. Register writes add the APB latency, and safe
+ * writes the wait for their completion; DMA payloads stream at the slower
+ * of the link and the DMA engine. The last command of every network switch
+ * adds the bridge's settling time. Loads are assumed sequential, so
+ * estimates are upper bounds for loaders that overlap commands.
+ */
+class CostModel {
+public:
+    explicit CostModel(const TargetProfile& profile);
+
+    const TargetProfile& profile() const { return profile_; }
+
+    /**
+     * @brief Estimated time of one command, without switch settling
+     */
+    uint64_t command_ns(const CommandEntry& entry) const;
+
+    /**
+     * @brief Estimate an image by command type only, e.g. one stream of a
+     *        partitioned image
+     *
+     * @throw std::runtime_error if the image is malformed
+     */
+    LoadEstimate estimate(const uint8_t* data, size_t size) const;
+
+    /**
+     * @brief Estimate an image generated from a build, with checkpoints and
+     *        trailer if any
+     *
+     * @throw std::runtime_error if the image does not match the build
+     */
+    LoadEstimate estimate(const BuildResult& build, const uint8_t* data, size_t size) const;
+
+    /**
+     * @brief Estimate the DMA-normalized form of an image generated from a build
+     *
+     * Output commands are attributed to the source command they complete;
+     * merged DMAs count towards the last command merged.
+     *
+     * @param data Source image the normalized one was made from
+     * @throw std::runtime_error if the source does not match the build
+     */
+    LoadEstimate estimate(const BuildResult& build, const uint8_t* data, size_t size,
+                          const NormalizedImage& normalized) const;
+
+private:
+    TargetProfile profile_;
+
+    uint64_t transfer_ns(uint64_t bytes, uint32_t mbps) const;
+    LoadEstimate estimate_attributed(const BuildResult& build, const uint8_t* data, size_t size,
+                                     const NormalizedImage* normalized) const;
+};
+
+} // namespace app
@@ -0,0 +1,109 @@
+#include "crc32c.hpp"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define APP_CRC32C_SSE42 1
+#endif
+
+namespace app {
+
+namespace {
+
+constexpr uint32_t kCrc32cPolynomial = 0x82F63B78;  // Reflected Castagnoli polynomial
+
+// Slicing-by-8 tables: tables[k][b] is the CRC of byte b followed by k zero bytes
+using Crc32cTables = std::array<std::array<uint32_t, 256>, 8>;
+
+Crc32cTables make_crc32c_tables() {
+    Crc32cTables tables{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ ((crc & 1) ? kCrc32cPolynomial : 0);
+        }
+        tables[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+        for (size_t k = 1; k < tables.size(); ++k) {
+            tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xFF];
+        }
+    }
+    return tables;
+}
+
+const Crc32cTables& crc32c_tables() {
+    static const Crc32cTables tables = make_crc32c_tables();
+    return tables;
+}
+
+#ifdef APP_CRC32C_SSE42
+__attribute__((target("sse4.2")))
+uint32_t crc32c_sse42(uint32_t crc, const uint8_t* data, size_t length) {
+    uint64_t crc64 = ~crc;
+    for (; length >= 8; data += 8, length -= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    uint32_t crc32 = static_cast<uint32_t>(crc64);
+    for (; length > 0; ++data, --length) {
+        crc32 = _mm_crc32_u8(crc32, *data);
+    }
+    return ~crc32;
+}
+
+bool detect_sse42() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+}
+
+const bool kHasSse42 = detect_sse42();
+#endif
+
+} // namespace
+
+uint32_t crc32c_software(uint32_t crc, const uint8_t* data, size_t length) {
+    const Crc32cTables& tables = crc32c_tables();
+    crc = ~crc;
+    for (; length >= 8; data += 8, length -= 8) {
+        // Byte-wise load keeps this independent of alignment and endianness
+        uint32_t low = crc ^ (static_cast<uint32_t>(data[0]) |
+                              (static_cast<uint32_t>(data[1]) << 8) |
+                              (static_cast<uint32_t>(data[2]) << 16) |
+                              (static_cast<uint32_t>(data[3]) << 24));
+        crc = tables[7][low & 0xFF] ^
+              tables[6][(low >> 8) & 0xFF] ^
+              tables[5][(low >> 16) & 0xFF] ^
+              tables[4][low >> 24] ^
+              tables[3][data[4]] ^
+              tables[2][data[5]] ^
+              tables[1][data[6]] ^
+              tables[0][data[7]];
+    }
+    for (; length > 0; ++data, --length) {
+        crc = tables[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint32_t crc32c(uint32_t crc, const uint8_t* data, size_t length) {
+#ifdef APP_CRC32C_SSE42
+    if (kHasSse42) {
+        return crc32c_sse42(crc, data, length);
+    }
+#endif
+    return crc32c_software(crc, data, length);
+}
+
+bool crc32c_hardware_accelerated() {
+#ifdef APP_CRC32C_SSE42
+    return kHasSse42;
+#else
+    return false;
+#endif
+}
+
+} // namespace app
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace app {
+
+/**
+ * @brief Extend a CRC32C (Castagnoli) checksum
+ *
+ * Start with crc = 0; feeding data in pieces gives the same result as
+ * one call over the concatenation. Uses the SSE4.2 crc32 instruction when
+ * the CPU has it and a table-driven implementation otherwise.
+ *
+ * @param crc Checksum of the preceding data
+ * @param data Bytes to add
+ * @param length Number of bytes
+ * @return uint32_t Checksum including data
+ */
+uint32_t crc32c(uint32_t crc, const uint8_t* data, size_t length);
+
+/**
+ * @brief Table-driven CRC32C, the fallback of crc32c
+ */
+uint32_t crc32c_software(uint32_t crc, const uint8_t* data, size_t length);
+
+/**
+ * @brief Whether crc32c runs on the hardware instruction
+ */
+bool crc32c_hardware_accelerated();
+
+} // namespace app
@@ -0,0 +1,225 @@
+#include "dma_normalizer.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "crc32c.hpp"
+
+namespace app {
+
+namespace {
+
+void append_uint32(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 24));
+}
+
+// Writes output commands and keeps checksums and index up to date
+class CommandWriter {
+public:
+    CommandWriter(NormalizedImage& image, ImageIntegrity* integrity, CommandIndex* index)
+        : image_(image), integrity_(integrity), index_(index) {}
+
+    size_t command_count() const { return command_count_; }
+    uint32_t image_checksum() const { return image_checksum_; }
+
+    // Emit a DMA_WRITE; returns its ordinal
+    size_t dma(uint32_t dst_addr, const uint8_t* payload, size_t length) {
+        size_t start = image_.data.size();
+        image_.data.push_back(static_cast<uint8_t>(CommandType::DMA_WRITE));
+        append_uint32(image_.data, static_cast<uint32_t>(length + 8));
+        append_uint32(image_.data, dst_addr);
+        append_uint32(image_.data, static_cast<uint32_t>(length));
+        image_.data.insert(image_.data.end(), payload, payload + length);
+        ++image_.stats.output_dmas;
+        return finish(start, CommandType::DMA_WRITE, dst_addr, static_cast<uint32_t>(length));
+    }
+
+    // Copy a command unchanged; returns its ordinal
+    size_t copy(const uint8_t* data, const CommandEntry& entry) {
+        size_t start = image_.data.size();
+        image_.data.insert(image_.data.end(), data + entry.offset, data + entry.offset + entry.size());
+        return finish(start, entry.type, entry.dst_addr, entry.dst_size);
+    }
+
+    void trailer() {
+        size_t start = image_.data.size();
+        image_.data.push_back(static_cast<uint8_t>(CommandType::IMAGE_CHECKSUM));
+        append_uint32(image_.data, 8);
+        append_uint32(image_.data, static_cast<uint32_t>(command_count_));
+        append_uint32(image_.data, image_checksum_);
+        image_checksum_ = crc32c(image_checksum_, image_.data.data() + start, image_.data.size() - start);
+        if (index_) {
+            index_->add(CommandEntry{start, CommandType::IMAGE_CHECKSUM, 8, 0, 0});
+        }
+    }
+
+private:
+    NormalizedImage& image_;
+    ImageIntegrity* integrity_;
+    CommandIndex* index_;
+    size_t command_count_ = 0;
+    uint32_t image_checksum_ = 0;
+
+    size_t finish(size_t start, CommandType type, uint32_t dst_addr, uint32_t dst_size) {
+        const uint8_t* command = image_.data.data() + start;
+        size_t command_size = image_.data.size() - start;
+        image_checksum_ = crc32c(image_checksum_, command, command_size);
+        if (integrity_) {
+            integrity_->command_checksums.push_back(crc32c(0, command, command_size));
+        }
+        if (index_) {
+            index_->add(CommandEntry{start, type, static_cast<uint32_t>(command_size - 5), dst_addr, dst_size});
+        }
+        return command_count_++;
+    }
+};
+
+// Contiguous DMA data collected from back-to-back input commands
+struct DmaRun {
+    uint64_t dst = 0;
+    std::vector<uint8_t> data;
+    std::vector<std::pair<size_t, size_t>> members;   // Input command, end of its data in the run
+};
+
+void flush_run(DmaRun& run, const DmaRules& rules, CommandWriter& writer, NormalizedImage& image) {
+    if (run.members.empty()) {
+        return;
+    }
+
+    uint64_t align = rules.alignment;
+    uint64_t start = run.dst;
+    uint64_t end = run.dst + run.data.size();
+    const uint8_t* payload = run.data.data();
+
+    std::vector<uint8_t> padded;
+    if (rules.pad && (start % align != 0 || end % align != 0)) {
+        uint64_t aligned_start = start / align * align;
+        uint64_t aligned_end = (end + align - 1) / align * align;
+        padded.assign(aligned_end - aligned_start, rules.pad_byte);
+        std::copy(run.data.begin(), run.data.end(), padded.begin() + (start - aligned_start));
+        ++image.stats.padded;
+        image.stats.pad_bytes += padded.size() - run.data.size();
+        start = aligned_start;
+        end = aligned_end;
+        payload = padded.data();
+    }
+
+    // Unaligned head, aligned body in bursts, unaligned tail
+    std::vector<std::pair<uint64_t, uint64_t>> pieces;
+    uint64_t head_end = std::min(end, (start + align - 1) / align * align);
+    uint64_t tail_start = std::max(head_end, end / align * align);
+    if (head_end > start) {
+        pieces.emplace_back(start, head_end);
+    }
+    uint64_t burst = rules.max_burst > 0 ? rules.max_burst : tail_start - head_end;
+    for (uint64_t pos = head_end; pos < tail_start; pos += burst) {
+        pieces.emplace_back(pos, std::min(tail_start, pos + burst));
+    }
+    if (end > tail_start) {
+        pieces.emplace_back(tail_start, end);
+    }
+    if (pieces.empty()) {
+        pieces.emplace_back(start, end);   // Empty transfer
+    }
+    if (pieces.size() > 1) {
+        ++image.stats.split;
+    }
+
+    // Each input command is complete with the piece holding its last byte
+    size_t member = 0;
+    for (const auto& piece : pieces) {
+        size_t ordinal = writer.dma(static_cast<uint32_t>(piece.first), payload + (piece.first - start),
+                                    static_cast<size_t>(piece.second - piece.first));
+        for (; member < run.members.size() && run.dst + run.members[member].second <= piece.second; ++member) {
+            image.end_command[run.members[member].first] = ordinal;
+            image.end_offset[run.members[member].first] = image.data.size();
+        }
+    }
+    for (; member < run.members.size(); ++member) {
+        image.end_command[run.members[member].first] = writer.command_count() - 1;
+        image.end_offset[run.members[member].first] = image.data.size();
+    }
+
+    run.data.clear();
+    run.members.clear();
+}
+
+} // namespace
+
+NormalizedImage normalize_dma(const uint8_t* data, size_t size, const DmaRules& rules,
+                              ImageIntegrity* integrity, CommandIndex* index) {
+    if (rules.alignment == 0 || (rules.alignment & (rules.alignment - 1)) != 0) {
+        throw std::runtime_error("DMA alignment must be a power of two");
+    }
+    if (rules.max_burst % rules.alignment != 0) {
+        throw std::runtime_error("DMA burst must be a multiple of the alignment");
+    }
+
+    CommandIndex input = CommandIndex::build(data, size);
+    NormalizedImage image;
+    image.data.reserve(size);
+    image.end_command.resize(input.size());
+    image.end_offset.resize(input.size());
+    if (integrity) {
+        integrity->command_checksums.clear();
+    }
+    if (index) {
+        *index = CommandIndex();
+    }
+
+    CommandWriter writer(image, integrity, index);
+    DmaRun run;
+    bool has_trailer = false;
+    for (size_t i = 0; i < input.size(); ++i) {
+        const CommandEntry& entry = input[i];
+        if (entry.type == CommandType::DMA_WRITE) {
+            if (entry.length < 8 || entry.dst_size != entry.length - 8) {
+                throw std::runtime_error("Malformed DMA write at offset " + std::to_string(entry.offset));
+            }
+            ++image.stats.input_dmas;
+            bool contiguous = !run.members.empty() && run.dst + run.data.size() == entry.dst_addr;
+            if (rules.merge && contiguous) {
+                ++image.stats.merged;
+            } else {
+                flush_run(run, rules, writer, image);
+                run.dst = entry.dst_addr;
+            }
+            const uint8_t* payload = data + entry.offset + 13;
+            run.data.insert(run.data.end(), payload, payload + entry.dst_size);
+            run.members.emplace_back(i, run.data.size());
+            continue;
+        }
+
+        flush_run(run, rules, writer, image);
+        if (entry.type == CommandType::IMAGE_CHECKSUM) {
+            has_trailer = true;   // Regenerated below
+            continue;
+        }
+        image.end_command[i] = writer.copy(data, entry);
+        image.end_offset[i] = image.data.size();
+    }
+    flush_run(run, rules, writer, image);
+
+    if (has_trailer) {
+        writer.trailer();
+        for (size_t i = 0; i < input.size(); ++i) {
+            if (input[i].type == CommandType::IMAGE_CHECKSUM) {
+                image.end_command[i] = writer.command_count();
+                image.end_offset[i] = image.data.size();
+            }
+        }
+    }
+
+    if (integrity) {
+        integrity->image_checksum = writer.image_checksum();
+    }
+    if (index) {
+        index->finish(image.data.size());
+    }
+    return image;
+}
+
+} // namespace app
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "app_initializer.hpp"
+#include "command_index.hpp"
+
+namespace app {
+
+// Transfer rules of the target's DMA engine
+struct DmaRules {
+    uint32_t max_burst = 0;     // Largest DMA payload in bytes, 0 for no limit; a multiple of alignment
+    uint32_t alignment = 16;    // Destination and length alignment, a power of two; 1 to ignore
+    bool pad = false;           // Widen unaligned transfers to whole alignment units instead of
+                                // splitting off unaligned head and tail transfers
+    uint8_t pad_byte = 0;       // Fill for padding
+    bool merge = true;          // Merge back-to-back DMAs to contiguous destinations
+};
+
+// What normalize_dma changed
+struct DmaStats {
+    size_t input_dmas = 0;
+    size_t output_dmas = 0;
+    size_t merged = 0;          // Input DMAs appended to the previous one
+    size_t split = 0;           // Transfers cut into bursts or aligned pieces
+    size_t padded = 0;          // Transfers widened to alignment units
+    size_t pad_bytes = 0;
+};
+
+// Output of normalize_dma
+struct NormalizedImage {
+    std::vector<uint8_t> data;
+    DmaStats stats;
+    // Per input command: ordinal and end offset of the output command that
+    // completes it, to translate positions such as kernel ready offsets
+    std::vector<size_t> end_command;
+    std::vector<size_t> end_offset;
+};
+
+/**
+ * @brief Rewrite the DMA_WRITEs of an image to the target's transfer rules
+ *
+ * Back-to-back DMAs to contiguous destinations are merged into one run,
+ * which is then aligned and cut into bursts of at most max_burst bytes.
+ * Unaligned runs either get unaligned head and tail transfers around an
+ * aligned body or, with pad, are widened with pad_byte; pad only where the
+ * target tolerates writes to the rest of an alignment unit, such as VRD
+ * slots allocated in whole units. Other commands and checkpoints are
+ * copied unchanged and are never merged across; a checksum trailer is
+ * regenerated.
+ *
+ * The output no longer matches its template command for command, so
+ * verify it with verify_init_sequence rather than verify_against_source.
+ *
+ * @param data Initialization image
+ * @param size Size in bytes
+ * @param rules Transfer rules
+ * @param integrity If not null, receives the checksums of the output
+ * @param index If not null, receives the index of the output
+ * @throw std::runtime_error if the rules are inconsistent or the image is malformed
+ */
+NormalizedImage normalize_dma(const uint8_t* data, size_t size, const DmaRules& rules,
+                              ImageIntegrity* integrity = nullptr, CommandIndex* index = nullptr);
+
+} // namespace app
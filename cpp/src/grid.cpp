@@ -0,0 +1,175 @@
+#include "grid.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace app {
+
+namespace {
+
+constexpr uint32_t kAxi2AhbBase = 0x70000000;
+
+// Registers written by apb_config.broadcast_config
+const std::pair<uint32_t, uint32_t> kBroadcastApbRegs[] = {
+    {0x1000, 0x5000}, {0x1004, 0x0000}, {0x1008, 0x0000},
+    {0x100C, 0x0000}, {0x1010, 0x0000}, {0x1014, 0x0000}
+};
+
+const NetworkType kDirectApb{BroadcastType::DIRECT, GridDestinationType::APB};
+
+} // namespace
+
+uint32_t AXI2AHB::add_network(const NetworkType& network_type) {
+    // Find next available line_id
+    for (uint32_t line_id = 0; line_id < line_id_count_; ++line_id) {
+        bool used = false;
+        for (const auto& config : network_configs_) {
+            if (config.second == line_id) {
+                used = true;
+                break;
+            }
+        }
+        if (!used) {
+            network_configs_.emplace_back(network_type, line_id);
+            return line_id;
+        }
+    }
+    throw std::runtime_error("No available line IDs (all " + std::to_string(line_id_count_) + " are in use)");
+}
+
+BirdCommandSequence AXI2AHB::get_apb_settings() const {
+    BirdCommandSequence seq{"AXI2AHB Bridge Initial Configuration", kDirectApb, {}};
+    for (const auto& config : network_configs_) {
+        uint32_t base_address = kAxi2AhbBase + config.second * 0x1000;
+        seq.add_single_command(base_address + 0x04, config.second);
+        seq.add_single_command(base_address + 0x08, 1, true);
+    }
+    return seq;
+}
+
+BirdCommandSequence AXI2AHB::get_apb_switch(const NetworkType& network_type) const {
+    for (const auto& config : network_configs_) {
+        if (config.first != network_type) {
+            continue;
+        }
+        uint32_t base_address = kAxi2AhbBase + config.second * 0x1000;
+        BirdCommandSequence seq{"AXI2AHB Bridge Switch to " + network_type.value(), kDirectApb, {}};
+        seq.add_single_command(base_address + 0x04, config.second);
+        seq.add_single_command(base_address + 0x08, 1, true);
+        return seq;
+    }
+    throw std::runtime_error("No bridge configuration for network type " + network_type.value());
+}
+
+GridNOC::GridNOC(const TargetProfile& profile)
+    : axi2ahb_(profile.line_id_count),
+      broadcast_sequence_{"NOC Broadcast and AXI2AHB Network Configuration", kDirectApb, {}},
+      broadcast_groups_(profile.broadcast_groups) {
+    axi2ahb_.add_network(kDirectApb);
+    axi2ahb_.add_network(NetworkType{BroadcastType::SUPER_PE_BRCST, GridDestinationType::APB});
+    axi2ahb_.add_network(NetworkType{BroadcastType::SUPER_MSS_BRCST, GridDestinationType::APB});
+    axi2ahb_.add_network(NetworkType{BroadcastType::SUPER_MSS_BRCST, GridDestinationType::VCORE});
+    axi2ahb_.add_network(NetworkType{BroadcastType::SUPER_MSS_BRCST, GridDestinationType::MSS});
+
+    auto axi2ahb_seq = axi2ahb_.get_apb_settings();
+    broadcast_sequence_.commands = std::move(axi2ahb_seq.commands);
+}
+
+void GridNOC::add_broadcast_network(const KernelSuperGroup& supergroup, const NetworkType& network_type) {
+    // broadcast_config does not depend on the supergroup or network yet
+    (void)supergroup;
+    (void)network_type;
+    if (broadcast_groups_ != 0 && broadcast_group_count_ >= broadcast_groups_) {
+        throw std::runtime_error("No available broadcast groups (all " + std::to_string(broadcast_groups_) +
+                                 " are in use)");
+    }
+    ++broadcast_group_count_;
+    for (const auto& reg : kBroadcastApbRegs) {
+        broadcast_sequence_.add_single_command(reg.first, reg.second);
+    }
+}
+
+Grid::Grid(int size_x, int size_y)
+    : Grid([&] {
+          TargetProfile profile = TargetProfile::chip();
+          profile.size_x = size_x;
+          profile.size_y = size_y;
+          return profile;
+      }()) {}
+
+Grid::Grid(const TargetProfile& profile)
+    : profile_(profile), size_x_(profile.size_x), size_y_(profile.size_y), noc_(profile) {}
+
+Grid Grid::chip() {
+    return Grid(TargetProfile::chip());
+}
+
+Grid Grid::haps() {
+    return Grid(TargetProfile::haps());
+}
+
+bool Grid::is_within_bounds(int x, int y) const {
+    return 0 <= x && x < size_x_ && 0 <= y && y < size_y_;
+}
+
+bool Grid::is_area_free(int start_x, int start_y, int kernel_x, int kernel_y) const {
+    for (int x = start_x; x < start_x + kernel_x; ++x) {
+        for (int y = start_y; y < start_y + kernel_y; ++y) {
+            if (allocated_nodes_.count({x, y}) || allocated_vcores_.count({x, y})) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool Grid::is_vcore_free(int x, int y, int vcore) const {
+    if (allocated_nodes_.count({x, y})) {
+        return false;
+    }
+    auto it = allocated_vcores_.find({x, y});
+    return it == allocated_vcores_.end() || it->second.count(vcore) == 0;
+}
+
+bool Grid::allocate_kernel(KernelSize kernel_size, const KernelLocation& location) {
+    int x = location.x;
+    int y = location.y;
+
+    if (!is_within_bounds(x, y)) {
+        return false;
+    }
+
+    // Handle ONE_VCORE kernels
+    if (kernel_size == KernelSize::ONE_VCORE) {
+        if (!location.is_vcore() || !is_vcore_free(x, y, location.vcore)) {
+            return false;
+        }
+        allocated_vcores_[{x, y}].insert(location.vcore);
+        return true;
+    }
+
+    // Regular kernels can't be allocated to vcore locations
+    if (location.is_vcore()) {
+        return false;
+    }
+
+    auto dims = kernel_dimensions(kernel_size);
+    if (!is_within_bounds(x + dims.first - 1, y + dims.second - 1)) {
+        return false;
+    }
+    if (x % dims.first != 0 || y % dims.second != 0) {
+        return false;
+    }
+    if (!is_area_free(x, y, dims.first, dims.second)) {
+        return false;
+    }
+
+    for (int ax = x; ax < x + dims.first; ++ax) {
+        for (int ay = y; ay < y + dims.second; ++ay) {
+            allocated_nodes_.insert({ax, ay});
+        }
+    }
+    return true;
+}
+
+} // namespace app
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <set>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <cstdint>
+
+#include "bird.hpp"
+#include "kernel_types.hpp"
+#include "target_profile.hpp"
+
+namespace app {
+
+/**
+ * @brief AXI2AHB bridge configuration for all networks (mirrors hw_components.AXI2AHB)
+ */
+class AXI2AHB {
+public:
+    explicit AXI2AHB(uint32_t line_id_count = 16)
+        : line_id_count_(line_id_count) {}
+
+    /**
+     * @brief Assign the next free line ID to a network
+     *
+     * @return uint32_t The assigned line ID
+     * @throw std::runtime_error if all line IDs are in use
+     */
+    uint32_t add_network(const NetworkType& network_type);
+
+    /**
+     * @brief Initial configuration for all registered networks
+     */
+    BirdCommandSequence get_apb_settings() const;
+
+    /**
+     * @brief Commands that switch the bridge to a network
+     *
+     * @throw std::runtime_error if the network was never added
+     */
+    BirdCommandSequence get_apb_switch(const NetworkType& network_type) const;
+
+private:
+    uint32_t line_id_count_;
+
+    // Registration order is kept so the initial configuration is stable
+    std::vector<std::pair<NetworkType, uint32_t>> network_configs_;
+};
+
+/**
+ * @brief Network configuration of a grid (mirrors grid_noc.GridNOC)
+ */
+class GridNOC {
+public:
+    explicit GridNOC(const TargetProfile& profile = TargetProfile::chip());
+
+    /**
+     * @brief Add the broadcast network configuration for a supergroup
+     *
+     * @throw std::runtime_error if the target's broadcast groups are exhausted
+     */
+    void add_broadcast_network(const KernelSuperGroup& supergroup, const NetworkType& network_type);
+
+    const BirdCommandSequence& get_apb_settings() const { return broadcast_sequence_; }
+
+    BirdCommandSequence get_network_switch(const NetworkType& network_type) const {
+        return axi2ahb_.get_apb_switch(network_type);
+    }
+
+private:
+    AXI2AHB axi2ahb_;
+    BirdCommandSequence broadcast_sequence_;
+    uint32_t broadcast_groups_;        // Limit of the target, 0 for none
+    uint32_t broadcast_group_count_ = 0;
+};
+
+/**
+ * @brief Hardware platform grid (mirrors grid.Grid)
+ */
+class Grid {
+public:
+    // Grid of the given size with the chip's limits
+    Grid(int size_x, int size_y);
+    // Grid of a target's size and limits
+    explicit Grid(const TargetProfile& profile);
+
+    // 16x16 chip grid
+    static Grid chip();
+    // 4x2 HAPS prototyping grid
+    static Grid haps();
+
+    int size_x() const { return size_x_; }
+    int size_y() const { return size_y_; }
+    const TargetProfile& profile() const { return profile_; }
+
+    /**
+     * @brief Attempt to allocate a kernel at a location
+     *
+     * @return true if the location was free and is now allocated
+     */
+    bool allocate_kernel(KernelSize kernel_size, const KernelLocation& location);
+
+    void add_broadcast_network(const KernelSuperGroup& supergroup, const NetworkType& network_type) {
+        noc_.add_broadcast_network(supergroup, network_type);
+    }
+
+    const BirdCommandSequence& get_apb_settings() const { return noc_.get_apb_settings(); }
+
+    BirdCommandSequence get_network_switch(const NetworkType& network_type) const {
+        return noc_.get_network_switch(network_type);
+    }
+
+private:
+    TargetProfile profile_;
+    int size_x_;
+    int size_y_;
+    std::set<std::pair<int, int>> allocated_nodes_;
+    std::map<std::pair<int, int>, std::set<int>> allocated_vcores_;
+    GridNOC noc_;
+
+    bool is_within_bounds(int x, int y) const;
+    bool is_area_free(int start_x, int start_y, int kernel_x, int kernel_y) const;
+    bool is_vcore_free(int x, int y, int vcore) const;
+};
+
+} // namespace app
@@ -0,0 +1,258 @@
+#include "image_verifier.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "crc32c.hpp"
+#include "parallel.hpp"
+
+namespace app {
+
+namespace {
+
+uint32_t read_uint32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) |
+           (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) |
+           (static_cast<uint32_t>(in[3]) << 24);
+}
+
+VerifyResult fail(VerifyResult result, size_t command, size_t offset, std::string error) {
+    result.ok = false;
+    result.failed_command = command;
+    result.failed_offset = offset;
+    result.error = std::move(error);
+    return result;
+}
+
+// Compare one image command with the template command it was generated from
+std::string compare_command(const AppInitializer& source, const CommandEntry& expected,
+                            const uint8_t* data, const CommandEntry& actual) {
+    const uint8_t* template_data = source.binary_sequence().data();
+
+    if (expected.type != CommandType::VRD_INFO) {
+        if (actual.type != expected.type || actual.length != expected.length) {
+            return "Command differs from the template";
+        }
+        if (std::memcmp(data + actual.offset, template_data + expected.offset, actual.size()) != 0) {
+            return "Command contents differ from the template";
+        }
+        return "";
+    }
+
+    std::string vrd_name(reinterpret_cast<const char*>(template_data + expected.offset + 5), expected.length - 8);
+    const VrdInfo& vrd = source.get_vrd_info(vrd_name);
+    const uint8_t* payload = data + actual.offset + 5;
+    if (actual.type != CommandType::DMA_WRITE || actual.length != vrd.data.size() + 8 ||
+        read_uint32(payload) != vrd.dst_addr || read_uint32(payload + 4) != vrd.data.size()) {
+        return "VRD " + vrd_name + " is not a DMA write of its data";
+    }
+    if (!vrd.data.empty() && std::memcmp(payload + 8, vrd.data.data(), vrd.data.size()) != 0) {
+        return "VRD " + vrd_name + " data differs";
+    }
+    return "";
+}
+
+} // namespace
+
+VerifyResult verify_init_sequence(const uint8_t* data, size_t size,
+                                  const std::vector<uint32_t>* command_checksums,
+                                  bool require_trailer) {
+    VerifyResult result;
+    uint32_t image_checksum = 0;
+    size_t pos = 0;
+
+    while (pos < size) {
+        size_t command = result.command_count;
+        if (size - pos < 5) {
+            return fail(result, command, pos, "Truncated command header");
+        }
+        CommandType cmd_type = static_cast<CommandType>(data[pos]);
+        uint32_t length = read_uint32(data + pos + 1);
+        if (size - pos - 5 < length) {
+            return fail(result, command, pos, "Command runs past the end of the image");
+        }
+        const uint8_t* payload = data + pos + 5;
+        size_t command_size = 5 + static_cast<size_t>(length);
+
+        switch (cmd_type) {
+            case CommandType::APB_WRITE:
+            case CommandType::SAFE_APB_WRITE:
+                if (length != 8) {
+                    return fail(result, command, pos, "APB write with length " + std::to_string(length));
+                }
+                break;
+
+            case CommandType::DMA_WRITE:
+                if (length < 8 || read_uint32(payload + 4) != length - 8) {
+                    return fail(result, command, pos, "DMA write length does not match its data size");
+                }
+                break;
+
+            case CommandType::CHECKPOINT:
+                if (length != 4) {
+                    return fail(result, command, pos, "Checkpoint with length " + std::to_string(length));
+                }
+                break;
+
+            case CommandType::FENCE_SIGNAL:
+            case CommandType::FENCE_WAIT:
+                if (length != 4) {
+                    return fail(result, command, pos, "Fence with length " + std::to_string(length));
+                }
+                break;
+
+            case CommandType::IMAGE_CHECKSUM:
+                if (length != 8) {
+                    return fail(result, command, pos, "Checksum trailer with length " + std::to_string(length));
+                }
+                if (pos + command_size != size) {
+                    return fail(result, command, pos, "Checksum trailer is not the last command");
+                }
+                if (read_uint32(payload) != result.command_count) {
+                    return fail(result, command, pos, "Trailer command count does not match");
+                }
+                if (read_uint32(payload + 4) != image_checksum) {
+                    return fail(result, command, pos, "Image checksum mismatch");
+                }
+                result.has_trailer = true;
+                pos += command_size;
+                continue;
+
+            default:
+                return fail(result, command, pos,
+                            "Unexpected command type: " + std::to_string(static_cast<int>(cmd_type)));
+        }
+
+        image_checksum = crc32c(image_checksum, data + pos, command_size);
+        if (command_checksums) {
+            if (command >= command_checksums->size()) {
+                return fail(result, command, pos, "More commands than checksums");
+            }
+            if (crc32c(0, data + pos, command_size) != (*command_checksums)[command]) {
+                return fail(result, command, pos, "Command checksum mismatch");
+            }
+        }
+
+        ++result.command_count;
+        pos += command_size;
+    }
+
+    if (command_checksums && result.command_count != command_checksums->size()) {
+        return fail(result, result.command_count, pos, "Fewer commands than checksums");
+    }
+    if (require_trailer && !result.has_trailer) {
+        return fail(result, result.command_count, pos, "Missing checksum trailer");
+    }
+    return result;
+}
+
+VerifyResult verify_against_source(const AppInitializer& source, const uint8_t* data, size_t size,
+                                   const SourceVerifyOptions& options) {
+    VerifyResult result;
+
+    // Template commands in output order; stale trailers and checkpoints produce no output
+    const auto& template_sequence = source.binary_sequence();
+    CommandIndex template_index = CommandIndex::build(template_sequence.data(), template_sequence.size());
+    std::vector<CommandEntry> expected;
+    expected.reserve(template_index.size());
+    for (const auto& entry : template_index.entries()) {
+        if (entry.type != CommandType::IMAGE_CHECKSUM && entry.type != CommandType::CHECKPOINT) {
+            expected.push_back(entry);
+        }
+    }
+
+    CommandIndex built_index;
+    const CommandIndex* index = options.index;
+    if (!index) {
+        try {
+            built_index = CommandIndex::build(data, size);
+        } catch (const std::runtime_error& e) {
+            return fail(result, 0, 0, e.what());
+        }
+        index = &built_index;
+    }
+    if (index->sequence_size() != size) {
+        throw std::runtime_error("Command index does not belong to this image");
+    }
+
+    size_t command_count = index->size();
+    if (command_count > 0 && (*index)[command_count - 1].type == CommandType::IMAGE_CHECKSUM) {
+        const CommandEntry& trailer = (*index)[command_count - 1];
+        --command_count;
+        if (trailer.length != 8 || read_uint32(data + trailer.offset + 5) != command_count) {
+            return fail(result, command_count, trailer.offset, "Trailer command count does not match");
+        }
+        result.has_trailer = true;
+    }
+
+    // Image commands generated from the template; checkpoints must name
+    // the ordinal of the command that follows them
+    std::vector<size_t> generated;
+    generated.reserve(command_count);
+    for (size_t i = 0; i < command_count; ++i) {
+        const CommandEntry& entry = (*index)[i];
+        if (entry.type != CommandType::CHECKPOINT) {
+            generated.push_back(i);
+        } else if (entry.length != 4 || read_uint32(data + entry.offset + 5) != generated.size()) {
+            return fail(result, i, entry.offset, "Checkpoint does not name the next command");
+        }
+    }
+
+    // Split into chunks of whole commands
+    std::vector<size_t> chunk_starts;
+    size_t chunk_bytes = 0;
+    for (size_t j = 0; j < generated.size(); ++j) {
+        if (chunk_bytes == 0) {
+            chunk_starts.push_back(j);
+        }
+        chunk_bytes += (*index)[generated[j]].size();
+        if (chunk_bytes >= options.chunk_bytes) {
+            chunk_bytes = 0;
+        }
+    }
+    chunk_starts.push_back(generated.size());
+    size_t chunk_count = chunk_starts.size() - 1;
+
+    // Chunks after the earliest failing one cannot change the answer
+    constexpr size_t kNoFailure = std::numeric_limits<size_t>::max();
+    std::atomic<size_t> first_failed_chunk{kNoFailure};
+    std::vector<VerifyResult> chunk_results(chunk_count);
+
+    parallel_for(chunk_count, options.num_threads, [&](size_t chunk) {
+        for (size_t j = chunk_starts[chunk]; j < chunk_starts[chunk + 1]; ++j) {
+            if (chunk > first_failed_chunk.load(std::memory_order_relaxed)) {
+                return;
+            }
+            size_t i = generated[j];
+            std::string error = j < expected.size()
+                ? compare_command(source, expected[j], data, (*index)[i])
+                : "Image has more commands than the template";
+            if (!error.empty()) {
+                chunk_results[chunk] = fail(VerifyResult(), i, (*index)[i].offset, error);
+                size_t current = first_failed_chunk.load();
+                while (chunk < current && !first_failed_chunk.compare_exchange_weak(current, chunk)) {
+                }
+                return;
+            }
+        }
+    });
+
+    size_t failed_chunk = first_failed_chunk.load();
+    if (failed_chunk != kNoFailure) {
+        VerifyResult failed = chunk_results[failed_chunk];
+        failed.has_trailer = result.has_trailer;
+        failed.command_count = failed.failed_command;
+        return failed;
+    }
+    if (generated.size() < expected.size()) {
+        return fail(result, command_count, size, "Image has fewer commands than the template");
+    }
+
+    result.command_count = command_count;
+    return result;
+}
+
+} // namespace app
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "app_initializer.hpp"
+#include "command_index.hpp"
+
+namespace app {
+
+// Outcome of an image verification
+struct VerifyResult {
+    bool ok = true;
+    size_t command_count = 0;     // Commands checked, trailer excluded
+    bool has_trailer = false;
+    size_t failed_command = 0;    // Ordinal of the first bad command, if !ok
+    size_t failed_offset = 0;     // Byte offset of that command
+    std::string error;
+};
+
+/**
+ * @brief Check the integrity of a generated initialization sequence
+ *
+ * Walks the sequence once, checking the command framing, the per-command
+ * checksums if given and the IMAGE_CHECKSUM trailer if present (it must be
+ * the last command). Running the checksums during the walk means the
+ * image is read exactly once.
+ *
+ * @param data Initialization sequence
+ * @param size Size in bytes
+ * @param command_checksums Per-command checksums from generation, or null
+ * @param require_trailer Fail if the sequence has no IMAGE_CHECKSUM trailer
+ * @return VerifyResult First problem found, if any
+ */
+VerifyResult verify_init_sequence(const uint8_t* data, size_t size,
+                                  const std::vector<uint32_t>* command_checksums = nullptr,
+                                  bool require_trailer = false);
+
+/**
+ * @brief Check a generated sequence against the integrity data from generation
+ */
+inline VerifyResult verify_init_sequence(const std::vector<uint8_t>& sequence, const ImageIntegrity& integrity) {
+    return verify_init_sequence(sequence.data(), sequence.size(),
+                                integrity.command_checksums.empty() ? nullptr : &integrity.command_checksums);
+}
+
+// Options for verify_against_source
+struct SourceVerifyOptions {
+    size_t num_threads = 0;            // Worker threads, 0 for hardware concurrency
+    size_t chunk_bytes = 1 << 20;      // Image bytes per work item, rounded up to whole commands
+    const CommandIndex* index = nullptr;  // Prebuilt index of the image, built here if null
+};
+
+/**
+ * @brief Check that an image is exactly the source template with its VRDs bound
+ *
+ * Every command must equal the template command at the same ordinal, and
+ * VRD slots must have become DMA writes of the loaded VRD data. The image
+ * is split into command-aligned chunks that are compared in parallel; the
+ * first mismatching command in image order is reported. Checkpoints must
+ * name the ordinal of the command after them. A checksum trailer
+ * is checked for position and command count (its checksum is checked by
+ * verify_init_sequence).
+ *
+ * @param source Initializer holding the template and VRD data
+ * @param data Image to check
+ * @param size Size of the image in bytes
+ * @param options Threads, chunk size and optional prebuilt index
+ * @return VerifyResult First mismatch found, if any
+ */
+VerifyResult verify_against_source(const AppInitializer& source, const uint8_t* data, size_t size,
+                                   const SourceVerifyOptions& options = SourceVerifyOptions());
+
+} // namespace app
@@ -0,0 +1,168 @@
+#include "kernel.hpp"
+
+#include <stdexcept>
+
+namespace app {
+
+namespace {
+
+constexpr uint32_t kMssMemoryBase = 0x10000000;
+constexpr uint32_t kPeMemoryBase = 0x20000000;
+constexpr uint32_t kApbLocationBase = 0x50000000;
+
+// Registers written by apb_config.config_vcore
+const std::pair<uint32_t, uint32_t> kVcoreApbRegs[] = {
+    {0x1000, 0x5000}, {0x1004, 0x0000}, {0x1008, 0x0000},
+    {0x100C, 0x0000}, {0x1010, 0x0000}, {0x1014, 0x0000}
+};
+
+uint32_t location_base_address(const KernelLocation& location) {
+    uint32_t base_address = kApbLocationBase + location.x * 0x10000 + location.y * 0x1000;
+    if (location.is_vcore()) {
+        base_address += location.vcore * 0x100;
+    }
+    return base_address;
+}
+
+uint32_t allocation_type_value(AllocationType type) {
+    switch (type) {
+        case AllocationType::MSS_DUPLICATED: return 1;
+        case AllocationType::PE_DUPLICATED: return 2;
+        case AllocationType::MSS_DISTRIBUTED: return 3;
+        case AllocationType::PE_DISTRIBUTED: return 4;
+    }
+    return 0;
+}
+
+} // namespace
+
+AllocationType parse_allocation_type(const std::string& value) {
+    if (value == "MSS_Duplicated") return AllocationType::MSS_DUPLICATED;
+    if (value == "PE_Duplicated") return AllocationType::PE_DUPLICATED;
+    if (value == "MSS_Distributed") return AllocationType::MSS_DISTRIBUTED;
+    if (value == "PE_Distributed") return AllocationType::PE_DISTRIBUTED;
+    throw std::runtime_error("Unknown allocation type: " + value);
+}
+
+Kernel::Kernel(std::string name, KernelSize size)
+    : name_(std::move(name)), size_(size) {}
+
+void Kernel::add_binary(std::shared_ptr<const KernelImage> binary) {
+    binaries_.push_back(std::move(binary));
+}
+
+void Kernel::add_vrd(VrdComponent vrd) {
+    vrds_.push_back(std::move(vrd));
+}
+
+std::vector<std::vector<MemoryResource>> Kernel::allocate_vrd_resources() const {
+    // Same flat strategy as resource_allocators.MemoryAllocator: every
+    // ONE_MSS block comes from MSS 0 and every ONE_PE block from PE (0, 0)
+    uint32_t mss_offset = 0;
+    uint32_t pe_offset = 0;
+    std::vector<std::vector<MemoryResource>> resources;
+
+    for (const auto& vrd : vrds_) {
+        std::vector<MemoryResource> vrd_resources;
+        bool per_mss = vrd.allocation_type == AllocationType::MSS_DUPLICATED ||
+                       vrd.allocation_type == AllocationType::MSS_DISTRIBUTED;
+        uint32_t parts = 0;
+        switch (vrd.allocation_type) {
+            case AllocationType::MSS_DUPLICATED: parts = 2; break;
+            case AllocationType::PE_DUPLICATED: parts = 8; break;
+            case AllocationType::MSS_DISTRIBUTED: parts = 8; break;
+            case AllocationType::PE_DISTRIBUTED: parts = 16; break;
+        }
+
+        uint32_t part_size = vrd.total_size() / parts;
+        for (uint32_t i = 0; i < parts; ++i) {
+            if (per_mss) {
+                vrd_resources.push_back(MemoryResource{kMssMemoryBase + mss_offset, part_size});
+                mss_offset += part_size;
+            } else {
+                vrd_resources.push_back(MemoryResource{kPeMemoryBase + pe_offset, part_size});
+                pe_offset += part_size;
+            }
+        }
+        resources.push_back(std::move(vrd_resources));
+    }
+
+    return resources;
+}
+
+std::vector<BirdCommandSequence> Kernel::generate_apb_sequences(const KernelSuperGroup& supergroup) const {
+    std::vector<BirdCommandSequence> sequences;
+
+    // Kernel size component
+    BirdCommandSequence size_seq{
+        "Kernel Size APB settings for KernelSize",
+        NetworkType{BroadcastType::SUPER_MSS_BRCST, GridDestinationType::APB},
+        {}
+    };
+    for (const auto& reg : kVcoreApbRegs) {
+        size_seq.add_single_command(reg.first, reg.second);
+    }
+    sequences.push_back(std::move(size_seq));
+
+    // VRD components
+    auto locations = supergroup.get_kernel_locations();
+    for (const auto& vrd : vrds_) {
+        BirdCommandSequence vrd_seq{
+            "VRD APB settings for " + vrd.name,
+            NetworkType{BroadcastType::SUPER_PE_BRCST, GridDestinationType::APB},
+            {}
+        };
+        for (const auto& location : locations) {
+            uint32_t base_address = location_base_address(location);
+            vrd_seq.add_single_command(base_address + 0x200, vrd.element_size);
+            vrd_seq.add_single_command(base_address + 0x204, vrd.num_elements);
+            vrd_seq.add_single_command(base_address + 0x208, allocation_type_value(vrd.allocation_type));
+            vrd_seq.add_single_command(base_address + 0x20C, vrd.dma_channel_required ? 1 : 0);
+        }
+        sequences.push_back(std::move(vrd_seq));
+    }
+
+    return sequences;
+}
+
+std::vector<BirdCommandSequence> Kernel::generate_vrd_sequences() const {
+    std::vector<BirdCommandSequence> sequences;
+    auto resources = allocate_vrd_resources();
+
+    for (size_t v = 0; v < vrds_.size(); ++v) {
+        for (size_t i = 0; i < resources[v].size(); ++i) {
+            // VRD data is bound at load time; the sequence only reserves its slot
+            BirdCommandSequence vrd_seq{
+                "VRD " + vrds_[v].name + "_" + std::to_string(i) + " for " + name_,
+                NetworkType{BroadcastType::SUPER_MSS_BRCST, GridDestinationType::MSS},
+                {}
+            };
+            vrd_seq.add_vrd_command(resources[v][i].address, resources[v][i].length,
+                                    vrd_slot_name(vrds_[v].name, i));
+            sequences.push_back(std::move(vrd_seq));
+        }
+    }
+
+    return sequences;
+}
+
+std::string Kernel::vrd_slot_name(const std::string& vrd_name, size_t part) const {
+    return name_ + "." + vrd_name + "." + std::to_string(part);
+}
+
+std::vector<BirdCommandSequence> Kernel::generate_bird_sequence(const KernelSuperGroup& supergroup) const {
+    if (binaries_.empty()) {
+        throw std::runtime_error("Kernel " + name_ + " is not built. Add PM binary before deployment.");
+    }
+
+    auto sequences = generate_apb_sequences(supergroup);
+    for (const auto& binary : binaries_) {
+        sequences.push_back(binary->generate_bird_sequence());
+    }
+    for (auto& vrd_seq : generate_vrd_sequences()) {
+        sequences.push_back(std::move(vrd_seq));
+    }
+    return sequences;
+}
+
+} // namespace app
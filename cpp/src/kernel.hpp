@@ -0,0 +1,111 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "bird.hpp"
+#include "kernel_image.hpp"
+#include "kernel_types.hpp"
+
+namespace app {
+
+// VRD allocation patterns (mirrors kernel_types.AllocationType)
+enum class AllocationType : uint8_t {
+    MSS_DUPLICATED,
+    PE_DUPLICATED,
+    MSS_DISTRIBUTED,
+    PE_DISTRIBUTED
+};
+
+/**
+ * @brief Parse the string form used in kernel JSON files ("MSS_Distributed", ...)
+ *
+ * @throw std::runtime_error if the string is not a known allocation type
+ */
+AllocationType parse_allocation_type(const std::string& value);
+
+// Variable Resident Data component of a kernel
+struct VrdComponent {
+    std::string name;
+    uint32_t element_size;
+    uint32_t num_elements;
+    AllocationType allocation_type;
+    bool dma_channel_required;
+
+    uint32_t total_size() const { return element_size * num_elements; }
+};
+
+// Memory block allocated to a kernel component
+struct MemoryResource {
+    uint32_t address;
+    uint32_t length;
+};
+
+/**
+ * @brief Native kernel definition (mirrors kernel.Kernel)
+ *
+ * Sequence generation does not modify the kernel, so one kernel may be
+ * generated for several supergroups concurrently.
+ */
+class Kernel {
+public:
+    Kernel(std::string name, KernelSize size);
+
+    void add_binary(std::shared_ptr<const KernelImage> binary);
+    void add_vrd(VrdComponent vrd);
+
+    const std::string& name() const { return name_; }
+    KernelSize size() const { return size_; }
+    const std::vector<std::shared_ptr<const KernelImage>>& binaries() const { return binaries_; }
+    const std::vector<VrdComponent>& vrds() const { return vrds_; }
+
+    /**
+     * @brief Allocate memory for all VRD components
+     *
+     * @return One list of memory resources per VRD, in VRD order
+     */
+    std::vector<std::vector<MemoryResource>> allocate_vrd_resources() const;
+
+    /**
+     * @brief Generate the APB settings for all components of the kernel
+     *
+     * @param supergroup Supergroup the kernel is deployed to
+     */
+    std::vector<BirdCommandSequence> generate_apb_sequences(const KernelSuperGroup& supergroup) const;
+
+    /**
+     * @brief Name of the VRD slot holding one allocated part of a VRD
+     *
+     * @param vrd_name VRD component name
+     * @param part Index of the memory resource within the VRD
+     * @return std::string "<kernel>.<vrd>.<part>"
+     */
+    std::string vrd_slot_name(const std::string& vrd_name, size_t part) const;
+
+    /**
+     * @brief Generate the VRD load sequences of the kernel, one VRD slot per
+     *        allocated memory resource
+     */
+    std::vector<BirdCommandSequence> generate_vrd_sequences() const;
+
+    /**
+     * @brief Generate the complete BIRD sequence for a supergroup
+     *
+     * Order matches the Python implementation: component APB settings,
+     * binaries, then VRD entries.
+     *
+     * @param supergroup Supergroup the kernel is deployed to
+     * @throw std::runtime_error if the kernel has no binaries
+     */
+    std::vector<BirdCommandSequence> generate_bird_sequence(const KernelSuperGroup& supergroup) const;
+
+private:
+    std::string name_;
+    KernelSize size_;
+    std::vector<std::shared_ptr<const KernelImage>> binaries_;
+    std::vector<VrdComponent> vrds_;
+};
+
+} // namespace app
@@ -0,0 +1,232 @@
+#include "kernel_image.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+namespace app {
+
+namespace {
+
+struct BinaryTypeInfo {
+    KernelBinaryType type;
+    const char* file_suffix;
+    uint32_t offset;
+};
+
+// Same order as the Python enum: the first matching suffix wins
+const BinaryTypeInfo kBinaryTypes[] = {
+    {KernelBinaryType::VCORE_PM, "ePM", 0x1000},
+    {KernelBinaryType::VCORE_DM, "eDMw", 0x2000},
+    {KernelBinaryType::VCORE_VM, "eVM", 0x3000},
+    {KernelBinaryType::NCORE_PM, "ePM", 0x4000},
+    {KernelBinaryType::NCORE_DM, "eDM", 0x5000},
+};
+
+constexpr size_t kSegmentAlignment = 16;
+constexpr uint64_t kFnvOffset = 1469598103934665603ULL;
+constexpr uint64_t kFnvPrime = 1099511628211ULL;
+
+bool ends_with(const std::string& value, const std::string& suffix) {
+    return value.size() >= suffix.size() &&
+           value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+uint64_t fnv1a(uint64_t hash, const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= data[i];
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+uint64_t fnv1a_uint32(uint64_t hash, uint32_t value) {
+    uint8_t bytes[4] = {
+        static_cast<uint8_t>(value),
+        static_cast<uint8_t>(value >> 8),
+        static_cast<uint8_t>(value >> 16),
+        static_cast<uint8_t>(value >> 24)
+    };
+    return fnv1a(hash, bytes, sizeof(bytes));
+}
+
+// Parse "@<word addr> <hex data>" lines into a byte address -> data map
+std::map<uint32_t, std::vector<uint8_t>> decode_memory_lines(std::istream& input, uint32_t target_offset) {
+    std::map<uint32_t, std::vector<uint8_t>> memory_map;
+    std::string line;
+
+    while (std::getline(input, line)) {
+        if (line.empty() || line[0] != '@') {
+            continue;
+        }
+
+        size_t pos = 1;
+        uint32_t word_addr = 0;
+        size_t addr_digits = 0;
+        while (pos < line.size() && hex_value(line[pos]) >= 0) {
+            word_addr = (word_addr << 4) | static_cast<uint32_t>(hex_value(line[pos++]));
+            ++addr_digits;
+        }
+        if (addr_digits == 0 || pos >= line.size() || !std::isspace(static_cast<unsigned char>(line[pos]))) {
+            continue;
+        }
+
+        std::string hex;
+        for (; pos < line.size(); ++pos) {
+            char c = line[pos];
+            if (hex_value(c) >= 0) {
+                hex.push_back(c);
+            } else if (!std::isspace(static_cast<unsigned char>(c))) {
+                break;
+            }
+        }
+        if (hex.empty()) {
+            continue;
+        }
+        if (hex.size() <= 8) {
+            hex.insert(0, 8 - hex.size(), '0');
+        }
+        if (hex.size() % 2 != 0) {
+            // Matches the Python decoder, which stops at the first invalid line
+            break;
+        }
+
+        std::vector<uint8_t> bytes;
+        bytes.reserve(hex.size() / 2);
+        for (size_t i = 0; i < hex.size(); i += 2) {
+            bytes.push_back(static_cast<uint8_t>((hex_value(hex[i]) << 4) | hex_value(hex[i + 1])));
+        }
+        memory_map[target_offset + word_addr * 4] = std::move(bytes);
+    }
+
+    return memory_map;
+}
+
+// Merge address-contiguous entries into segments
+std::vector<MemorySegment> unify_memory(std::map<uint32_t, std::vector<uint8_t>>& memory_map) {
+    std::vector<MemorySegment> unified;
+
+    for (auto& entry : memory_map) {
+        if (!unified.empty() &&
+            entry.first == unified.back().addr + unified.back().data.size()) {
+            auto& data = unified.back().data;
+            data.insert(data.end(), entry.second.begin(), entry.second.end());
+        } else {
+            unified.push_back(MemorySegment{entry.first, std::move(entry.second)});
+        }
+    }
+
+    return unified;
+}
+
+// Align segment starts down and lengths up to the DMA alignment. Segments
+// that end up sharing an aligned block are merged, the gap zero-filled, so
+// no two DMA writes ever overlap.
+std::vector<MemorySegment> align_data_segments(std::vector<MemorySegment> segments, size_t alignment) {
+    std::vector<MemorySegment> aligned;
+
+    for (auto& segment : segments) {
+        uint32_t start_addr = static_cast<uint32_t>((segment.addr / alignment) * alignment);
+        size_t end_addr = segment.addr + segment.data.size();
+        end_addr += (alignment - end_addr % alignment) % alignment;
+
+        if (!aligned.empty() && start_addr < aligned.back().addr + aligned.back().data.size()) {
+            auto& previous = aligned.back();
+            previous.data.resize(segment.addr - previous.addr, 0);
+            previous.data.insert(previous.data.end(), segment.data.begin(), segment.data.end());
+            previous.data.resize(end_addr - previous.addr, 0);
+            continue;
+        }
+
+        segment.data.insert(segment.data.begin(), segment.addr - start_addr, 0);
+        segment.data.resize(end_addr - start_addr, 0);
+        segment.addr = start_addr;
+        aligned.push_back(std::move(segment));
+    }
+    return aligned;
+}
+
+} // namespace
+
+KernelImage::KernelImage(KernelBinaryType type, std::string filename, std::vector<MemorySegment> segments)
+    : type_(type), filename_(std::move(filename)), segments_(std::move(segments)), content_hash_(kFnvOffset) {
+    for (const auto& segment : segments_) {
+        content_hash_ = fnv1a_uint32(content_hash_, segment.addr);
+        content_hash_ = fnv1a_uint32(content_hash_, static_cast<uint32_t>(segment.data.size()));
+        content_hash_ = fnv1a(content_hash_, segment.data.data(), segment.data.size());
+    }
+}
+
+KernelImage KernelImage::from_file(const std::string& filename) {
+    for (const auto& info : kBinaryTypes) {
+        if (!ends_with(filename, info.file_suffix)) {
+            continue;
+        }
+
+        std::ifstream file(filename);
+        if (!file) {
+            throw std::runtime_error("Failed to open kernel binary: " + filename);
+        }
+
+        auto memory_map = decode_memory_lines(file, info.offset);
+        return KernelImage(
+            info.type,
+            filename,
+            align_data_segments(unify_memory(memory_map), kSegmentAlignment)
+        );
+    }
+    throw std::runtime_error("Unknown binary type for filename: " + filename);
+}
+
+size_t KernelImage::size_bytes() const {
+    size_t total = 0;
+    for (const auto& segment : segments_) {
+        total += segment.data.size();
+    }
+    return total;
+}
+
+bool KernelImage::same_contents(const KernelImage& other) const {
+    if (content_hash_ != other.content_hash_ || segments_.size() != other.segments_.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < segments_.size(); ++i) {
+        if (segments_[i].addr != other.segments_[i].addr ||
+            segments_[i].data != other.segments_[i].data) {
+            return false;
+        }
+    }
+    return true;
+}
+
+BirdCommandSequence KernelImage::generate_bird_sequence() const {
+    BirdCommandSequence seq{"Kernel Binary " + filename_, load_network(), {}};
+    for (const auto& segment : segments_) {
+        seq.add_dma_command(segment.addr, segment.data);
+    }
+    return seq;
+}
+
+NetworkType KernelImage::load_network() {
+    return NetworkType{BroadcastType::SUPER_MSS_BRCST, GridDestinationType::VCORE};
+}
+
+uint32_t KernelImage::type_offset(KernelBinaryType type) {
+    for (const auto& info : kBinaryTypes) {
+        if (info.type == type) {
+            return info.offset;
+        }
+    }
+    throw std::runtime_error("Unknown kernel binary type");
+}
+
+} // namespace app
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "bird.hpp"
+
+namespace app {
+
+// Kernel binary kinds (mirrors kernel_binary_parser.KernelBinary)
+enum class KernelBinaryType : uint8_t {
+    VCORE_PM,
+    VCORE_DM,
+    VCORE_VM,
+    NCORE_PM,
+    NCORE_DM
+};
+
+// Contiguous block of memory contents at a byte address
+struct MemorySegment {
+    uint32_t addr;
+    std::vector<uint8_t> data;
+};
+
+/**
+ * @brief Decoded kernel binary image (PM, DM or VM)
+ *
+ * Holds the unified, 16-byte aligned memory segments of a kernel binary file
+ * together with a content hash, so identical images loaded from different
+ * files or kernels can be recognised without comparing every byte.
+ */
+class KernelImage {
+public:
+    /**
+     * @brief Construct an image from already decoded segments
+     *
+     * @param type Binary kind
+     * @param filename File the image was decoded from (informational)
+     * @param segments Memory segments, sorted by address
+     */
+    KernelImage(KernelBinaryType type, std::string filename, std::vector<MemorySegment> segments);
+
+    /**
+     * @brief Decode a kernel binary file, picking the type from its suffix
+     *
+     * @param filename Path to an .ePM/.eDMw/.eVM/.eDM file
+     * @throw std::runtime_error if the file cannot be opened or has an unknown suffix
+     */
+    static KernelImage from_file(const std::string& filename);
+
+    KernelBinaryType type() const { return type_; }
+    const std::string& filename() const { return filename_; }
+    const std::vector<MemorySegment>& segments() const { return segments_; }
+
+    /**
+     * @brief 64-bit FNV-1a hash over segment addresses, lengths and data
+     */
+    uint64_t content_hash() const { return content_hash_; }
+
+    /**
+     * @brief Total number of data bytes across all segments
+     */
+    size_t size_bytes() const;
+
+    /**
+     * @brief Check byte-for-byte equality of the loaded contents
+     */
+    bool same_contents(const KernelImage& other) const;
+
+    /**
+     * @brief Generate the DMA sequence that loads this image
+     */
+    BirdCommandSequence generate_bird_sequence() const;
+
+    /**
+     * @brief Network every image is broadcast over
+     */
+    static NetworkType load_network();
+
+    /**
+     * @brief Base address the binary type is loaded at
+     */
+    static uint32_t type_offset(KernelBinaryType type);
+
+private:
+    KernelBinaryType type_;
+    std::string filename_;
+    std::vector<MemorySegment> segments_;
+    uint64_t content_hash_;
+};
+
+} // namespace app
@@ -0,0 +1,87 @@
+#include "kernel_types.hpp"
+
+#include <stdexcept>
+
+namespace app {
+
+namespace {
+
+bool is_power_of_two(int value) {
+    return value > 0 && (value & (value - 1)) == 0;
+}
+
+} // namespace
+
+std::pair<int, int> kernel_dimensions(KernelSize size) {
+    switch (size) {
+        case KernelSize::ONE_VCORE: return {1, 1};
+        case KernelSize::SIZE_1X1: return {1, 1};
+        case KernelSize::SIZE_1X2: return {1, 2};
+        case KernelSize::SIZE_2X2: return {2, 2};
+        case KernelSize::SIZE_2X4: return {2, 4};
+        case KernelSize::SIZE_4X4: return {4, 4};
+        case KernelSize::SIZE_4X8: return {4, 8};
+        case KernelSize::SIZE_8X8: return {8, 8};
+        case KernelSize::SIZE_8X16: return {8, 16};
+        case KernelSize::SIZE_16X16: return {16, 16};
+    }
+    throw std::runtime_error("Unknown kernel size");
+}
+
+KernelSize parse_kernel_size(const std::string& value) {
+    if (value == "1Vcore") return KernelSize::ONE_VCORE;
+    if (value == "1x1") return KernelSize::SIZE_1X1;
+    if (value == "1x2") return KernelSize::SIZE_1X2;
+    if (value == "2x2") return KernelSize::SIZE_2X2;
+    if (value == "2x4") return KernelSize::SIZE_2X4;
+    if (value == "4x4") return KernelSize::SIZE_4X4;
+    if (value == "4x8") return KernelSize::SIZE_4X8;
+    if (value == "8x8") return KernelSize::SIZE_8X8;
+    if (value == "8x16") return KernelSize::SIZE_8X16;
+    if (value == "16x16") return KernelSize::SIZE_16X16;
+    throw std::runtime_error("Unknown kernel size: " + value);
+}
+
+KernelSuperGroup::KernelSuperGroup(int x, int y, int size_x, int size_y, KernelSize kernel_size)
+    : x_(x), y_(y), size_x_(size_x), size_y_(size_y), kernel_size_(kernel_size) {
+    if (!is_power_of_two(size_x)) {
+        throw std::runtime_error("size_x must be a power of 2, got " + std::to_string(size_x));
+    }
+    if (!is_power_of_two(size_y)) {
+        throw std::runtime_error("size_y must be a power of 2, got " + std::to_string(size_y));
+    }
+
+    auto dims = kernel_dimensions(kernel_size);
+    if (size_x % dims.first != 0 || size_y % dims.second != 0) {
+        throw std::runtime_error(
+            "Supergroup size (" + std::to_string(size_x) + "x" + std::to_string(size_y) +
+            ") must be multiple of kernel size (" + std::to_string(dims.first) + "x" +
+            std::to_string(dims.second) + ")"
+        );
+    }
+}
+
+std::vector<KernelLocation> KernelSuperGroup::get_kernel_locations() const {
+    auto dims = kernel_dimensions(kernel_size_);
+    std::vector<KernelLocation> locations;
+
+    if (kernel_size_ != KernelSize::ONE_VCORE) {
+        for (int x = x_; x < x_ + size_x_; x += dims.first) {
+            for (int y = y_; y < y_ + size_y_; y += dims.second) {
+                locations.push_back(KernelLocation{x, y, -1});
+            }
+        }
+    } else {
+        for (int x = x_; x < x_ + size_x_; ++x) {
+            for (int y = y_; y < y_ + size_y_; ++y) {
+                for (int vcore = 0; vcore < 4; ++vcore) {  // All 4 vcores
+                    locations.push_back(KernelLocation{x, y, vcore});
+                }
+            }
+        }
+    }
+
+    return locations;
+}
+
+} // namespace app
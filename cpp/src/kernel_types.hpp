@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+namespace app {
+
+// Kernel footprint on the grid (mirrors kernel_types.KernelSize)
+enum class KernelSize : uint8_t {
+    ONE_VCORE,
+    SIZE_1X1,
+    SIZE_1X2,
+    SIZE_2X2,
+    SIZE_2X4,
+    SIZE_4X4,
+    SIZE_4X8,
+    SIZE_8X8,
+    SIZE_8X16,
+    SIZE_16X16
+};
+
+/**
+ * @brief Get the x and y dimensions of a kernel size
+ */
+std::pair<int, int> kernel_dimensions(KernelSize size);
+
+/**
+ * @brief Parse the string form used in kernel JSON files ("2x2", "1Vcore", ...)
+ *
+ * @throw std::runtime_error if the string is not a known kernel size
+ */
+KernelSize parse_kernel_size(const std::string& value);
+
+// Kernel location in the grid; vcore is -1 for regular kernels
+struct KernelLocation {
+    int x;
+    int y;
+    int vcore;
+
+    bool is_vcore() const { return vcore >= 0; }
+};
+
+/**
+ * @brief Contiguous area containing copies of the same kernel
+ *
+ * The area must be a power of 2 in both dimensions and a multiple of the
+ * kernel size.
+ */
+class KernelSuperGroup {
+public:
+    /**
+     * @throw std::runtime_error if the sizes are not powers of 2 or are not
+     *        a multiple of the kernel size
+     */
+    KernelSuperGroup(int x, int y, int size_x, int size_y, KernelSize kernel_size);
+
+    int x() const { return x_; }
+    int y() const { return y_; }
+    int size_x() const { return size_x_; }
+    int size_y() const { return size_y_; }
+    KernelSize kernel_size() const { return kernel_size_; }
+
+    /**
+     * @brief Get all kernel locations within this supergroup
+     */
+    std::vector<KernelLocation> get_kernel_locations() const;
+
+    bool operator==(const KernelSuperGroup& other) const {
+        return x_ == other.x_ && y_ == other.y_ &&
+               size_x_ == other.size_x_ && size_y_ == other.size_y_ &&
+               kernel_size_ == other.kernel_size_;
+    }
+
+private:
+    int x_;
+    int y_;
+    int size_x_;
+    int size_y_;
+    KernelSize kernel_size_;
+};
+
+} // namespace app
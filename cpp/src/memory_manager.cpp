@@ -0,0 +1,957 @@
+#include "memory_manager.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+
+namespace app {
+
+namespace {
+
+const char* const kDimensionNames[] = {"PE", "MSS", "Slice"};
+
+// Resources covered in one dimension
+size_t dimension_count(const DimensionRequirement& requirement, uint32_t dimension_size) {
+    if (requirement.scope == DimensionScope::SPECIFIC) {
+        return 1;
+    }
+    return requirement.values(dimension_size).size();
+}
+
+void validate_dimension(const DimensionRequirement& requirement, uint32_t dimension_size, size_t dimension) {
+    const std::string name = kDimensionNames[dimension];
+    switch (requirement.scope) {
+        case DimensionScope::ALL:
+            break;
+        case DimensionScope::SPECIFIC:
+            if (requirement.value >= static_cast<int>(dimension_size) || requirement.value < -1) {
+                throw std::runtime_error(name + " " + std::to_string(requirement.value) + " out of range (" +
+                                         std::to_string(dimension_size) + " available)");
+            }
+            break;
+        case DimensionScope::GROUP:
+            if (requirement.mask == 0 || (dimension_size < 64 && requirement.mask >> dimension_size != 0)) {
+                std::ostringstream message;
+                message << name << " mask 0x" << std::hex << requirement.mask << std::dec << " does not fit "
+                        << dimension_size << " resources";
+                throw std::runtime_error(message.str());
+            }
+            break;
+    }
+}
+
+std::string describe_dimension(const DimensionRequirement& requirement, size_t dimension) {
+    const std::string name = kDimensionNames[dimension];
+    switch (requirement.scope) {
+        case DimensionScope::ALL:
+            return "All-" + name;
+        case DimensionScope::SPECIFIC:
+            return requirement.value < 0 ? "Auto-" + name : name + std::to_string(requirement.value);
+        case DimensionScope::GROUP:
+            if (requirement.mask == kSliceGroup0_3) {
+                return name + "-0_3";
+            }
+            if (requirement.mask == kSliceGroup4_7) {
+                return name + "-4_7";
+            }
+            std::ostringstream out;
+            out << name << "-mask0x" << std::hex << requirement.mask;
+            return out.str();
+    }
+    return "Unknown-" + name;
+}
+
+// Ordering key of allocate_all(), lower first: broad scopes, few
+// auto-selections, large sizes, serial before parallel
+std::tuple<int, int, uint64_t, int> batch_priority(const MemoryRequirement& requirement) {
+    int scope_score = 0;
+    int auto_count = 0;
+    for (const DimensionRequirement* dimension : {&requirement.pe, &requirement.mss, &requirement.slice}) {
+        if (dimension->scope == DimensionScope::SPECIFIC) {
+            scope_score += dimension->value < 0 ? 2 : 1;
+        } else if (dimension->scope == DimensionScope::GROUP) {
+            scope_score += 1;
+        }
+        auto_count += dimension->needs_selection() ? 1 : 0;
+    }
+    return std::make_tuple(scope_score, auto_count, ~requirement.size,
+                           requirement.mode == SliceAllocationMode::PARALLEL ? 1 : 0);
+}
+
+// Well-mixed hash of one allocation; XOR-combined into SliceMemoryMap's state hash
+uint64_t allocation_hash(uint64_t address, uint64_t size, const std::string& id) {
+    uint64_t h = std::hash<std::string>()(id) ^ (address * 0x9e3779b97f4a7c15ULL) ^ (size * 0xc2b2ae3d27d4eb4fULL);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    return h ^ (h >> 33);
+}
+
+
+// Ranks combinations with equal primary scores by free space, below 1
+double free_space_tiebreak(const PlacementContext& context) {
+    return static_cast<double>(context.min_free) / (static_cast<double>(context.slice_size) + 1);
+}
+
+class WorstFitPolicy : public PlacementPolicy {
+public:
+    double score(const PlacementContext& context) const override {
+        // Slight penalty for allocating across mappings
+        double free = static_cast<double>(context.min_free);
+        return context.mappings > 1 ? free * 0.8 : free;
+    }
+};
+
+class BestFitPolicy : public PlacementPolicy {
+public:
+    double score(const PlacementContext& context) const override {
+        return static_cast<double>(context.slice_size - context.min_largest_block);
+    }
+};
+
+class FewestForksPolicy : public PlacementPolicy {
+public:
+    double score(const PlacementContext& context) const override {
+        return static_cast<double>(context.mapping_count - context.forks) + free_space_tiebreak(context);
+    }
+};
+
+class PeLocalityPolicy : public PlacementPolicy {
+public:
+    double score(const PlacementContext& context) const override {
+        // Manhattan distance on the grid; requirements over several PEs include the home PE
+        const DimensionRequirement& pe = context.requirement.pe;
+        uint32_t distance = 0;
+        if (pe.scope == DimensionScope::SPECIFIC) {
+            int width = static_cast<int>(context.grid_width);
+            int home = context.requirement.home_pe;
+            distance = static_cast<uint32_t>(std::abs(pe.value % width - home % width) +
+                                             std::abs(pe.value / width - home / width));
+        }
+        return static_cast<double>(context.pe_count - std::min<uint32_t>(distance, context.pe_count)) +
+               free_space_tiebreak(context);
+    }
+};
+
+class MssBalancePolicy : public PlacementPolicy {
+public:
+    double score(const PlacementContext& context) const override {
+        return static_cast<double>(context.mss_capacity - std::min(context.max_mss_load, context.mss_capacity)) +
+               free_space_tiebreak(context);
+    }
+};
+
+} // namespace
+
+std::vector<std::pair<uint64_t, uint64_t>> intersect_ranges(const std::vector<std::pair<uint64_t, uint64_t>>& a,
+                                                            const std::vector<std::pair<uint64_t, uint64_t>>& b) {
+    std::vector<std::pair<uint64_t, uint64_t>> intersection;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.size() && j < b.size()) {
+        uint64_t start = std::max(a[i].first, b[j].first);
+        uint64_t end = std::min(a[i].second, b[j].second);
+        if (start < end) {
+            intersection.emplace_back(start, end);
+        }
+        if (a[i].second < b[j].second) {
+            ++i;
+        } else {
+            ++j;
+        }
+    }
+    return intersection;
+}
+
+const PlacementPolicy& placement_policy(PlacementPolicyKind kind) {
+    static const WorstFitPolicy worst_fit;
+    static const BestFitPolicy best_fit;
+    static const FewestForksPolicy fewest_forks;
+    static const PeLocalityPolicy pe_locality;
+    static const MssBalancePolicy mss_balance;
+    switch (kind) {
+        case PlacementPolicyKind::DEFAULT:
+        case PlacementPolicyKind::WORST_FIT:
+            return worst_fit;
+        case PlacementPolicyKind::BEST_FIT:
+            return best_fit;
+        case PlacementPolicyKind::FEWEST_FORKS:
+            return fewest_forks;
+        case PlacementPolicyKind::PE_LOCALITY:
+            return pe_locality;
+        case PlacementPolicyKind::MSS_BALANCE:
+            return mss_balance;
+    }
+    return worst_fit;
+}
+
+PlacementPolicyKind parse_placement_policy(const std::string& name) {
+    if (name == "worst-fit") {
+        return PlacementPolicyKind::WORST_FIT;
+    }
+    if (name == "best-fit") {
+        return PlacementPolicyKind::BEST_FIT;
+    }
+    if (name == "fewest-forks") {
+        return PlacementPolicyKind::FEWEST_FORKS;
+    }
+    if (name == "pe-locality") {
+        return PlacementPolicyKind::PE_LOCALITY;
+    }
+    if (name == "mss-balance") {
+        return PlacementPolicyKind::MSS_BALANCE;
+    }
+    throw std::runtime_error("Unknown placement policy: " + name);
+}
+
+const char* placement_policy_name(PlacementPolicyKind kind) {
+    switch (kind) {
+        case PlacementPolicyKind::DEFAULT:
+            return "default";
+        case PlacementPolicyKind::WORST_FIT:
+            return "worst-fit";
+        case PlacementPolicyKind::BEST_FIT:
+            return "best-fit";
+        case PlacementPolicyKind::FEWEST_FORKS:
+            return "fewest-forks";
+        case PlacementPolicyKind::PE_LOCALITY:
+            return "pe-locality";
+        case PlacementPolicyKind::MSS_BALANCE:
+            return "mss-balance";
+    }
+    return "default";
+}
+
+DimensionRequirement DimensionRequirement::all() {
+    return DimensionRequirement();
+}
+
+DimensionRequirement DimensionRequirement::specific(int value) {
+    DimensionRequirement requirement;
+    requirement.scope = DimensionScope::SPECIFIC;
+    requirement.value = value;
+    return requirement;
+}
+
+DimensionRequirement DimensionRequirement::automatic() {
+    return specific(-1);
+}
+
+DimensionRequirement DimensionRequirement::group(uint64_t mask) {
+    DimensionRequirement requirement;
+    requirement.scope = DimensionScope::GROUP;
+    requirement.mask = mask;
+    return requirement;
+}
+
+std::vector<int> DimensionRequirement::values(uint32_t dimension_size) const {
+    std::vector<int> result;
+    if (scope == DimensionScope::SPECIFIC && value >= 0) {
+        result.push_back(value);
+        return result;
+    }
+    for (uint32_t i = 0; i < dimension_size; ++i) {
+        if (scope != DimensionScope::GROUP || (i < 64 && (mask >> i & 1))) {
+            result.push_back(static_cast<int>(i));
+        }
+    }
+    return result;
+}
+
+SliceMemoryMap::SliceMemoryMap(uint64_t slice_size)
+    : slice_size_(slice_size) {
+    if (slice_size > 0) {
+        free_.emplace(0, slice_size);
+        free_sizes_.insert(slice_size);
+    }
+}
+
+std::vector<std::pair<uint64_t, uint64_t>> SliceMemoryMap::free_ranges() const {
+    return std::vector<std::pair<uint64_t, uint64_t>>(free_.begin(), free_.end());
+}
+
+bool SliceMemoryMap::allocate(uint64_t size, const std::string& id, uint64_t& address) {
+    if (!can_accommodate(size)) {
+        return false;
+    }
+    for (const auto& range : free_) {
+        if (range.second - range.first >= size) {
+            address = range.first;
+            return allocate_at(address, size, id);
+        }
+    }
+    return false;
+}
+
+bool SliceMemoryMap::allocate_at(uint64_t address, uint64_t size, const std::string& id) {
+    auto range = free_.upper_bound(address);
+    if (range == free_.begin()) {
+        return false;
+    }
+    --range;
+    uint64_t start = range->first;
+    uint64_t end = range->second;
+    if (address > end || size > end - address) {
+        return false;
+    }
+
+    // Split the free range around the allocation
+    free_sizes_.erase(free_sizes_.find(end - start));
+    free_.erase(range);
+    if (start < address) {
+        free_.emplace(start, address);
+        free_sizes_.insert(address - start);
+    }
+    if (address + size < end) {
+        free_.emplace(address + size, end);
+        free_sizes_.insert(end - address - size);
+    }
+
+    auto next = std::upper_bound(allocations_.begin(), allocations_.end(), address,
+                                 [](uint64_t a, const Allocation& allocation) { return a < allocation.address; });
+    allocations_.insert(next, Allocation{address, size, id});
+    allocated_ += size;
+    state_hash_ ^= allocation_hash(address, size, id);
+    return true;
+}
+
+bool SliceMemoryMap::same_state(const SliceMemoryMap& other) const {
+    if (state_hash_ != other.state_hash_ || allocated_ != other.allocated_ ||
+        allocations_.size() != other.allocations_.size()) {
+        return false;
+    }
+    return std::equal(allocations_.begin(), allocations_.end(), other.allocations_.begin(),
+                      [](const Allocation& a, const Allocation& b) {
+                          return a.address == b.address && a.size == b.size && a.id == b.id;
+                      });
+}
+
+uint64_t SliceMemoryMap::largest_free_block_after(uint64_t size) const {
+    for (const auto& range : free_) {
+        uint64_t length = range.second - range.first;
+        if (length < size) {
+            continue;
+        }
+        // The first fit loses size bytes; the largest block changes only if it was the largest
+        uint64_t largest = largest_free_block();
+        if (length == largest && free_sizes_.count(largest) == 1) {
+            auto next = free_sizes_.rbegin();
+            ++next;
+            largest = next == free_sizes_.rend() ? 0 : *next;
+        }
+        return std::max(largest, length - size);
+    }
+    return largest_free_block();
+}
+
+MemoryManager::MemoryManager(uint32_t pe_count, uint32_t mss_per_pe, uint32_t slices_per_mss, uint64_t slice_size)
+    : pe_count_(pe_count),
+      grid_width_(pe_count),
+      mss_per_pe_(mss_per_pe),
+      slices_per_mss_(slices_per_mss),
+      slice_size_(slice_size) {
+    if (pe_count == 0 || mss_per_pe == 0 || slices_per_mss == 0 || slice_size == 0) {
+        throw std::runtime_error("Memory geometry must not be empty");
+    }
+    // One universal mapping covers every coordinate
+    size_t total = static_cast<size_t>(pe_count) * mss_per_pe * slices_per_mss;
+    mappings_.push_back(Mapping{SliceMemoryMap(slice_size), total});
+    owner_.assign(total, 0);
+    mss_load_.assign(static_cast<size_t>(pe_count) * mss_per_pe, 0);
+}
+
+MemoryManager MemoryManager::from_profile(const TargetProfile& profile, uint32_t pe_count) {
+    profile.validate();
+    if (pe_count == 0) {
+        pe_count = static_cast<uint32_t>(profile.size_x * profile.size_y);
+    }
+    MemoryManager manager(pe_count, profile.mss_per_pe, profile.slices_per_mss, profile.slice_size);
+    manager.set_grid_width(static_cast<uint32_t>(profile.size_x));
+    return manager;
+}
+
+void MemoryManager::set_grid_width(uint32_t width) {
+    if (width == 0) {
+        throw std::runtime_error("Grid width must not be 0");
+    }
+    grid_width_ = width;
+}
+
+void MemoryManager::validate(const MemoryRequirement& requirement) const {
+    validate_dimension(requirement.pe, pe_count_, 0);
+    if (requirement.home_pe < 0 || requirement.home_pe >= static_cast<int>(pe_count_)) {
+        throw std::runtime_error("Home PE " + std::to_string(requirement.home_pe) + " out of range (" +
+                                 std::to_string(pe_count_) + " available)");
+    }
+    validate_dimension(requirement.mss, mss_per_pe_, 1);
+    validate_dimension(requirement.slice, slices_per_mss_, 2);
+    if (requirement.interleave_width == 0) {
+        throw std::runtime_error("Interleave width must be positive");
+    }
+}
+
+uint64_t MemoryManager::slice_allocation_size(const MemoryRequirement& requirement) const {
+    validate(requirement);
+    if (requirement.mode != SliceAllocationMode::PARALLEL) {
+        return requirement.size;
+    }
+    uint64_t width = requirement.interleave_width;
+    uint64_t stripe = dimension_count(requirement.slice, slices_per_mss_) * width;
+    return (requirement.size + stripe - 1) / stripe * width;
+}
+
+uint64_t MemoryManager::total_allocation_size(const MemoryRequirement& requirement) const {
+    return slice_allocation_size(requirement) * dimension_count(requirement.pe, pe_count_) *
+           dimension_count(requirement.mss, mss_per_pe_) * dimension_count(requirement.slice, slices_per_mss_);
+}
+
+std::string MemoryManager::describe_scope(const MemoryRequirement& requirement) const {
+    std::string description = describe_dimension(requirement.pe, 0) + " x " +
+                              describe_dimension(requirement.mss, 1) + " x " +
+                              describe_dimension(requirement.slice, 2);
+    if (requirement.mode == SliceAllocationMode::PARALLEL) {
+        description += " PARALLEL";
+    }
+    return description;
+}
+
+uint64_t MemoryManager::mss_allocated_bytes(int pe, int mss) const {
+    return mss_load_.at(static_cast<size_t>(pe) * mss_per_pe_ + static_cast<size_t>(mss));
+}
+
+size_t MemoryManager::coordinate(int pe, int mss, int slice) const {
+    return (static_cast<size_t>(pe) * mss_per_pe_ + static_cast<size_t>(mss)) * slices_per_mss_ +
+           static_cast<size_t>(slice);
+}
+
+std::vector<size_t> MemoryManager::coordinates(const MemoryRequirement& requirement) const {
+    std::vector<size_t> result;
+    std::vector<int> mss_values = requirement.mss.values(mss_per_pe_);
+    std::vector<int> slice_values = requirement.slice.values(slices_per_mss_);
+    for (int pe : requirement.pe.values(pe_count_)) {
+        for (int mss : mss_values) {
+            for (int slice : slice_values) {
+                result.push_back(coordinate(pe, mss, slice));
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<size_t> MemoryManager::affected_mappings(const std::vector<size_t>& coordinates) const {
+    std::vector<size_t> result;
+    for (size_t c : coordinates) {
+        result.push_back(owner_[c]);
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+void MemoryManager::prepare_lookahead(Lookahead& lookahead) const {
+    lookahead.known.clear();
+    for (const MemoryRequirement* next = lookahead.begin; next != lookahead.end; ++next) {
+        // Auto-selected resources are not known yet
+        if (!next->pe.needs_selection() && !next->mss.needs_selection() && !next->slice.needs_selection()) {
+            lookahead.known.push_back(coordinates(*next));
+        }
+    }
+    lookahead.owner = owner_;
+    lookahead.sizes.clear();
+    for (const auto& mapping : mappings_) {
+        lookahead.sizes.push_back(mapping.coordinates);
+    }
+}
+
+size_t MemoryManager::future_forks(const std::vector<size_t>& covered, Lookahead& lookahead) const {
+    // Moves the coordinates out of the mappings they cover only in part, into
+    // new mappings as fork does, logging every change to undo it below
+    auto split = [&lookahead](const std::vector<size_t>& coordinates) {
+        auto& owner = lookahead.owner;
+        auto& sizes = lookahead.sizes;
+        lookahead.hits.resize(sizes.size(), 0);
+        lookahead.target.resize(sizes.size());
+        lookahead.touched.clear();
+        for (size_t c : coordinates) {
+            if (lookahead.hits[owner[c]]++ == 0) {
+                lookahead.touched.push_back(owner[c]);
+            }
+        }
+        size_t forks = 0;
+        for (size_t m : lookahead.touched) {
+            lookahead.target[m] = m;
+            if (lookahead.hits[m] < sizes[m]) {
+                sizes[m] -= lookahead.hits[m];
+                lookahead.shrunk.emplace_back(m, lookahead.hits[m]);
+                lookahead.target[m] = sizes.size();
+                sizes.push_back(lookahead.hits[m]);
+                ++forks;
+            }
+            lookahead.hits[m] = 0;
+        }
+        for (size_t c : coordinates) {
+            if (lookahead.target[owner[c]] != owner[c]) {
+                lookahead.moved.emplace_back(c, owner[c]);
+                owner[c] = lookahead.target[owner[c]];
+            }
+        }
+        return forks;
+    };
+
+    size_t mapping_count = lookahead.sizes.size();
+    split(covered);
+    size_t forks = 0;
+    for (const auto& next : lookahead.known) {
+        forks += split(next);
+    }
+
+    for (auto it = lookahead.moved.rbegin(); it != lookahead.moved.rend(); ++it) {
+        lookahead.owner[it->first] = it->second;
+    }
+    lookahead.sizes.resize(mapping_count);
+    for (const auto& split_off : lookahead.shrunk) {
+        if (split_off.first < mapping_count) {
+            lookahead.sizes[split_off.first] += split_off.second;
+        }
+    }
+    lookahead.moved.clear();
+    lookahead.shrunk.clear();
+    return forks;
+}
+
+bool MemoryManager::resolve(MemoryRequirement& requirement) const {
+    validate(requirement);
+    return resolve(requirement, nullptr, nullptr);
+}
+
+bool MemoryManager::resolve(MemoryRequirement& requirement, PlacementExplanation* explanation,
+                            Lookahead* lookahead) const {
+    DimensionRequirement* dimensions[] = {&requirement.pe, &requirement.mss, &requirement.slice};
+    const uint32_t sizes[] = {pe_count_, mss_per_pe_, slices_per_mss_};
+    std::vector<size_t> unresolved;
+    for (size_t d = 0; d < 3; ++d) {
+        if (dimensions[d]->needs_selection()) {
+            unresolved.push_back(d);
+        }
+    }
+    if (unresolved.empty()) {
+        return true;
+    }
+
+    const PlacementPolicy& policy = requirement.policy != PlacementPolicyKind::DEFAULT
+                                        ? placement_policy(requirement.policy)
+                                        : policy_ ? *policy_ : placement_policy(PlacementPolicyKind::WORST_FIT);
+    bool worst_fit = &policy == &placement_policy(PlacementPolicyKind::WORST_FIT);
+    if (lookahead) {
+        prepare_lookahead(*lookahead);
+    }
+
+    // Try every combination, the first unresolved dimension varying slowest;
+    // the first best score wins, or with a lookahead the first best score
+    // among the fewest forks
+    uint64_t size = slice_allocation_size(requirement);
+    std::vector<int> combination(unresolved.size(), 0);
+    std::vector<int> best;
+    double best_score = -1;
+    size_t best_forks = SIZE_MAX;
+    double greedy_score = -1;
+    size_t greedy_forks = 0;
+    std::vector<size_t> covered;
+    std::vector<size_t> owners;
+    std::vector<size_t> affected;
+    while (true) {
+        for (size_t i = 0; i < unresolved.size(); ++i) {
+            dimensions[unresolved[i]]->value = combination[i];
+        }
+        PlacementContext context{requirement, size, slice_size_, pe_count_, grid_width_, mappings_.size(), 0, 0,
+                                 slice_size_, slice_size_, 0, slice_size_ * slices_per_mss_};
+        covered = coordinates(requirement);
+        owners.clear();
+        for (size_t c : covered) {
+            owners.push_back(owner_[c]);
+            context.max_mss_load = std::max(context.max_mss_load, mss_load_[c / slices_per_mss_]);
+        }
+        std::sort(owners.begin(), owners.end());
+
+        // Every run of equal owners is one affected mapping
+        affected.clear();
+        bool fits = true;
+        for (size_t i = 0, j = 0; i < owners.size(); i = j) {
+            while (j < owners.size() && owners[j] == owners[i]) {
+                ++j;
+            }
+            const Mapping& mapping = mappings_[owners[i]];
+            affected.push_back(owners[i]);
+            context.forks += j - i < mapping.coordinates ? 1 : 0;
+            fits = fits && mapping.map.can_accommodate(size);
+            context.min_free = std::min(context.min_free, mapping.map.total_free());
+            context.min_largest_block = std::min(context.min_largest_block, mapping.map.largest_free_block());
+        }
+        context.mappings = static_cast<uint32_t>(affected.size());
+        double score = fits ? policy.score(context) : -1;
+        if (lookahead && fits) {
+            size_t forks = context.forks + future_forks(covered, *lookahead);
+            if (score > greedy_score) {
+                greedy_score = score;
+                greedy_forks = forks;
+            }
+            if (forks < best_forks || (forks == best_forks && score > best_score)) {
+                best_forks = forks;
+                best_score = score;
+                best = combination;
+            }
+        } else if (score > best_score) {
+            best_score = score;
+            best = combination;
+        }
+
+        if (explanation) {
+            // Keep the top candidates, earlier ones first among equal scores
+            ++explanation->combinations;
+            auto& candidates = explanation->candidates;
+            if (candidates.size() < explain_top_k_ || score > candidates.back().score) {
+                PlacementCandidate candidate;
+                candidate.pe = requirement.pe.scope == DimensionScope::SPECIFIC ? requirement.pe.value : -1;
+                candidate.mss = requirement.mss.scope == DimensionScope::SPECIFIC ? requirement.mss.value : -1;
+                candidate.slice = requirement.slice.scope == DimensionScope::SPECIFIC ? requirement.slice.value : -1;
+                candidate.score = score;
+                candidate.min_free = context.min_free;
+                candidate.mappings = context.mappings;
+                candidate.forks = context.forks;
+                double free = static_cast<double>(context.min_free);
+                candidate.penalty = worst_fit && context.mappings > 1 ? free - free * 0.8 : 0;
+                candidate.fragmentation = 0;
+                for (size_t m : affected) {
+                    // As if each mapping took the buffer from its own first fit
+                    const SliceMemoryMap& map = mappings_[m].map;
+                    if (fits && map.total_free() > size) {
+                        float free_after = static_cast<float>(map.total_free() - size);
+                        candidate.fragmentation = std::max(candidate.fragmentation,
+                            1.0f - static_cast<float>(map.largest_free_block_after(size)) / free_after);
+                    }
+                }
+                auto position = std::upper_bound(candidates.begin(), candidates.end(), score,
+                                                 [](double s, const PlacementCandidate& c) { return s > c.score; });
+                candidates.insert(position, candidate);
+                if (candidates.size() > explain_top_k_) {
+                    candidates.pop_back();
+                }
+            }
+        }
+
+        size_t i = unresolved.size();
+        while (i > 0 && ++combination[i - 1] == static_cast<int>(sizes[unresolved[i - 1]])) {
+            combination[--i] = 0;
+        }
+        if (i == 0) {
+            break;
+        }
+    }
+
+    if (best.empty()) {
+        return false;
+    }
+    if (lookahead) {
+        lookahead->forks_avoided += greedy_forks - best_forks;
+    }
+    for (size_t i = 0; i < unresolved.size(); ++i) {
+        dimensions[unresolved[i]]->value = best[i];
+    }
+    return true;
+}
+
+void MemoryManager::fork(const std::vector<size_t>& coordinates) {
+    // Mappings covering coordinates outside the requirement keep those, and
+    // a clone takes the requirement's coordinates
+    std::vector<size_t> hits(mappings_.size(), 0);
+    for (size_t c : coordinates) {
+        ++hits[owner_[c]];
+    }
+    std::vector<size_t> target(mappings_.size());
+    for (size_t m = 0; m < target.size(); ++m) {
+        target[m] = m;
+        if (hits[m] > 0 && hits[m] < mappings_[m].coordinates) {
+            mappings_[m].coordinates -= hits[m];
+            ++forks_;
+            SliceMemoryMap clone = mappings_[m].map;
+            mappings_.push_back(Mapping{std::move(clone), hits[m]});
+            target[m] = mappings_.size() - 1;
+        }
+    }
+    for (size_t c : coordinates) {
+        owner_[c] = target[owner_[c]];
+    }
+}
+
+bool MemoryManager::allocate(const MemoryRequirement& requirement) {
+    return place(requirement, nullptr, nullptr);
+}
+
+bool MemoryManager::allocate_at(const MemoryRequirement& requirement, uint64_t address) {
+    return place(requirement, nullptr, &address);
+}
+
+std::vector<std::pair<uint64_t, uint64_t>> MemoryManager::free_ranges(const MemoryRequirement& requirement) const {
+    validate(requirement);
+    if (requirement.pe.needs_selection() || requirement.mss.needs_selection() || requirement.slice.needs_selection()) {
+        throw std::runtime_error("Requirement " + requirement.allocation_id + " has unresolved dimensions");
+    }
+    return common_free_ranges(affected_mappings(coordinates(requirement)));
+}
+
+std::vector<std::pair<uint64_t, uint64_t>> MemoryManager::common_free_ranges(
+    const std::vector<size_t>& affected) const {
+    std::vector<std::pair<uint64_t, uint64_t>> common = mappings_[affected[0]].map.free_ranges();
+    for (size_t i = 1; i < affected.size(); ++i) {
+        common = intersect_ranges(common, mappings_[affected[i]].map.free_ranges());
+    }
+    return common;
+}
+
+bool MemoryManager::place(const MemoryRequirement& requirement, Lookahead* lookahead, const uint64_t* address) {
+    validate(requirement);
+    records_.push_back(RequirementRecord{requirement, false, Placement()});
+
+    MemoryRequirement resolved = requirement;
+    PlacementExplanation* explanation = nullptr;
+    if (explain_top_k_ > 0 && (requirement.pe.needs_selection() || requirement.mss.needs_selection() ||
+                               requirement.slice.needs_selection())) {
+        explanations_.push_back(PlacementExplanation{records_.size() - 1, 0, {}});
+        explanation = &explanations_.back();
+    }
+    if (!resolve(resolved, explanation, lookahead)) {
+        if (trace_) {
+            trace_->emit(TraceEventType::FAILED, requirement.allocation_id, requirement.size,
+                         static_cast<uint64_t>(FailureReason::NO_COMBINATION));
+        }
+        return false;
+    }
+    std::vector<size_t> covered = coordinates(resolved);
+    size_t mappings_before = mappings_.size();
+    fork(covered);
+    if (trace_ && mappings_.size() != mappings_before) {
+        trace_->emit(TraceEventType::FORKED, requirement.allocation_id, mappings_before, mappings_.size());
+    }
+    std::vector<size_t> affected = affected_mappings(covered);
+    uint64_t size = slice_allocation_size(resolved);
+
+    // First fit, or the given address, in the ranges free in every affected mapping
+    std::vector<std::pair<uint64_t, uint64_t>> common = common_free_ranges(affected);
+    auto fit = std::find_if(common.begin(), common.end(),
+                            [size, address](const std::pair<uint64_t, uint64_t>& range) {
+                                if (address) {
+                                    return range.first <= *address && *address <= range.second &&
+                                           size <= range.second - *address;
+                                }
+                                return range.second - range.first >= size;
+                            });
+    if (fit == common.end()) {
+        if (trace_) {
+            trace_->emit(TraceEventType::FAILED, requirement.allocation_id, requirement.size,
+                         static_cast<uint64_t>(FailureReason::NO_ADDRESS));
+        }
+        if (auto_merge_) {
+            // The forks for the requirement are left without a difference
+            merge_equal_mappings(requirement.allocation_id);
+        }
+        return false;
+    }
+    uint64_t placed = address ? *address : fit->first;
+    for (size_t m : affected) {
+        mappings_[m].map.allocate_at(placed, size, resolved.allocation_id);
+    }
+
+    RequirementRecord& record = records_.back();
+    record.fulfilled = true;
+    record.placement.address = placed;
+    record.placement.pe = resolved.pe.scope == DimensionScope::SPECIFIC ? resolved.pe.value : -1;
+    record.placement.mss = resolved.mss.scope == DimensionScope::SPECIFIC ? resolved.mss.value : -1;
+    record.placement.slices = resolved.slice.values(slices_per_mss_);
+    record.placement.slice_bytes = size;
+    record.placement.mapping_count = mappings_.size();
+    ++fulfilled_;
+    allocated_bytes_ += size * covered.size();
+    for (size_t c : covered) {
+        mss_load_[c / slices_per_mss_] += size;
+    }
+    requested_bytes_ += total_allocation_size(requirement);
+    if (trace_) {
+        trace_->emit(TraceEventType::ALLOCATED, requirement.allocation_id, placed, size, mappings_.size());
+    }
+    if (auto_merge_) {
+        merge_equal_mappings(requirement.allocation_id);
+    }
+    return true;
+}
+
+size_t MemoryManager::merge_equal_mappings(const std::string& subject) {
+    std::vector<std::pair<uint64_t, size_t>> by_hash;
+    for (size_t m = 0; m < mappings_.size(); ++m) {
+        by_hash.emplace_back(mappings_[m].map.state_hash(), m);
+    }
+    std::sort(by_hash.begin(), by_hash.end());
+
+    // Every mapping joins the first equal one of its hash
+    std::vector<size_t> target(mappings_.size());
+    for (size_t m = 0; m < target.size(); ++m) {
+        target[m] = m;
+    }
+    size_t merged = 0;
+    for (size_t i = 0, j = 0; i < by_hash.size(); i = j) {
+        while (j < by_hash.size() && by_hash[j].first == by_hash[i].first) {
+            ++j;
+        }
+        for (size_t a = i; a < j; ++a) {
+            size_t first = by_hash[a].second;
+            for (size_t b = a + 1; b < j && target[first] == first; ++b) {
+                size_t other = by_hash[b].second;
+                if (target[other] == other && mappings_[other].map.same_state(mappings_[first].map)) {
+                    target[other] = first;
+                    mappings_[first].coordinates += mappings_[other].coordinates;
+                    ++merged;
+                }
+            }
+        }
+    }
+    if (merged == 0) {
+        return 0;
+    }
+
+    std::vector<size_t> index(mappings_.size());
+    std::vector<Mapping> kept;
+    for (size_t m = 0; m < mappings_.size(); ++m) {
+        if (target[m] == m) {
+            index[m] = kept.size();
+            kept.push_back(std::move(mappings_[m]));
+        }
+    }
+    for (size_t& owner : owner_) {
+        owner = index[target[owner]];
+    }
+    size_t mappings_before = mappings_.size();
+    mappings_ = std::move(kept);
+    merges_ += merged;
+    if (trace_) {
+        trace_->emit(TraceEventType::MERGED, subject, mappings_before, mappings_.size());
+    }
+    return merged;
+}
+
+void MemoryManager::collect(const MemoryRequirement& requirement) {
+    validate(requirement);
+    collected_.push_back(requirement);
+}
+
+BatchResult MemoryManager::allocate_all() {
+    std::vector<MemoryRequirement> ordered;
+    ordered.swap(collected_);
+    std::stable_sort(ordered.begin(), ordered.end(),
+                     [](const MemoryRequirement& a, const MemoryRequirement& b) {
+                         return batch_priority(a) < batch_priority(b);
+                     });
+    if (trace_) {
+        for (size_t i = 0; i < ordered.size(); ++i) {
+            trace_->emit(TraceEventType::REQUIREMENT_ORDERED, ordered[i].allocation_id, i);
+        }
+    }
+
+    BatchResult result;
+    Lookahead lookahead{nullptr, nullptr, 0};
+    for (size_t i = 0; i < ordered.size(); ++i) {
+        lookahead.begin = ordered.data() + i + 1;
+        lookahead.end = ordered.data() + std::min(ordered.size(), i + 1 + lookahead_depth_);
+        BatchStep step;
+        step.mappings_before = mappings_.size();
+        step.success = place(ordered[i], lookahead_depth_ > 0 ? &lookahead : nullptr, nullptr);
+        step.mappings_after = mappings_.size();
+        step.requirement = records_.size() - 1;
+        result.steps.push_back(step);
+        if (step.success) {
+            ++result.successful;
+        } else {
+            ++result.failed;
+        }
+    }
+    result.forks_avoided = lookahead.forks_avoided;
+    forks_avoided_ += lookahead.forks_avoided;
+    return result;
+}
+
+CoordinatePlacements MemoryManager::materialize() const {
+    // Size the arrays first so filling them never reallocates
+    std::vector<std::vector<int>> pe_values(records_.size());
+    std::vector<std::vector<int>> mss_values(records_.size());
+    size_t total = 0;
+    for (size_t r = 0; r < records_.size(); ++r) {
+        const RequirementRecord& record = records_[r];
+        if (!record.fulfilled) {
+            continue;
+        }
+        // Auto-selected dimensions were resolved to the placement's values
+        const Placement& placement = record.placement;
+        pe_values[r] = placement.pe >= 0 ? std::vector<int>{placement.pe} : record.requirement.pe.values(pe_count_);
+        mss_values[r] =
+            placement.mss >= 0 ? std::vector<int>{placement.mss} : record.requirement.mss.values(mss_per_pe_);
+        total += pe_values[r].size() * mss_values[r].size() * placement.slices.size();
+    }
+
+    CoordinatePlacements result;
+    result.requirement.reserve(total);
+    result.pe.reserve(total);
+    result.mss.reserve(total);
+    result.slice.reserve(total);
+    result.address.reserve(total);
+    result.size.reserve(total);
+    for (size_t r = 0; r < records_.size(); ++r) {
+        const Placement& placement = records_[r].placement;
+        for (int pe : pe_values[r]) {
+            for (int mss : mss_values[r]) {
+                for (int slice : placement.slices) {
+                    result.requirement.push_back(static_cast<uint32_t>(r));
+                    result.pe.push_back(static_cast<uint32_t>(pe));
+                    result.mss.push_back(static_cast<uint32_t>(mss));
+                    result.slice.push_back(static_cast<uint32_t>(slice));
+                    result.address.push_back(placement.address);
+                    result.size.push_back(placement.slice_bytes);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<MappingStats> MemoryManager::stats() const {
+    std::vector<MappingStats> result;
+    for (const auto& mapping : mappings_) {
+        MappingStats stats;
+        stats.coordinates = mapping.coordinates;
+        stats.total_free = mapping.map.total_free();
+        stats.total_allocated = mapping.map.total_allocated();
+        stats.largest_free_block = mapping.map.largest_free_block();
+        stats.fragmentation = 1.0 - static_cast<double>(stats.largest_free_block) /
+                                        static_cast<double>(std::max<uint64_t>(1, stats.total_free));
+        result.push_back(stats);
+    }
+    return result;
+}
+
+MemorySummary MemoryManager::summary() const {
+    MemorySummary summary;
+    summary.mappings = mappings_.size();
+    summary.forks = forks_;
+    summary.requirements = records_.size();
+    summary.fulfilled = fulfilled_;
+    summary.pending = records_.size() - fulfilled_;
+    summary.allocated_bytes = allocated_bytes_;
+    summary.free_bytes = owner_.size() * slice_size_ - allocated_bytes_;
+    summary.requested_bytes = requested_bytes_;
+    summary.forks_avoided = forks_avoided_;
+    summary.merges = merges_;
+    return summary;
+}
+
+} // namespace app
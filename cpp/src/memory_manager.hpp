@@ -0,0 +1,487 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "target_profile.hpp"
+#include "trace_events.hpp"
+
+namespace app {
+
+enum class DimensionScope {
+    ALL,        // Every resource of the dimension
+    SPECIFIC,   // One resource, picked by the resolver if no value is given
+    GROUP       // The resources of a bitmask
+};
+
+enum class SliceAllocationMode {
+    SERIAL,     // Full size in every covered slice
+    PARALLEL    // Size striped over the covered slices
+};
+
+// Built-in ways of scoring the resource combinations of auto-selected dimensions
+enum class PlacementPolicyKind {
+    DEFAULT,        // The manager's policy
+    WORST_FIT,      // Most free space, cross-mapping combinations at 80% (the Python manager's choice)
+    BEST_FIT,       // Tightest largest free block, packing buffers into few mappings
+    FEWEST_FORKS,   // Fewest mapping forks, then most free space
+    PE_LOCALITY,    // PE nearest the requirement's home_pe on the grid, then most free space
+    MSS_BALANCE     // Least loaded MSS, spreading bandwidth, then most free space
+};
+
+// Slice groups of the original two-group layout
+constexpr uint64_t kSliceGroup0_3 = 0x0F;
+constexpr uint64_t kSliceGroup4_7 = 0xF0;
+
+// Requirement on one dimension (PE, MSS or slice) of the memory hierarchy
+struct DimensionRequirement {
+    DimensionScope scope = DimensionScope::ALL;
+    int value = -1;        // SPECIFIC: resource index, -1 to auto-select
+    uint64_t mask = 0;     // GROUP: bit i covers resource i
+
+    static DimensionRequirement all();
+    static DimensionRequirement specific(int value);
+    static DimensionRequirement automatic();
+    static DimensionRequirement group(uint64_t mask);
+
+    bool needs_selection() const { return scope == DimensionScope::SPECIFIC && value < 0; }
+
+    /**
+     * @brief Resources covered in a dimension of the given size; every one
+     *        for an unresolved SPECIFIC
+     */
+    std::vector<int> values(uint32_t dimension_size) const;
+};
+
+/**
+ * @brief Buffer to place in every covered slice (mirrors memory_manager.MemoryRequirement)
+ *
+ * PARALLEL buffers are striped over the covered slices in stripes of
+ * interleave_width bytes per slice, so every slice holds
+ * ceil(size / (slices * width)) * width bytes.
+ */
+struct MemoryRequirement {
+    std::string allocation_id;
+    uint64_t size = 0;
+    DimensionRequirement pe;
+    DimensionRequirement mss;
+    DimensionRequirement slice;
+    SliceAllocationMode mode = SliceAllocationMode::SERIAL;
+    uint32_t interleave_width = 1;
+    PlacementPolicyKind policy = PlacementPolicyKind::DEFAULT;
+    int home_pe = 0;   // PE_LOCALITY: PE to stay close to
+};
+
+// Where a requirement was placed
+struct Placement {
+    uint64_t address = 0;
+    int pe = -1;               // -1 for all PEs
+    int mss = -1;              // -1 for all MSS
+    std::vector<int> slices;
+    uint64_t slice_bytes = 0;  // Bytes taken in every covered slice
+    size_t mapping_count = 0;  // Mappings after forking for the requirement
+};
+
+struct RequirementRecord {
+    MemoryRequirement requirement;
+    bool fulfilled = false;
+    Placement placement;
+};
+
+/**
+ * @brief Allocations of one slice; shared by every slice of a mapping
+ *
+ * Free ranges are kept in address order next to an ordered multiset of
+ * their sizes, so the largest free block and the totals are O(1) and an
+ * allocation updates them in O(log n). The state hash combines the
+ * allocations independently of their order.
+ */
+class SliceMemoryMap {
+public:
+    struct Allocation {
+        uint64_t address;
+        uint64_t size;
+        std::string id;
+    };
+
+    explicit SliceMemoryMap(uint64_t slice_size);
+
+    uint64_t slice_size() const { return slice_size_; }
+    uint64_t total_allocated() const { return allocated_; }
+    uint64_t total_free() const { return slice_size_ - allocated_; }
+    uint64_t largest_free_block() const { return free_sizes_.empty() ? 0 : *free_sizes_.rbegin(); }
+    bool can_accommodate(uint64_t size) const { return largest_free_block() >= size; }
+    uint64_t state_hash() const { return state_hash_; }
+
+    // Whether both maps hold the same allocations
+    bool same_state(const SliceMemoryMap& other) const;
+
+    // Largest free block left after a first-fit allocation of size, which must fit
+    uint64_t largest_free_block_after(uint64_t size) const;
+
+    // Free [start, end) ranges in address order
+    std::vector<std::pair<uint64_t, uint64_t>> free_ranges() const;
+    const std::vector<Allocation>& allocations() const { return allocations_; }
+
+    /**
+     * @brief First-fit allocation
+     * @return false if no free range is large enough
+     */
+    bool allocate(uint64_t size, const std::string& id, uint64_t& address);
+
+    /**
+     * @return false if the range is not free
+     */
+    bool allocate_at(uint64_t address, uint64_t size, const std::string& id);
+
+private:
+    uint64_t slice_size_;
+    uint64_t allocated_ = 0;
+    uint64_t state_hash_ = 0;
+    std::vector<Allocation> allocations_;   // By address
+    std::map<uint64_t, uint64_t> free_;     // Start -> end of every free range
+    std::multiset<uint64_t> free_sizes_;    // Sizes of the free ranges
+};
+
+/**
+ * @brief Placements of the fulfilled requirements expanded to every
+ *        covered (PE, MSS, slice), as parallel arrays
+ *
+ * Entry i is one coordinate of requirement requirement[i]; entries are
+ * grouped by requirement in requirements() order, coordinates PE major,
+ * then MSS, then slice.
+ */
+struct CoordinatePlacements {
+    std::vector<uint32_t> requirement;   // Index into requirements()
+    std::vector<uint32_t> pe;
+    std::vector<uint32_t> mss;
+    std::vector<uint32_t> slice;
+    std::vector<uint64_t> address;
+    std::vector<uint64_t> size;          // Bytes at the coordinate
+
+    size_t count() const { return address.size(); }
+};
+
+struct MappingStats {
+    size_t coordinates;
+    uint64_t total_free;
+    uint64_t total_allocated;
+    uint64_t largest_free_block;
+    double fragmentation;    // 1 - largest_free_block / total_free
+};
+
+// Running totals of a MemoryManager
+struct MemorySummary {
+    size_t mappings = 0;
+    size_t forks = 0;
+    size_t requirements = 0;
+    size_t fulfilled = 0;
+    size_t pending = 0;
+    uint64_t allocated_bytes = 0;   // Over every coordinate
+    uint64_t free_bytes = 0;
+    uint64_t requested_bytes = 0;   // Of the fulfilled requirements
+    size_t forks_avoided = 0;       // By allocate_all() lookahead, see BatchResult
+    size_t merges = 0;              // Mappings merged away; mappings == 1 + forks - merges
+};
+
+// One resource combination the resolver considered
+struct PlacementCandidate {
+    int pe;                   // Resolved values, -1 where the requirement covers all or a group
+    int mss;
+    int slice;
+    double score;             // -1 if some affected mapping cannot hold the requirement
+    uint64_t min_free;        // Least total free space among the affected mappings
+    uint32_t mappings;        // Affected mappings; more than one takes the cross-mapping penalty
+    uint32_t forks;           // Affected mappings the combination covers only in part
+    double penalty;           // Score lost to the worst-fit cross-mapping penalty
+    float fragmentation;      // Worst 1 - largest free block / free space an affected mapping is left with
+};
+
+// Why the resolver picked a requirement's resources
+struct PlacementExplanation {
+    size_t requirement;                        // Index into requirements()
+    size_t combinations;                       // Combinations scored
+    std::vector<PlacementCandidate> candidates;   // Best first, at most the explain depth;
+                                                  // the first one was chosen if its score is not -1
+};
+
+// What a placement policy knows about one resource combination that fits
+struct PlacementContext {
+    const MemoryRequirement& requirement;   // Auto-selected dimensions set to the combination
+    uint64_t slice_bytes;          // Bytes taken in every covered slice
+    uint64_t slice_size;
+    uint32_t pe_count;
+    uint32_t grid_width;           // PEs per grid row, PE i at column i % grid_width
+    size_t mapping_count;          // Mappings of the manager
+    uint32_t mappings;             // Affected mappings
+    uint32_t forks;                // Affected mappings covered only in part, forked on allocation
+    uint64_t min_free;             // Least total free space among the affected mappings
+    uint64_t min_largest_block;    // Least largest free block among the affected mappings
+    uint64_t max_mss_load;         // Most bytes allocated in one covered (PE, MSS)
+    uint64_t mss_capacity;         // Bytes of one MSS
+};
+
+/**
+ * @brief Scores resource combinations for the dimension resolver
+ *
+ * The highest score wins, the first combination among equal scores.
+ * Scores must not be negative.
+ */
+class PlacementPolicy {
+public:
+    virtual ~PlacementPolicy() = default;
+    virtual double score(const PlacementContext& context) const = 0;
+};
+
+/**
+ * @brief Shared instance of a built-in policy; DEFAULT is WORST_FIT
+ */
+const PlacementPolicy& placement_policy(PlacementPolicyKind kind);
+
+/**
+ * @brief Policy kind from "worst-fit", "best-fit", "fewest-forks",
+ *        "pe-locality" or "mss-balance"
+ * @throw std::runtime_error for any other name
+ */
+PlacementPolicyKind parse_placement_policy(const std::string& name);
+
+// Name parse_placement_policy accepts for a kind; "default" for DEFAULT
+const char* placement_policy_name(PlacementPolicyKind kind);
+
+// Ranges free in both of two address-ordered free range lists
+std::vector<std::pair<uint64_t, uint64_t>> intersect_ranges(const std::vector<std::pair<uint64_t, uint64_t>>& a,
+                                                            const std::vector<std::pair<uint64_t, uint64_t>>& b);
+
+struct BatchStep {
+    size_t requirement;      // Index into requirements()
+    bool success;
+    size_t mappings_before;
+    size_t mappings_after;
+};
+
+struct BatchResult {
+    std::vector<BatchStep> steps;   // In allocation order
+    size_t successful = 0;
+    size_t failed = 0;
+    // Forks the policy's choices would have taken over the lookahead
+    // windows, less those of the choices made
+    size_t forks_avoided = 0;
+};
+
+/**
+ * @brief Native port of memory_manager.MappingCentricMemoryManager
+ *
+ * Every (PE, MSS, slice) coordinate belongs to exactly one mapping, and all
+ * coordinates of a mapping share one SliceMemoryMap. Requirements fork the
+ * mappings they partially cover, then allocate at one address free in every
+ * affected mapping. Decisions match the Python manager, so either can
+ * replay the other's requirement streams.
+ *
+ * Totals are updated on every allocation: summary() is O(1) and stats()
+ * O(mappings), cheap enough to poll.
+ */
+class MemoryManager {
+public:
+    MemoryManager(uint32_t pe_count, uint32_t mss_per_pe = 4, uint32_t slices_per_mss = 8,
+                  uint64_t slice_size = 1024 * 1024);
+
+    /**
+     * @brief Manager with a profile's memory geometry
+     * @param pe_count 0 for every node of the profile's grid
+     */
+    static MemoryManager from_profile(const TargetProfile& profile, uint32_t pe_count = 0);
+
+    uint32_t pe_count() const { return pe_count_; }
+    uint32_t grid_width() const { return grid_width_; }
+    uint32_t mss_per_pe() const { return mss_per_pe_; }
+    uint32_t slices_per_mss() const { return slices_per_mss_; }
+    uint64_t slice_size() const { return slice_size_; }
+
+    /**
+     * @brief PEs per row of the grid, for PE_LOCALITY's Manhattan distances;
+     *        the default pe_count puts all PEs in one row
+     * @throw std::runtime_error if width is 0
+     */
+    void set_grid_width(uint32_t width);
+
+    // Receive allocation, fork and failure events; null (the default) disables them
+    void set_trace_sink(TraceSink* sink) { trace_ = sink; }
+
+    /**
+     * @brief Record the top_k best candidates of every requirement the
+     *        resolver picks resources for; 0 (the default) turns it off
+     */
+    void set_explain(size_t top_k) { explain_top_k_ = top_k; }
+    const std::vector<PlacementExplanation>& explanations() const { return explanations_; }
+
+    /**
+     * @brief Policy for requirements whose policy is DEFAULT; null (the
+     *        default) for WORST_FIT. The policy must outlive the manager.
+     */
+    void set_placement_policy(const PlacementPolicy* policy) { policy_ = policy; }
+
+    /**
+     * @brief Let allocate_all() weigh the next depth requirements when
+     *        resolving dimensions; 0 (the default) turns it off
+     *
+     * Among the combinations that fit, the one with the fewest forks for the
+     * requirement and the following fully specified ones wins, then the
+     * placement policy decides. Explanations still rank by policy score.
+     */
+    void set_lookahead(size_t depth) { lookahead_depth_ = depth; }
+
+    // Merge equal mappings after every allocation; off by default
+    void set_auto_merge(bool enabled) { auto_merge_ = enabled; }
+
+    /**
+     * @brief Merge mappings holding the same allocations, as forks leave
+     *        behind when the forking requirement fails or later
+     *        requirements cover the forked mappings alike
+     *
+     * Candidates are found by state hash and confirmed by comparing
+     * allocations. Mappings keep their relative order.
+     *
+     * @param subject Allocation id of the MERGED trace event
+     * @return Mappings merged away
+     */
+    size_t merge_equal_mappings(const std::string& subject = "");
+
+    /**
+     * @brief Resolve, fork and allocate one requirement, recording it in
+     *        requirements()
+     *
+     * @return false if no resource combination or address fits
+     * @throw std::runtime_error if the requirement does not fit the geometry
+     */
+    bool allocate(const MemoryRequirement& requirement);
+
+    /**
+     * @brief allocate() at a given address instead of the first fit
+     * @return false if no resource combination fits or the address is taken
+     * @throw std::runtime_error if the requirement does not fit the geometry
+     */
+    bool allocate_at(const MemoryRequirement& requirement, uint64_t address);
+
+    /**
+     * @brief Pick the auto-selected dimensions as allocate() would
+     * @return false if no resource combination can hold the requirement
+     * @throw std::runtime_error if the requirement does not fit the geometry
+     */
+    bool resolve(MemoryRequirement& requirement) const;
+
+    /**
+     * @brief Address ranges free at every coordinate of a requirement
+     * @throw std::runtime_error if the requirement does not fit the geometry
+     *        or has dimensions left to resolve
+     */
+    std::vector<std::pair<uint64_t, uint64_t>> free_ranges(const MemoryRequirement& requirement) const;
+
+    // Queue a requirement for allocate_all()
+    void collect(const MemoryRequirement& requirement);
+
+    /**
+     * @brief Allocate the collected requirements, broadest scopes and
+     *        largest sizes first
+     * @throw std::runtime_error if a requirement does not fit the geometry
+     */
+    BatchResult allocate_all();
+
+    const std::vector<RequirementRecord>& requirements() const { return records_; }
+
+    // Every coordinate of every fulfilled requirement, in one pass
+    CoordinatePlacements materialize() const;
+    size_t mapping_count() const { return mappings_.size(); }
+    size_t fork_count() const { return forks_; }
+    size_t merge_count() const { return merges_; }
+    MemorySummary summary() const;
+    std::vector<MappingStats> stats() const;
+
+    // Bytes allocated over every coordinate
+    uint64_t total_allocated_bytes() const { return allocated_bytes_; }
+    // Bytes of the fulfilled requirements; equals total_allocated_bytes()
+    uint64_t total_requested_bytes() const { return requested_bytes_; }
+    // Bytes allocated over the slices of one MSS
+    uint64_t mss_allocated_bytes(int pe, int mss) const;
+
+    /**
+     * @brief Bytes a requirement takes in every slice it covers
+     * @throw std::runtime_error if the requirement does not fit the geometry
+     */
+    uint64_t slice_allocation_size(const MemoryRequirement& requirement) const;
+    uint64_t total_allocation_size(const MemoryRequirement& requirement) const;
+
+    // e.g. "All-PE x MSS1 x Slice-mask0x55 PARALLEL"
+    std::string describe_scope(const MemoryRequirement& requirement) const;
+
+    /**
+     * @throw std::runtime_error if the requirement does not fit the geometry
+     */
+    void validate(const MemoryRequirement& requirement) const;
+
+private:
+    struct Mapping {
+        SliceMemoryMap map;
+        size_t coordinates;
+    };
+
+    uint32_t pe_count_;
+    uint32_t grid_width_;
+    uint32_t mss_per_pe_;
+    uint32_t slices_per_mss_;
+    uint64_t slice_size_;
+    std::vector<Mapping> mappings_;
+    std::vector<size_t> owner_;          // Mapping of every coordinate
+    std::vector<uint64_t> mss_load_;     // Bytes allocated in every (PE, MSS)
+    std::vector<RequirementRecord> records_;
+    std::vector<MemoryRequirement> collected_;
+    size_t forks_ = 0;
+    size_t merges_ = 0;
+    bool auto_merge_ = false;
+    size_t fulfilled_ = 0;
+    uint64_t allocated_bytes_ = 0;
+    uint64_t requested_bytes_ = 0;
+    TraceSink* trace_ = nullptr;
+    const PlacementPolicy* policy_ = nullptr;
+    size_t lookahead_depth_ = 0;
+    size_t forks_avoided_ = 0;
+    size_t explain_top_k_ = 0;
+    std::vector<PlacementExplanation> explanations_;
+
+    size_t coordinate(int pe, int mss, int slice) const;
+    std::vector<size_t> coordinates(const MemoryRequirement& requirement) const;
+    std::vector<size_t> affected_mappings(const std::vector<size_t>& coordinates) const;
+    std::vector<std::pair<uint64_t, uint64_t>> common_free_ranges(const std::vector<size_t>& affected) const;
+    // Requirements allocate_all() places after the current one
+    struct Lookahead {
+        const MemoryRequirement* begin;
+        const MemoryRequirement* end;
+        size_t forks_avoided;
+
+        // Scratch of future_forks, set up by prepare_lookahead: coordinates of
+        // the requirements with known resources, and coordinate owners and
+        // mapping sizes that every candidate splits and then restores
+        std::vector<std::vector<size_t>> known;
+        std::vector<size_t> owner;
+        std::vector<size_t> sizes;
+        std::vector<size_t> hits;
+        std::vector<size_t> target;
+        std::vector<size_t> touched;
+        std::vector<std::pair<size_t, size_t>> moved;     // Coordinate and its previous owner
+        std::vector<std::pair<size_t, size_t>> shrunk;    // Mapping and the coordinates split off
+    };
+
+    // allocate() at address, or the first fit if null
+    bool place(const MemoryRequirement& requirement, Lookahead* lookahead, const uint64_t* address);
+    bool resolve(MemoryRequirement& requirement, PlacementExplanation* explanation, Lookahead* lookahead) const;
+    void prepare_lookahead(Lookahead& lookahead) const;
+    // Forks of the lookahead requirements with known resources after forking covered
+    size_t future_forks(const std::vector<size_t>& covered, Lookahead& lookahead) const;
+    void fork(const std::vector<size_t>& coordinates);
+};
+
+} // namespace app
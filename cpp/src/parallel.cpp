@@ -0,0 +1,72 @@
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace app {
+
+size_t resolve_thread_count(size_t requested, size_t work_items) {
+    size_t threads = requested;
+    if (threads == 0) {
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    return std::max<size_t>(1, std::min(threads, work_items));
+}
+
+void parallel_for(size_t count, size_t num_threads, const std::function<void(size_t)>& fn) {
+    if (count == 0) {
+        return;
+    }
+
+    size_t threads = resolve_thread_count(num_threads, count);
+    if (threads == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next_item{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr first_error;
+    std::mutex error_mutex;
+
+    auto worker = [&]() {
+        while (!failed.load(std::memory_order_relaxed)) {
+            size_t item = next_item.fetch_add(1, std::memory_order_relaxed);
+            if (item >= count) {
+                return;
+            }
+            try {
+                fn(item);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!first_error) {
+                    first_error = std::current_exception();
+                }
+                failed.store(true, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (size_t i = 0; i + 1 < threads; ++i) {
+        workers.emplace_back(worker);
+    }
+    // The calling thread works too
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    if (first_error) {
+        std::rethrow_exception(first_error);
+    }
+}
+
+} // namespace app
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace app {
+
+/**
+ * @brief Resolve a requested worker count
+ *
+ * @param requested Requested number of threads, 0 for hardware concurrency
+ * @param work_items Number of work items; never start more workers than items
+ * @return size_t Number of workers to start (at least 1)
+ */
+size_t resolve_thread_count(size_t requested, size_t work_items);
+
+/**
+ * @brief Run fn(i) for every i in [0, count) on a pool of worker threads
+ *
+ * Work items are handed out dynamically, so uneven items balance across the
+ * workers. The call returns once every item has run. If any item throws,
+ * remaining items are skipped and the first exception is rethrown.
+ *
+ * @param count Number of work items
+ * @param num_threads Number of threads, 0 for hardware concurrency
+ * @param fn Work item callback; must be safe to call concurrently
+ */
+void parallel_for(size_t count, size_t num_threads, const std::function<void(size_t)>& fn);
+
+} // namespace app
@@ -0,0 +1,62 @@
+#include "register_shadow.hpp"
+
+#include "app_initializer.hpp"
+
+namespace app {
+
+void RegisterShadow::apply(uint32_t addr, uint32_t value, bool safe) {
+    auto it = slots_.find(addr);
+    if (it != slots_.end()) {
+        live_[it->second] = false;
+        it->second = log_.size();
+    } else {
+        slots_.emplace(addr, log_.size());
+    }
+    log_.push_back(Write{addr, value, safe});
+    live_.push_back(true);
+}
+
+bool RegisterShadow::lookup(uint32_t addr, uint32_t& value) const {
+    auto it = slots_.find(addr);
+    if (it == slots_.end()) {
+        return false;
+    }
+    value = log_[it->second].value;
+    return true;
+}
+
+std::vector<RegisterShadow::Write> RegisterShadow::writes() const {
+    std::vector<Write> writes;
+    writes.reserve(slots_.size());
+    for (size_t i = 0; i < log_.size(); ++i) {
+        if (live_[i]) {
+            writes.push_back(log_[i]);
+        }
+    }
+    return writes;
+}
+
+void RegisterShadow::encode(std::vector<uint8_t>& out) const {
+    auto append_uint32 = [&out](uint32_t value) {
+        out.push_back(static_cast<uint8_t>(value));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+        out.push_back(static_cast<uint8_t>(value >> 16));
+        out.push_back(static_cast<uint8_t>(value >> 24));
+    };
+
+    out.reserve(out.size() + slots_.size() * 13);
+    for (const auto& write : writes()) {
+        out.push_back(static_cast<uint8_t>(write.safe ? CommandType::SAFE_APB_WRITE : CommandType::APB_WRITE));
+        append_uint32(8);
+        append_uint32(write.addr);
+        append_uint32(write.value);
+    }
+}
+
+void RegisterShadow::clear() {
+    log_.clear();
+    live_.clear();
+    slots_.clear();
+}
+
+} // namespace app
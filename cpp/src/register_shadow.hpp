@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace app {
+
+/**
+ * @brief Shadow model of the APB register state left by a command prefix
+ *
+ * Records the last value written to every register. The compacted state
+ * replays as one write per register, in the order of the last writes, so
+ * a sequence can resume midway after re-establishing only the registers
+ * the skipped commands touched.
+ */
+class RegisterShadow {
+public:
+    // Register write kept by the shadow
+    struct Write {
+        uint32_t addr;
+        uint32_t value;
+        bool safe;     // Last write was a SAFE_APB_WRITE
+    };
+
+    /**
+     * @brief Record a register write
+     */
+    void apply(uint32_t addr, uint32_t value, bool safe);
+
+    /**
+     * @brief Value of a register, if it was written
+     *
+     * @return true and the value in value, or false if never written
+     */
+    bool lookup(uint32_t addr, uint32_t& value) const;
+
+    // Number of registers written
+    size_t size() const { return slots_.size(); }
+
+    /**
+     * @brief The compacted state: last write of every register, in order of last write
+     */
+    std::vector<Write> writes() const;
+
+    /**
+     * @brief Append the compacted state as APB_WRITE / SAFE_APB_WRITE commands
+     */
+    void encode(std::vector<uint8_t>& out) const;
+
+    void clear();
+
+private:
+    std::vector<Write> log_;                       // Writes in order, superseded ones included
+    std::vector<bool> live_;                       // Whether log_[i] is a register's last write
+    std::unordered_map<uint32_t, size_t> slots_;   // Register -> position of its last write
+};
+
+} // namespace app
@@ -0,0 +1,227 @@
+#include "requirement_stream.hpp"
+
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace app {
+
+namespace {
+
+uint64_t parse_number(const std::string& token, size_t line_number,
+                      uint64_t max = std::numeric_limits<uint64_t>::max()) {
+    try {
+        size_t consumed = 0;
+        unsigned long long value = std::stoull(token, &consumed, 0);
+        if (consumed != token.size() || token[0] == '-' || value > max) {
+            throw std::invalid_argument(token);
+        }
+        return value;
+    } catch (const std::logic_error&) {
+        throw std::runtime_error("Line " + std::to_string(line_number) + ": invalid number '" + token + "'");
+    }
+}
+
+DimensionRequirement parse_dimension(const std::string& token, size_t line_number) {
+    if (token == "all") {
+        return DimensionRequirement::all();
+    }
+    if (token == "auto") {
+        return DimensionRequirement::automatic();
+    }
+    if (token.compare(0, 5, "mask:") == 0) {
+        return DimensionRequirement::group(parse_number(token.substr(5), line_number));
+    }
+    // Negative indices mean auto, so larger ones must not wrap into them
+    return DimensionRequirement::specific(
+        static_cast<int>(parse_number(token, line_number, std::numeric_limits<int>::max())));
+}
+
+uint32_t parse_count(const std::string& token, size_t line_number) {
+    return static_cast<uint32_t>(parse_number(token, line_number, std::numeric_limits<uint32_t>::max()));
+}
+
+std::string format_dimension(const DimensionRequirement& dimension) {
+    switch (dimension.scope) {
+        case DimensionScope::ALL:
+            return "all";
+        case DimensionScope::SPECIFIC:
+            return dimension.value < 0 ? "auto" : std::to_string(dimension.value);
+        case DimensionScope::GROUP: {
+            std::ostringstream out;
+            out << "mask:0x" << std::hex << dimension.mask;
+            return out.str();
+        }
+    }
+    return "all";
+}
+
+} // namespace
+
+RequirementStream RequirementStream::parse(std::istream& input) {
+    RequirementStream stream;
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(input, line)) {
+        ++line_number;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream tokens(line);
+        std::vector<std::string> args;
+        for (std::string token; tokens >> token;) {
+            args.push_back(token);
+        }
+        if (args.empty()) {
+            continue;
+        }
+
+        const std::string& keyword = args[0];
+        if (keyword == "geometry") {
+            if (args.size() != 5 && args.size() != 6) {
+                throw std::runtime_error("Line " + std::to_string(line_number) + ": expected geometry <pe_count> "
+                                         "<mss_per_pe> <slices_per_mss> <slice_size> [<grid_width>]");
+            }
+            stream.pe_count = parse_count(args[1], line_number);
+            stream.mss_per_pe = parse_count(args[2], line_number);
+            stream.slices_per_mss = parse_count(args[3], line_number);
+            stream.slice_size = parse_number(args[4], line_number);
+            stream.grid_width = args.size() > 5 ? parse_count(args[5], line_number) : 0;
+        } else if (keyword == "batch") {
+            stream.operations.push_back(Operation{Operation::BATCH, MemoryRequirement()});
+        } else if (keyword == "alloc" || keyword == "collect") {
+            auto malformed = [&]() {
+                return std::runtime_error("Line " + std::to_string(line_number) + ": expected " + keyword +
+                                          " <id> <size> <pe> <mss> <slice> [parallel [<width>]] [policy <name>]"
+                                          " [home <pe>]");
+            };
+            if (args.size() < 6) {
+                throw malformed();
+            }
+            MemoryRequirement requirement;
+            requirement.allocation_id = args[1];
+            requirement.size = parse_number(args[2], line_number);
+            requirement.pe = parse_dimension(args[3], line_number);
+            requirement.mss = parse_dimension(args[4], line_number);
+            requirement.slice = parse_dimension(args[5], line_number);
+            size_t i = 6;
+            if (i < args.size() && args[i] == "parallel") {
+                requirement.mode = SliceAllocationMode::PARALLEL;
+                if (++i < args.size() && args[i] != "policy" && args[i] != "home") {
+                    requirement.interleave_width = parse_count(args[i++], line_number);
+                }
+            }
+            if (i + 1 < args.size() && args[i] == "policy") {
+                try {
+                    requirement.policy = parse_placement_policy(args[i + 1]);
+                } catch (const std::runtime_error& e) {
+                    throw std::runtime_error("Line " + std::to_string(line_number) + ": " + e.what());
+                }
+                i += 2;
+            }
+            if (i + 1 < args.size() && args[i] == "home") {
+                requirement.home_pe = static_cast<int>(
+                    parse_number(args[i + 1], line_number, std::numeric_limits<int>::max()));
+                i += 2;
+            }
+            if (i != args.size()) {
+                throw malformed();
+            }
+            stream.operations.push_back(
+                Operation{keyword == "alloc" ? Operation::ALLOCATE : Operation::COLLECT, requirement});
+        } else {
+            throw std::runtime_error("Line " + std::to_string(line_number) + ": unknown keyword '" + keyword + "'");
+        }
+    }
+    return stream;
+}
+
+std::string RequirementStream::to_string() const {
+    std::ostringstream out;
+    out << "geometry " << pe_count << ' ' << mss_per_pe << ' ' << slices_per_mss << ' ' << slice_size;
+    if (grid_width > 0) {
+        out << ' ' << grid_width;
+    }
+    out << '\n';
+    for (const auto& operation : operations) {
+        if (operation.kind == Operation::BATCH) {
+            out << "batch\n";
+            continue;
+        }
+        const MemoryRequirement& requirement = operation.requirement;
+        out << (operation.kind == Operation::ALLOCATE ? "alloc " : "collect ") << requirement.allocation_id << ' '
+            << requirement.size << ' ' << format_dimension(requirement.pe) << ' '
+            << format_dimension(requirement.mss) << ' ' << format_dimension(requirement.slice);
+        if (requirement.mode == SliceAllocationMode::PARALLEL) {
+            out << " parallel " << requirement.interleave_width;
+        }
+        if (requirement.policy != PlacementPolicyKind::DEFAULT) {
+            out << " policy " << placement_policy_name(requirement.policy);
+        }
+        if (requirement.home_pe != 0) {
+            out << " home " << requirement.home_pe;
+        }
+        out << '\n';
+    }
+    return out.str();
+}
+
+MemoryManager RequirementStream::replay(const ReplayOptions& options) const {
+    MemoryManager manager(pe_count, mss_per_pe, slices_per_mss, slice_size);
+    if (grid_width > 0) {
+        manager.set_grid_width(grid_width);
+    }
+    manager.set_explain(options.explain);
+    manager.set_placement_policy(&placement_policy(options.policy));
+    manager.set_lookahead(options.lookahead);
+    manager.set_auto_merge(options.merge);
+    for (const auto& operation : operations) {
+        switch (operation.kind) {
+            case Operation::ALLOCATE:
+                manager.allocate(operation.requirement);
+                break;
+            case Operation::COLLECT:
+                manager.collect(operation.requirement);
+                break;
+            case Operation::BATCH:
+                manager.allocate_all();
+                break;
+        }
+    }
+    return manager;
+}
+
+std::string format_record(const RequirementRecord& record) {
+    std::ostringstream out;
+    out << record.requirement.allocation_id;
+    if (!record.fulfilled) {
+        out << " fail";
+        return out.str();
+    }
+    uint64_t slice_mask = 0;
+    for (int slice : record.placement.slices) {
+        slice_mask |= uint64_t(1) << slice;
+    }
+    const Placement& placement = record.placement;
+    out << " ok 0x" << std::hex << placement.address << std::dec << ' ' << placement.pe << ' ' << placement.mss
+        << " 0x" << std::hex << slice_mask << std::dec << ' ' << placement.slice_bytes << ' '
+        << placement.mapping_count;
+    return out.str();
+}
+
+std::string format_explanation(const MemoryManager& manager, const PlacementExplanation& explanation) {
+    std::ostringstream out;
+    out << "explain " << manager.requirements().at(explanation.requirement).requirement.allocation_id << ' '
+        << explanation.combinations << " combinations\n";
+    out << std::fixed << std::setprecision(2);
+    for (const auto& candidate : explanation.candidates) {
+        out << "  pe " << candidate.pe << " mss " << candidate.mss << " slice " << candidate.slice << " score "
+            << candidate.score << " free " << candidate.min_free << " mappings " << candidate.mappings
+            << " penalty " << candidate.penalty << " frag " << candidate.fragmentation << '\n';
+    }
+    return out.str();
+}
+
+} // namespace app
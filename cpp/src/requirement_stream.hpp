@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "memory_manager.hpp"
+
+namespace app {
+
+// Manager settings for RequirementStream::replay
+struct ReplayOptions {
+    size_t explain = 0;     // See MemoryManager::set_explain
+    PlacementPolicyKind policy = PlacementPolicyKind::DEFAULT;
+    size_t lookahead = 0;   // See MemoryManager::set_lookahead
+    bool merge = false;     // See MemoryManager::set_auto_merge
+};
+
+/**
+ * @brief Memory requirements to replay against a manager, in the text
+ *        format shared with memory_manager_difftest.py
+ *
+ * Lines are whitespace separated; '#' starts a comment:
+ *
+ *     geometry <pe_count> <mss_per_pe> <slices_per_mss> <slice_size> [<grid_width>]
+ *     alloc <id> <size> <pe> <mss> <slice> [parallel [<width>]] [policy <name>] [home <pe>]
+ *     collect <id> <size> <pe> <mss> <slice> [parallel [<width>]] [policy <name>] [home <pe>]
+ *     batch                     # allocate the collected requirements
+ *
+ * Dimensions are 'all', 'auto', an index, or 'mask:<bits>' for a group.
+ * policy overrides the replay's placement policy for one requirement (see
+ * parse_placement_policy) and home sets its home_pe.
+ */
+struct RequirementStream {
+    struct Operation {
+        enum Kind { ALLOCATE, COLLECT, BATCH };
+        Kind kind;
+        MemoryRequirement requirement;   // Unused for BATCH
+    };
+
+    uint32_t pe_count = 1;
+    uint32_t mss_per_pe = 4;
+    uint32_t slices_per_mss = 8;
+    uint64_t slice_size = 1024 * 1024;
+    uint32_t grid_width = 0;   // PEs per grid row, 0 for one row
+    std::vector<Operation> operations;
+
+    /**
+     * @throw std::runtime_error naming the line of a malformed entry
+     */
+    static RequirementStream parse(std::istream& input);
+
+    std::string to_string() const;
+
+    /**
+     * @brief Run every operation on a manager with the stream's geometry
+     * @throw std::runtime_error if a requirement does not fit the geometry
+     */
+    MemoryManager replay(const ReplayOptions& options = ReplayOptions()) const;
+};
+
+/**
+ * @brief One line describing how a requirement was placed:
+ *
+ *     <id> ok <address> <pe> <mss> <slice mask> <slice bytes> <mappings>
+ *     <id> fail
+ *
+ * pe and mss are -1 when the requirement covers all of them.
+ */
+std::string format_record(const RequirementRecord& record);
+
+/**
+ * @brief A header line and one line per candidate:
+ *
+ *     explain <id> <combinations> combinations
+ *       pe <pe> mss <mss> slice <slice> score <s> free <bytes> mappings <n> penalty <p> frag <f>
+ */
+std::string format_explanation(const MemoryManager& manager, const PlacementExplanation& explanation);
+
+} // namespace app
@@ -0,0 +1,184 @@
+#include "shared_image.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "crc32c.hpp"
+
+namespace app {
+
+namespace {
+
+std::runtime_error system_error(const std::string& what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+} // namespace
+
+MappedImage::~MappedImage() {
+    unmap();
+}
+
+MappedImage::MappedImage(MappedImage&& other) noexcept
+    : base_(std::exchange(other.base_, nullptr)), mapped_size_(std::exchange(other.mapped_size_, 0)) {}
+
+MappedImage& MappedImage::operator=(MappedImage&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        base_ = std::exchange(other.base_, nullptr);
+        mapped_size_ = std::exchange(other.mapped_size_, 0);
+    }
+    return *this;
+}
+
+void MappedImage::unmap() {
+    if (base_) {
+        ::munmap(base_, mapped_size_);
+        base_ = nullptr;
+    }
+}
+
+SharedImage::~SharedImage() {
+    close();
+}
+
+SharedImage::SharedImage(SharedImage&& other) noexcept
+    : fd_(std::exchange(other.fd_, -1)), header_(std::exchange(other.header_, SharedImageHeader{})) {}
+
+SharedImage& SharedImage::operator=(SharedImage&& other) noexcept {
+    if (this != &other) {
+        close();
+        fd_ = std::exchange(other.fd_, -1);
+        header_ = std::exchange(other.header_, SharedImageHeader{});
+    }
+    return *this;
+}
+
+SharedImage SharedImage::allocate(size_t payload_size, uint64_t generation, const std::string& name,
+                                  const std::function<uint32_t(uint8_t*)>& write_payload) {
+    int fd = memfd_create(name.c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        throw system_error("Failed to create shared image");
+    }
+
+    SharedImageHeader header{
+        kSharedImageMagic,
+        kSharedImageVersion,
+        static_cast<uint16_t>(sizeof(SharedImageHeader)),
+        generation,
+        payload_size,
+        0,
+        0
+    };
+    SharedImage image(fd, header);
+
+    size_t total_size = sizeof(SharedImageHeader) + payload_size;
+    if (::ftruncate(fd, static_cast<off_t>(total_size)) < 0) {
+        throw system_error("Failed to size shared image");
+    }
+    void* base = ::mmap(nullptr, total_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        throw system_error("Failed to map shared image");
+    }
+
+    uint8_t* payload = static_cast<uint8_t*>(base) + sizeof(SharedImageHeader);
+    try {
+        image.header_.checksum = write_payload(payload);
+    } catch (...) {
+        ::munmap(base, total_size);
+        throw;
+    }
+    std::memcpy(base, &image.header_, sizeof(SharedImageHeader));
+    ::munmap(base, total_size);
+
+    // Writable mappings are gone, so the contents can be frozen
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0) {
+        throw system_error("Failed to seal shared image");
+    }
+    return image;
+}
+
+SharedImage SharedImage::create(const std::vector<uint8_t>& data, uint64_t generation, const std::string& name) {
+    return allocate(data.size(), generation, name, [&](uint8_t* payload) {
+        if (!data.empty()) {
+            std::memcpy(payload, data.data(), data.size());
+        }
+        return crc32c(0, payload, data.size());
+    });
+}
+
+SharedImage SharedImage::generate(const AppInitializer& initializer, uint64_t generation,
+                                  const GenerateOptions& options, const std::string& name) {
+    return allocate(initializer.init_sequence_size(options), generation, name, [&](uint8_t* payload) {
+        ImageIntegrity integrity;
+        initializer.write_init_sequence(payload, options, &integrity);
+        return integrity.image_checksum;
+    });
+}
+
+SharedImage SharedImage::adopt(int fd) {
+    SharedImage image(fd, SharedImageHeader{});
+
+    // Only sealed images are accepted, so the contents cannot change under the reader
+    int seals = fcntl(fd, F_GET_SEALS);
+    if (seals < 0 || (seals & (F_SEAL_WRITE | F_SEAL_SHRINK)) != (F_SEAL_WRITE | F_SEAL_SHRINK)) {
+        throw std::runtime_error("Shared image is not sealed");
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        throw system_error("Failed to inspect shared image");
+    }
+    if (static_cast<size_t>(st.st_size) < sizeof(SharedImageHeader) ||
+        ::pread(fd, &image.header_, sizeof(SharedImageHeader), 0) != static_cast<ssize_t>(sizeof(SharedImageHeader))) {
+        throw std::runtime_error("Shared image is too short for its header");
+    }
+    if (image.header_.magic != kSharedImageMagic || image.header_.version != kSharedImageVersion ||
+        image.header_.header_size != sizeof(SharedImageHeader)) {
+        throw std::runtime_error("Not a shared image");
+    }
+    if (image.header_.payload_size != static_cast<uint64_t>(st.st_size) - sizeof(SharedImageHeader)) {
+        throw std::runtime_error("Shared image size does not match its header");
+    }
+    return image;
+}
+
+MappedImage SharedImage::map(bool verify_checksum) const {
+    size_t total_size = sizeof(SharedImageHeader) + size();
+    void* base = ::mmap(nullptr, total_size, PROT_READ, MAP_SHARED, fd_, 0);
+    if (base == MAP_FAILED) {
+        throw system_error("Failed to map shared image");
+    }
+
+    MappedImage mapped(base, total_size);
+    if (verify_checksum && crc32c(0, mapped.data(), mapped.size()) != header_.checksum) {
+        throw std::runtime_error("Shared image checksum mismatch");
+    }
+    return mapped;
+}
+
+std::vector<uint8_t> SharedImage::read() const {
+    MappedImage mapped = map(true);
+    return std::vector<uint8_t>(mapped.data(), mapped.data() + mapped.size());
+}
+
+int SharedImage::release() {
+    header_ = SharedImageHeader{};
+    return std::exchange(fd_, -1);
+}
+
+void SharedImage::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+} // namespace app
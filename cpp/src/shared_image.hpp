@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "app_initializer.hpp"
+
+namespace app {
+
+constexpr uint32_t kSharedImageMagic = 0x474D4941;   // "AIMG"
+constexpr uint16_t kSharedImageVersion = 1;
+
+/**
+ * @brief Header at the start of every shared image, in host byte order
+ *
+ * The initialization sequence follows the header directly.
+ */
+struct SharedImageHeader {
+    uint32_t magic;          // kSharedImageMagic
+    uint16_t version;        // kSharedImageVersion
+    uint16_t header_size;    // sizeof(SharedImageHeader)
+    uint64_t generation;     // Producer-assigned id of this image
+    uint64_t payload_size;   // Bytes of initialization sequence
+    uint32_t checksum;       // CRC32C of the initialization sequence
+    uint32_t reserved;
+};
+
+static_assert(sizeof(SharedImageHeader) == 32, "SharedImageHeader layout is part of the format");
+
+/**
+ * @brief Read-only mapping of a shared image
+ */
+class MappedImage {
+public:
+    ~MappedImage();
+
+    MappedImage(const MappedImage&) = delete;
+    MappedImage& operator=(const MappedImage&) = delete;
+    MappedImage(MappedImage&& other) noexcept;
+    MappedImage& operator=(MappedImage&& other) noexcept;
+
+    const SharedImageHeader& header() const { return *static_cast<const SharedImageHeader*>(base_); }
+    const uint8_t* data() const { return static_cast<const uint8_t*>(base_) + sizeof(SharedImageHeader); }
+    size_t size() const { return mapped_size_ - sizeof(SharedImageHeader); }
+
+private:
+    friend class SharedImage;
+
+    void* base_ = nullptr;
+    size_t mapped_size_ = 0;
+
+    MappedImage(void* base, size_t mapped_size) : base_(base), mapped_size_(mapped_size) {}
+    void unmap();
+};
+
+/**
+ * @brief Initialization image held in an anonymous shared memory file (Linux memfd)
+ *
+ * The file descriptor can be passed to another local process, which maps
+ * the image without it ever touching the disk. The file starts with a
+ * SharedImageHeader. Images created here are sealed, so receivers can rely
+ * on the contents not changing after the checksum was verified.
+ */
+class SharedImage {
+public:
+    SharedImage() = default;
+    ~SharedImage();
+
+    SharedImage(const SharedImage&) = delete;
+    SharedImage& operator=(const SharedImage&) = delete;
+    SharedImage(SharedImage&& other) noexcept;
+    SharedImage& operator=(SharedImage&& other) noexcept;
+
+    /**
+     * @brief Copy an image into a new sealed memfd
+     *
+     * @param data Initialization sequence
+     * @param generation Id stored in the header
+     * @param name Name shown in /proc/<pid>/fd, for debugging only
+     * @throw std::runtime_error if the memfd cannot be created or written
+     */
+    static SharedImage create(const std::vector<uint8_t>& data, uint64_t generation = 0,
+                              const std::string& name = "app_image");
+
+    /**
+     * @brief Generate an image directly into a new sealed memfd
+     *
+     * The sequence is written in place behind the header, with no
+     * intermediate copy.
+     *
+     * The header checksum is the image checksum computed during generation.
+     *
+     * @param initializer Initializer with all VRDs loaded
+     * @param generation Id stored in the header
+     * @param options Generation options, e.g. to append a checksum trailer
+     * @param name Name shown in /proc/<pid>/fd, for debugging only
+     * @throw std::runtime_error if a VRD is not loaded or the memfd cannot be created
+     */
+    static SharedImage generate(const AppInitializer& initializer, uint64_t generation = 0,
+                                const GenerateOptions& options = GenerateOptions(),
+                                const std::string& name = "app_image");
+
+    /**
+     * @brief Take ownership of a received file descriptor
+     *
+     * @throw std::runtime_error if the descriptor is not sealed or does not
+     *        hold a valid header; the descriptor is closed in that case
+     */
+    static SharedImage adopt(int fd);
+
+    bool valid() const { return fd_ >= 0; }
+    int fd() const { return fd_; }
+    size_t size() const { return static_cast<size_t>(header_.payload_size); }
+    uint64_t generation() const { return header_.generation; }
+    uint32_t checksum() const { return header_.checksum; }
+
+    /**
+     * @brief Map the image read-only
+     *
+     * @param verify_checksum Check the payload against the header checksum
+     * @throw std::runtime_error if mapping fails or the checksum does not match
+     */
+    MappedImage map(bool verify_checksum = true) const;
+
+    /**
+     * @brief Copy out the verified initialization sequence
+     *
+     * @throw std::runtime_error if mapping fails or the checksum does not match
+     */
+    std::vector<uint8_t> read() const;
+
+    /**
+     * @brief Give up ownership of the descriptor
+     */
+    int release();
+
+private:
+    int fd_ = -1;
+    SharedImageHeader header_{};
+
+    SharedImage(int fd, const SharedImageHeader& header) : fd_(fd), header_(header) {}
+    static SharedImage allocate(size_t payload_size, uint64_t generation, const std::string& name,
+                                const std::function<uint32_t(uint8_t*)>& write_payload);
+    void close();
+};
+
+} // namespace app
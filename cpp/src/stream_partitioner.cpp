@@ -0,0 +1,222 @@
+#include "stream_partitioner.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "app_initializer.hpp"
+#include "command_graph.hpp"
+#include "command_index.hpp"
+#include "crc32c.hpp"
+
+namespace app {
+
+namespace {
+
+constexpr size_t kNoNode = std::numeric_limits<size_t>::max();
+constexpr uint32_t kNoFence = std::numeric_limits<uint32_t>::max();
+
+void append_uint32(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 24));
+}
+
+// Appends commands to the streams and places the fences between them
+class StreamWriter {
+public:
+    StreamWriter(PartitionedImage& image, size_t num_streams)
+        : image_(image),
+          states_(num_streams, State{kNoNode, kNoNode, kNoFence, std::vector<uint32_t>(num_streams, kNoFence)}) {
+        image_.streams.resize(num_streams);
+    }
+
+    void command(size_t stream, const uint8_t* bytes, size_t size) {
+        auto& out = image_.streams[stream];
+        out.data.insert(out.data.end(), bytes, bytes + size);
+        ++out.command_count;
+        out.payload_bytes += size;
+    }
+
+    void node_done(size_t stream, size_t node) {
+        states_[stream].last_node = node;
+    }
+
+    // Block a stream until another stream has loaded a node. The signal
+    // goes at the current end of the other stream, which only holds
+    // nodes before the waiting one.
+    void wait_for(size_t stream, size_t other, size_t node) {
+        State& source = states_[other];
+        if (source.signal == kNoFence || source.signaled_node < node) {
+            source.signal = static_cast<uint32_t>(image_.fence_count++);
+            source.signaled_node = source.last_node;
+            fence(other, CommandType::FENCE_SIGNAL, source.signal);
+        }
+        uint32_t& waited = states_[stream].waited[other];
+        if (waited == kNoFence || waited < source.signal) {
+            fence(stream, CommandType::FENCE_WAIT, source.signal);
+            waited = source.signal;
+        }
+    }
+
+private:
+    struct State {
+        size_t last_node;                // Last node loaded by the stream
+        size_t signaled_node;            // Last node covered by the stream's latest signal
+        uint32_t signal;                 // Latest fence signaled by the stream
+        std::vector<uint32_t> waited;    // Latest fence waited for, per stream
+    };
+
+    PartitionedImage& image_;
+    std::vector<State> states_;
+
+    void fence(size_t stream, CommandType type, uint32_t id) {
+        auto& out = image_.streams[stream];
+        out.data.push_back(static_cast<uint8_t>(type));
+        append_uint32(out.data, 4);
+        append_uint32(out.data, id);
+        ++out.command_count;
+    }
+};
+
+} // namespace
+
+PartitionedImage partition_image(const BuildResult& build, const uint8_t* data, size_t size,
+                                 const PartitionOptions& options) {
+    if (options.num_streams == 0) {
+        throw std::runtime_error("At least one stream is required");
+    }
+
+    // Image commands generated from the build, in order
+    CommandIndex index = CommandIndex::build(data, size);
+    std::vector<const CommandEntry*> commands;
+    commands.reserve(index.size());
+    for (const auto& entry : index.entries()) {
+        if (entry.type != CommandType::CHECKPOINT && entry.type != CommandType::IMAGE_CHECKSUM) {
+            commands.push_back(&entry);
+        }
+    }
+
+    const auto& sequences = build.sequences;
+    std::vector<size_t> first_command(sequences.size() + 1, 0);
+    for (size_t i = 0; i < sequences.size(); ++i) {
+        first_command[i + 1] = first_command[i] + sequences[i].commands.size();
+    }
+    if (first_command.back() != commands.size()) {
+        throw std::runtime_error("Image does not match the build: " + std::to_string(commands.size()) +
+                                 " commands, expected " + std::to_string(first_command.back()));
+    }
+
+    std::vector<bool> is_switch(sequences.size(), false);
+    for (size_t i : build.network_switches) {
+        is_switch.at(i) = true;
+    }
+
+    // Destination domains with their size, in order of first use
+    std::vector<NetworkType> domains;
+    std::vector<size_t> domain_bytes;
+    std::vector<size_t> sequence_domain(sequences.size(), 0);
+    for (size_t i = 0; i < sequences.size(); ++i) {
+        if (is_switch[i]) {
+            continue;
+        }
+        auto found = std::find(domains.begin(), domains.end(), sequences[i].network_type);
+        size_t domain = static_cast<size_t>(found - domains.begin());
+        if (found == domains.end()) {
+            domains.push_back(sequences[i].network_type);
+            domain_bytes.push_back(0);
+        }
+        sequence_domain[i] = domain;
+        for (size_t c = first_command[i]; c < first_command[i + 1]; ++c) {
+            domain_bytes[domain] += commands[c]->size();
+        }
+    }
+
+    // Switch selecting each domain; all switches to one network are identical
+    constexpr size_t kNoSwitch = std::numeric_limits<size_t>::max();
+    std::vector<size_t> domain_switch(domains.size(), kNoSwitch);
+    for (size_t i : build.network_switches) {
+        if (i + 1 < sequences.size() && !is_switch[i + 1] && domain_switch[sequence_domain[i + 1]] == kNoSwitch) {
+            domain_switch[sequence_domain[i + 1]] = i;
+        }
+    }
+
+    // Largest domains first, each to the least loaded stream
+    size_t num_streams = std::max<size_t>(1, std::min(options.num_streams, domains.size()));
+    std::vector<size_t> by_size(domains.size());
+    std::iota(by_size.begin(), by_size.end(), 0);
+    std::stable_sort(by_size.begin(), by_size.end(), [&](size_t a, size_t b) {
+        return domain_bytes[a] > domain_bytes[b];
+    });
+    std::vector<size_t> domain_stream(domains.size(), 0);
+    std::vector<size_t> stream_bytes(num_streams, 0);
+    for (size_t domain : by_size) {
+        size_t stream = static_cast<size_t>(
+            std::min_element(stream_bytes.begin(), stream_bytes.end()) - stream_bytes.begin());
+        domain_stream[domain] = stream;
+        stream_bytes[stream] += domain_bytes[domain];
+    }
+
+    CommandGraph graph = CommandGraph::build(build);
+    PartitionedImage result;
+    StreamWriter writer(result, num_streams);
+    for (size_t domain = 0; domain < domains.size(); ++domain) {
+        result.streams[domain_stream[domain]].domains.push_back(domains[domain]);
+    }
+
+    std::vector<size_t> stream_domain(num_streams, kNoSwitch);
+    for (size_t i = 0; i < sequences.size(); ++i) {
+        if (is_switch[i]) {
+            continue;
+        }
+        size_t domain = sequence_domain[i];
+        size_t stream = domain_stream[domain];
+
+        // Switches are repeated per stream, so only dependencies on other
+        // streams' sequences need fences
+        for (size_t pred : graph.predecessors(i)) {
+            size_t other = domain_stream[sequence_domain[pred]];
+            if (!is_switch[pred] && other != stream) {
+                writer.wait_for(stream, other, pred);
+            }
+        }
+
+        size_t switch_sequence = domain_switch[domain];
+        if (stream_domain[stream] != domain && switch_sequence != kNoSwitch) {
+            for (size_t c = first_command[switch_sequence]; c < first_command[switch_sequence + 1]; ++c) {
+                writer.command(stream, data + commands[c]->offset, commands[c]->size());
+            }
+        }
+        stream_domain[stream] = domain;
+
+        for (size_t c = first_command[i]; c < first_command[i + 1]; ++c) {
+            writer.command(stream, data + commands[c]->offset, commands[c]->size());
+        }
+        writer.node_done(stream, i);
+    }
+
+    // Fences are never merged across, so streams normalize like whole images
+    if (options.normalize_dma) {
+        for (auto& stream : result.streams) {
+            auto normalized = normalize_dma(stream.data.data(), stream.data.size(), options.dma_rules);
+            stream.command_count = normalized.end_command.empty() ? 0 : normalized.end_command.back() + 1;
+            stream.data = std::move(normalized.data);
+        }
+    }
+
+    if (options.checksum_trailer) {
+        for (auto& stream : result.streams) {
+            uint32_t checksum = crc32c(0, stream.data.data(), stream.data.size());
+            stream.data.push_back(static_cast<uint8_t>(CommandType::IMAGE_CHECKSUM));
+            append_uint32(stream.data, 8);
+            append_uint32(stream.data, static_cast<uint32_t>(stream.command_count));
+            append_uint32(stream.data, checksum);
+        }
+    }
+
+    return result;
+}
+
+} // namespace app
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "application.hpp"
+#include "bird.hpp"
+#include "dma_normalizer.hpp"
+
+namespace app {
+
+// Options for partition_image
+struct PartitionOptions {
+    size_t num_streams = 2;         // Upper bound, never more streams than destination domains
+    bool checksum_trailer = false;  // Append an IMAGE_CHECKSUM command to every stream
+    bool normalize_dma = false;     // Rewrite every stream's DMAs to dma_rules
+    DmaRules dma_rules;
+};
+
+// One stream of a partitioned image, loadable independently of the others
+struct ImageStream {
+    std::vector<uint8_t> data;
+    std::vector<NetworkType> domains;   // Networks whose commands the stream carries
+    size_t command_count = 0;           // Fences and network switches included, trailer excluded
+    size_t payload_bytes = 0;           // Bytes of commands taken from the image
+};
+
+// Output of partition_image
+struct PartitionedImage {
+    std::vector<ImageStream> streams;
+    size_t fence_count = 0;   // Fence ids used are 0 .. fence_count - 1
+};
+
+/**
+ * @brief Split a final image into streams that a multi-threaded loader can
+ *        push concurrently
+ *
+ * The destination domain of a command is the network its sequence is sent
+ * over. Each domain goes to exactly one stream, so commands to the same
+ * destination keep their order; domains are spread over the streams by
+ * size. Every stream drives its own bridge, so the network switches of the
+ * image are repeated in each stream that changes network.
+ *
+ * Order across streams follows the CommandGraph of the build: before a
+ * sequence that depends on a sequence in another stream, its stream waits
+ * (FENCE_WAIT) for a FENCE_SIGNAL the other stream emits after that
+ * sequence. Barriers (sequences with a SAFE_SINGLE) thus wait for every
+ * stream and are waited for by every stream. Every wait names a signal
+ * emitted earlier in image order, so the streams cannot deadlock.
+ *
+ * @param build Build the image was generated from
+ * @param data Final image of the build; checkpoints and trailer are dropped
+ * @param size Size in bytes
+ * @throw std::runtime_error if the image does not match the build or no
+ *        stream is requested
+ */
+PartitionedImage partition_image(const BuildResult& build, const uint8_t* data, size_t size,
+                                 const PartitionOptions& options = PartitionOptions());
+
+} // namespace app
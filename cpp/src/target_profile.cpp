@@ -0,0 +1,209 @@
+#include "target_profile.hpp"
+
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace app {
+
+namespace {
+
+uint32_t parse_number(const std::string& token, size_t line_number) {
+    try {
+        size_t consumed = 0;
+        unsigned long long value = std::stoull(token, &consumed, 0);
+        if (consumed != token.size() || token[0] == '-' || value > std::numeric_limits<uint32_t>::max()) {
+            throw std::invalid_argument(token);
+        }
+        return static_cast<uint32_t>(value);
+    } catch (const std::logic_error&) {
+        throw std::runtime_error("Line " + std::to_string(line_number) + ": invalid number '" + token + "'");
+    }
+}
+
+bool is_power_of_two(uint32_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+} // namespace
+
+TargetProfile TargetProfile::chip() {
+    return TargetProfile();
+}
+
+TargetProfile TargetProfile::haps() {
+    // Same device logic at prototyping clock rates
+    TargetProfile profile;
+    profile.name = "haps";
+    profile.size_x = 4;
+    profile.size_y = 2;
+    profile.command_overhead_ns = 800;
+    profile.apb_write_ns = 400;
+    profile.safe_write_ns = 4000;
+    profile.switch_ns = 10000;
+    profile.link_mbps = 50;
+    profile.dma_mbps = 200;
+    return profile;
+}
+
+TargetProfile TargetProfile::builtin(const std::string& name) {
+    if (name == "chip") {
+        return chip();
+    }
+    if (name == "haps") {
+        return haps();
+    }
+    throw std::runtime_error("Unknown target profile: " + name);
+}
+
+TargetProfile TargetProfile::parse(std::istream& input) {
+    TargetProfile profile = chip();
+    bool has_keys = false;
+
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(input, line)) {
+        ++line_number;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+
+        std::istringstream tokens(line);
+        std::vector<std::string> args;
+        for (std::string token; tokens >> token;) {
+            args.push_back(token);
+        }
+        if (args.empty()) {
+            continue;
+        }
+        const std::string& key = args[0];
+        if (args.size() != 2) {
+            throw std::runtime_error("Line " + std::to_string(line_number) + ": expected one value for '" + key + "'");
+        }
+        const std::string& value = args[1];
+
+        if (key == "base") {
+            if (has_keys) {
+                throw std::runtime_error("Line " + std::to_string(line_number) + ": 'base' must come first");
+            }
+            try {
+                profile = builtin(value);
+            } catch (const std::runtime_error& e) {
+                throw std::runtime_error("Line " + std::to_string(line_number) + ": " + e.what());
+            }
+        } else if (key == "name") {
+            profile.name = value;
+        } else if (key == "grid") {
+            size_t separator = value.find('x');
+            if (separator == std::string::npos) {
+                throw std::runtime_error("Line " + std::to_string(line_number) + ": grid must be <size_x>x<size_y>");
+            }
+            profile.size_x = static_cast<int>(parse_number(value.substr(0, separator), line_number));
+            profile.size_y = static_cast<int>(parse_number(value.substr(separator + 1), line_number));
+        } else if (key == "line_ids") {
+            profile.line_id_count = parse_number(value, line_number);
+        } else if (key == "broadcast_groups") {
+            profile.broadcast_groups = parse_number(value, line_number);
+        } else if (key == "dma_burst") {
+            profile.dma_max_burst = parse_number(value, line_number);
+        } else if (key == "dma_align") {
+            profile.dma_alignment = parse_number(value, line_number);
+        } else if (key == "command_overhead_ns") {
+            profile.command_overhead_ns = parse_number(value, line_number);
+        } else if (key == "apb_write_ns") {
+            profile.apb_write_ns = parse_number(value, line_number);
+        } else if (key == "safe_write_ns") {
+            profile.safe_write_ns = parse_number(value, line_number);
+        } else if (key == "switch_ns") {
+            profile.switch_ns = parse_number(value, line_number);
+        } else if (key == "link_mbps") {
+            profile.link_mbps = parse_number(value, line_number);
+        } else if (key == "dma_mbps") {
+            profile.dma_mbps = parse_number(value, line_number);
+        } else if (key == "mss_per_pe") {
+            profile.mss_per_pe = parse_number(value, line_number);
+        } else if (key == "slices_per_mss") {
+            profile.slices_per_mss = parse_number(value, line_number);
+        } else if (key == "slice_size") {
+            profile.slice_size = parse_number(value, line_number);
+        } else {
+            throw std::runtime_error("Line " + std::to_string(line_number) + ": unknown key '" + key + "'");
+        }
+        has_keys = true;
+    }
+
+    profile.validate();
+    return profile;
+}
+
+TargetProfile TargetProfile::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open target profile: " + path);
+    }
+    try {
+        return parse(file);
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error(path + ": " + e.what());
+    }
+}
+
+TargetProfile TargetProfile::resolve(const std::string& name_or_path) {
+    if (name_or_path == "chip" || name_or_path == "haps") {
+        return builtin(name_or_path);
+    }
+    return load(name_or_path);
+}
+
+void TargetProfile::validate() const {
+    if (size_x <= 0 || size_y <= 0) {
+        throw std::runtime_error("Target grid must not be empty");
+    }
+    if (line_id_count == 0) {
+        throw std::runtime_error("Target needs at least one line ID");
+    }
+    if (!is_power_of_two(dma_alignment)) {
+        throw std::runtime_error("DMA alignment must be a power of two");
+    }
+    if (dma_max_burst % dma_alignment != 0) {
+        throw std::runtime_error("DMA burst must be a multiple of the alignment");
+    }
+    if (link_mbps == 0 || dma_mbps == 0) {
+        throw std::runtime_error("Target bandwidths must not be zero");
+    }
+    if (mss_per_pe == 0 || slices_per_mss == 0 || slice_size == 0) {
+        throw std::runtime_error("Target memory geometry must not be empty");
+    }
+}
+
+DmaRules TargetProfile::dma_rules() const {
+    DmaRules rules;
+    rules.max_burst = dma_max_burst;
+    rules.alignment = dma_alignment;
+    return rules;
+}
+
+std::string TargetProfile::to_string() const {
+    std::ostringstream out;
+    out << "name " << name << '\n'
+        << "grid " << size_x << 'x' << size_y << '\n'
+        << "line_ids " << line_id_count << '\n'
+        << "broadcast_groups " << broadcast_groups << '\n'
+        << "dma_burst " << dma_max_burst << '\n'
+        << "dma_align " << dma_alignment << '\n'
+        << "command_overhead_ns " << command_overhead_ns << '\n'
+        << "apb_write_ns " << apb_write_ns << '\n'
+        << "safe_write_ns " << safe_write_ns << '\n'
+        << "switch_ns " << switch_ns << '\n'
+        << "link_mbps " << link_mbps << '\n'
+        << "dma_mbps " << dma_mbps << '\n'
+        << "mss_per_pe " << mss_per_pe << '\n'
+        << "slices_per_mss " << slices_per_mss << '\n'
+        << "slice_size " << slice_size << '\n';
+    return out.str();
+}
+
+} // namespace app
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <string>
+
+#include "dma_normalizer.hpp"
+
+namespace app {
+
+/**
+ * @brief Device limits of a target platform (mirrors target_profile.TargetProfile)
+ *
+ * Every optimization pass that depends on the hardware reads its limits
+ * from the profile instead of hard-coding them, so a new platform or a
+ * retuned one only needs a new profile file.
+ *
+ * Profile files are line based; '#' starts a comment:
+ *
+ *     base chip|haps            # start from a built-in profile, must come first
+ *     name <name>
+ *     grid <size_x>x<size_y>
+ *     line_ids <n>              # AXI2AHB bridge line IDs
+ *     broadcast_groups <n>      # broadcast networks the NOC can hold, 0 for no limit
+ *     dma_burst <bytes>         # largest DMA payload, 0 for no limit
+ *     dma_align <bytes>
+ *     command_overhead_ns <ns>  # fixed loader cost of every command
+ *     apb_write_ns <ns>         # APB register write latency
+ *     safe_write_ns <ns>        # extra wait for a safe write to complete
+ *     switch_ns <ns>            # bridge settling time after a network switch
+ *     link_mbps <MB/s>          # command link bandwidth
+ *     dma_mbps <MB/s>           # DMA engine bandwidth
+ *     mss_per_pe <n>
+ *     slices_per_mss <n>
+ *     slice_size <bytes>
+ */
+struct TargetProfile {
+    // Defaults are the chip
+    std::string name = "chip";
+    int size_x = 16;
+    int size_y = 16;
+    uint32_t line_id_count = 16;
+    uint32_t broadcast_groups = 0;
+    uint32_t dma_max_burst = 0;
+    uint32_t dma_alignment = 16;
+    // Load time model, see CostModel; nominal values until measured
+    uint32_t command_overhead_ns = 40;
+    uint32_t apb_write_ns = 20;
+    uint32_t safe_write_ns = 200;
+    uint32_t switch_ns = 500;
+    uint32_t link_mbps = 1000;
+    uint32_t dma_mbps = 4000;
+    // Memory geometry used by the allocators
+    uint32_t mss_per_pe = 4;
+    uint32_t slices_per_mss = 8;
+    uint32_t slice_size = 1024 * 1024;
+
+    // 16x16 chip
+    static TargetProfile chip();
+    // 4x2 HAPS prototyping platform
+    static TargetProfile haps();
+
+    /**
+     * @brief Built-in profile by name
+     *
+     * @throw std::runtime_error for unknown names
+     */
+    static TargetProfile builtin(const std::string& name);
+
+    /**
+     * @brief Parse a profile
+     *
+     * Keys not given keep the value of the base profile, or of chip().
+     *
+     * @throw std::runtime_error on syntax errors or inconsistent limits, with the line number
+     */
+    static TargetProfile parse(std::istream& input);
+
+    /**
+     * @brief Read and parse a profile file
+     *
+     * @throw std::runtime_error if the file cannot be opened or is invalid
+     */
+    static TargetProfile load(const std::string& path);
+
+    /**
+     * @brief Built-in profile if name is one, else the profile file at that path
+     *
+     * @throw std::runtime_error like builtin or load
+     */
+    static TargetProfile resolve(const std::string& name_or_path);
+
+    /**
+     * @brief Check that the limits are consistent
+     *
+     * @throw std::runtime_error naming the first bad limit
+     */
+    void validate() const;
+
+    // DMA transfer rules of the target
+    DmaRules dma_rules() const;
+
+    // Profile in file syntax; parse(to_string()) gives the profile back
+    std::string to_string() const;
+};
+
+} // namespace app
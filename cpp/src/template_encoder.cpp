@@ -0,0 +1,79 @@
+#include "template_encoder.hpp"
+
+namespace app {
+
+namespace {
+
+constexpr size_t kCommandHeaderSize = 5;  // type + length
+
+void append_uint32(std::vector<uint8_t>& vec, uint32_t value) {
+    vec.push_back(static_cast<uint8_t>(value));
+    vec.push_back(static_cast<uint8_t>(value >> 8));
+    vec.push_back(static_cast<uint8_t>(value >> 16));
+    vec.push_back(static_cast<uint8_t>(value >> 24));
+}
+
+} // namespace
+
+size_t encoded_command_size(const BirdCommand& command) {
+    switch (command.type) {
+        case BirdCommandType::SINGLE:
+        case BirdCommandType::SAFE_SINGLE:
+            return kCommandHeaderSize + 8;
+        case BirdCommandType::DMA:
+            return kCommandHeaderSize + 8 + command.data.size();
+        case BirdCommandType::VRD:
+            return kCommandHeaderSize + command.vrd_name.size() + 8;
+    }
+    return 0;
+}
+
+void append_init_commands(std::vector<uint8_t>& out, const BirdCommandSequence& sequence) {
+    for (const auto& command : sequence.commands) {
+        switch (command.type) {
+            case BirdCommandType::SINGLE:
+            case BirdCommandType::SAFE_SINGLE:
+                out.push_back(static_cast<uint8_t>(
+                    command.type == BirdCommandType::SINGLE ? CommandType::APB_WRITE : CommandType::SAFE_APB_WRITE));
+                append_uint32(out, 8);
+                append_uint32(out, command.dst_addr);
+                append_uint32(out, command.value);
+                break;
+
+            case BirdCommandType::DMA:
+                out.push_back(static_cast<uint8_t>(CommandType::DMA_WRITE));
+                append_uint32(out, static_cast<uint32_t>(command.data.size() + 8));
+                append_uint32(out, command.dst_addr);
+                append_uint32(out, static_cast<uint32_t>(command.data.size()));
+                out.insert(out.end(), command.data.begin(), command.data.end());
+                break;
+
+            case BirdCommandType::VRD:
+                // Name first, then size and destination (see AppInitializer::parse_binary_sequence)
+                out.push_back(static_cast<uint8_t>(CommandType::VRD_INFO));
+                append_uint32(out, static_cast<uint32_t>(command.vrd_name.size() + 8));
+                out.insert(out.end(), command.vrd_name.begin(), command.vrd_name.end());
+                append_uint32(out, command.value);
+                append_uint32(out, command.dst_addr);
+                break;
+        }
+    }
+}
+
+std::vector<uint8_t> encode_init_template(const std::vector<BirdCommandSequence>& sequences) {
+    size_t total_size = 0;
+    for (const auto& sequence : sequences) {
+        for (const auto& command : sequence.commands) {
+            total_size += encoded_command_size(command);
+        }
+    }
+
+    std::vector<uint8_t> out;
+    out.reserve(total_size);
+    for (const auto& sequence : sequences) {
+        append_init_commands(out, sequence);
+    }
+    return out;
+}
+
+} // namespace app
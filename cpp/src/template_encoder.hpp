@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "app_initializer.hpp"
+#include "bird.hpp"
+
+namespace app {
+
+/**
+ * @brief Append the commands of one sequence in the AppInitializer binary format
+ *
+ * SINGLE becomes APB_WRITE, SAFE_SINGLE becomes SAFE_APB_WRITE, DMA becomes
+ * DMA_WRITE and VRD becomes VRD_INFO.
+ *
+ * @param out Buffer to append to
+ * @param sequence Sequence to encode
+ */
+void append_init_commands(std::vector<uint8_t>& out, const BirdCommandSequence& sequence);
+
+/**
+ * @brief Encode stitched BIRD sequences into a binary sequence file image
+ *
+ * @param sequences Sequences in load order, network switches included
+ * @return std::vector<uint8_t> Binary sequence accepted by AppInitializer
+ */
+std::vector<uint8_t> encode_init_template(const std::vector<BirdCommandSequence>& sequences);
+
+/**
+ * @brief Size in bytes of one encoded command, header included
+ */
+size_t encoded_command_size(const BirdCommand& command);
+
+} // namespace app
@@ -0,0 +1,134 @@
+#include "trace_events.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+namespace app {
+
+namespace {
+
+void put_le(uint8_t* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint64_t get_le(const uint8_t* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+} // namespace
+
+CallbackSink::CallbackSink(std::function<void(const TraceEvent&)> callback)
+    : callback_(std::move(callback)) {
+}
+
+void CallbackSink::emit(TraceEventType type, const std::string& subject, uint64_t a, uint64_t b, uint64_t c) {
+    callback_(TraceEvent{type, subject, {a, b, c}});
+}
+
+SynchronizedSink::SynchronizedSink(TraceSink& sink)
+    : sink_(sink) {
+}
+
+void SynchronizedSink::emit(TraceEventType type, const std::string& subject, uint64_t a, uint64_t b, uint64_t c) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sink_.emit(type, subject, a, b, c);
+}
+
+RingBufferSink::RingBufferSink(size_t capacity)
+    : capacity_(capacity),
+      buffer_(capacity * kRecordSize) {
+    if (capacity == 0) {
+        throw std::runtime_error("Ring buffer capacity must be positive");
+    }
+}
+
+uint32_t RingBufferSink::intern(const std::string& subject) {
+    auto found = subject_ids_.find(subject);
+    if (found != subject_ids_.end()) {
+        ++subject_refs_[found->second];
+        return found->second;
+    }
+    uint32_t id;
+    if (free_subjects_.empty()) {
+        id = static_cast<uint32_t>(subjects_.size());
+        subjects_.push_back(subject);
+        subject_refs_.push_back(1);
+    } else {
+        id = free_subjects_.back();
+        free_subjects_.pop_back();
+        subjects_[id] = subject;
+        subject_refs_[id] = 1;
+    }
+    subject_ids_.emplace(subject, id);
+    return id;
+}
+
+void RingBufferSink::release(uint32_t subject) {
+    if (--subject_refs_[subject] == 0) {
+        subject_ids_.erase(subjects_[subject]);
+        subjects_[subject].clear();
+        free_subjects_.push_back(subject);
+    }
+}
+
+void RingBufferSink::emit(TraceEventType type, const std::string& subject, uint64_t a, uint64_t b, uint64_t c) {
+    uint8_t* record = buffer_.data() + (count_ % capacity_) * kRecordSize;
+    if (count_ >= capacity_) {
+        release(static_cast<uint32_t>(get_le(record + 4, 4)));
+    }
+    put_le(record, static_cast<uint8_t>(type), 4);
+    put_le(record + 4, intern(subject), 4);
+    put_le(record + 8, a, 8);
+    put_le(record + 16, b, 8);
+    put_le(record + 24, c, 8);
+    ++count_;
+}
+
+void RingBufferSink::clear() {
+    count_ = 0;
+    subjects_.clear();
+    subject_ids_.clear();
+    subject_refs_.clear();
+    free_subjects_.clear();
+}
+
+std::vector<uint8_t> RingBufferSink::bytes() const {
+    if (count_ <= capacity_) {
+        return std::vector<uint8_t>(buffer_.begin(), buffer_.begin() + count_ * kRecordSize);
+    }
+    auto split = buffer_.begin() + (count_ % capacity_) * kRecordSize;
+    std::vector<uint8_t> result(split, buffer_.end());
+    result.insert(result.end(), buffer_.begin(), split);
+    return result;
+}
+
+std::vector<TraceEvent> RingBufferSink::events() const {
+    std::vector<uint8_t> data = bytes();
+    return decode(data.data(), data.size(), subjects_);
+}
+
+std::vector<TraceEvent> RingBufferSink::decode(const uint8_t* data, size_t size,
+                                               const std::vector<std::string>& subjects) {
+    if (size % kRecordSize != 0) {
+        throw std::runtime_error("Trace data is not a whole number of records");
+    }
+    std::vector<TraceEvent> events;
+    for (size_t offset = 0; offset < size; offset += kRecordSize) {
+        const uint8_t* record = data + offset;
+        uint64_t subject = get_le(record + 4, 4);
+        if (subject >= subjects.size()) {
+            throw std::runtime_error("Trace record has unknown subject " + std::to_string(subject));
+        }
+        events.push_back(TraceEvent{static_cast<TraceEventType>(record[0]), subjects[subject],
+                                    {get_le(record + 8, 8), get_le(record + 16, 8), get_le(record + 24, 8)}});
+    }
+    return events;
+}
+
+} // namespace app
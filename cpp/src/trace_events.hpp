@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace app {
+
+// Event types (mirror trace_events.EventType)
+enum class TraceEventType : uint8_t {
+    REQUIREMENT_ORDERED = 1,   // subject: allocation id; values: position in the batch
+    ALLOCATED = 2,             // subject: allocation id; values: address, bytes per slice, mappings
+    FORKED = 3,                // subject: allocation id; values: mappings before, mappings after
+    FAILED = 4,                // subject: allocation id; values: size, FailureReason
+    NETWORK_ADDED = 5,         // subject: network type; values: line id
+    MERGED = 6                 // subject: allocation id; values: mappings before, mappings after
+};
+
+enum class FailureReason : uint8_t {
+    NO_ADDRESS = 0,       // Resources resolved, but no common free range fits
+    NO_COMBINATION = 1    // No resource combination can hold the requirement
+};
+
+struct TraceEvent {
+    TraceEventType type;
+    std::string subject;
+    uint64_t values[3];
+};
+
+/**
+ * @brief Receiver of structured trace events
+ *
+ * Emitters hold a TraceSink pointer that is null by default, so tracing
+ * costs one pointer test when it is off.
+ */
+class TraceSink {
+public:
+    virtual ~TraceSink() = default;
+    virtual void emit(TraceEventType type, const std::string& subject, uint64_t a = 0, uint64_t b = 0,
+                      uint64_t c = 0) = 0;
+};
+
+// Passes every event to a callback
+class CallbackSink : public TraceSink {
+public:
+    explicit CallbackSink(std::function<void(const TraceEvent&)> callback);
+    void emit(TraceEventType type, const std::string& subject, uint64_t a = 0, uint64_t b = 0,
+              uint64_t c = 0) override;
+
+private:
+    std::function<void(const TraceEvent&)> callback_;
+};
+
+/**
+ * @brief Passes events to another sink one at a time, so emitters on
+ *        several threads can share a sink that is not thread safe
+ */
+class SynchronizedSink : public TraceSink {
+public:
+    // sink must outlive this one
+    explicit SynchronizedSink(TraceSink& sink);
+    void emit(TraceEventType type, const std::string& subject, uint64_t a = 0, uint64_t b = 0,
+              uint64_t c = 0) override;
+
+private:
+    TraceSink& sink_;
+    std::mutex mutex_;
+};
+
+/**
+ * @brief Keeps the latest events as fixed binary records
+ *
+ * Records are 32 bytes, little endian, the layout of trace_events.RingBufferSink:
+ *
+ *     type u8, 3 padding bytes, subject u32, values 3 x u64
+ *
+ * subject indexes subjects(). Once full, every event overwrites the oldest.
+ * Subjects no kept record refers to give their index to new ones, so
+ * subjects() never has more than capacity entries; free entries are empty.
+ */
+class RingBufferSink : public TraceSink {
+public:
+    static constexpr size_t kRecordSize = 32;
+
+    /**
+     * @throw std::runtime_error if capacity is 0
+     */
+    explicit RingBufferSink(size_t capacity = 4096);
+
+    void emit(TraceEventType type, const std::string& subject, uint64_t a = 0, uint64_t b = 0,
+              uint64_t c = 0) override;
+
+    size_t capacity() const { return capacity_; }
+    uint64_t count() const { return count_; }   // Events emitted so far, kept or not
+    uint64_t dropped() const { return count_ > capacity_ ? count_ - capacity_ : 0; }
+    const std::vector<std::string>& subjects() const { return subjects_; }
+
+    // Kept records, oldest first
+    std::vector<uint8_t> bytes() const;
+    // Kept events, oldest first
+    std::vector<TraceEvent> events() const;
+    void clear();
+
+    /**
+     * @brief Events of binary records, e.g. a dump of a Python ring buffer
+     * @throw std::runtime_error if the data is not whole records or a subject is unknown
+     */
+    static std::vector<TraceEvent> decode(const uint8_t* data, size_t size, const std::vector<std::string>& subjects);
+
+private:
+    size_t capacity_;
+    uint64_t count_ = 0;
+    std::vector<uint8_t> buffer_;
+    std::vector<std::string> subjects_;
+    std::unordered_map<std::string, uint32_t> subject_ids_;
+    std::vector<uint64_t> subject_refs_;    // Kept records per subject
+    std::vector<uint32_t> free_subjects_;
+
+    uint32_t intern(const std::string& subject);
+    void release(uint32_t subject);
+};
+
+} // namespace app
@@ -0,0 +1,116 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include "../src/app_compiler.hpp"
+#include "../src/app_initializer.hpp"
+#include "test_support.hpp"
+
+const std::string kManifest = sample_manifest("ExampleApp", "app", "dataset.bin");
+
+int main() {
+    try {
+        create_sample_binaries("app");
+        create_vrd_data("dataset.bin", 8 * 64);
+
+        std::istringstream input(kManifest);
+        auto manifest = app::parse_manifest(input, "");
+        check(manifest.name == "ExampleApp", "application name");
+        check(manifest.kernels.size() == 2, "two kernels declared");
+        check(manifest.deployments.size() == 3, "three deployments");
+        check(manifest.kernels[0].vrds[0].data_file == "dataset.bin", "VRD data file");
+
+        app::AppCompiler compiler;
+        auto result = compiler.compile(manifest);
+        std::cout << "Compiled " << result.build.sequences.size() << " sequences into "
+                  << result.init_sequence.size() << " bytes" << std::endl;
+
+        check(!result.template_sequence.empty(), "template generated");
+        check(result.init_sequence.size() > result.template_sequence.size(), "VRD data bound into image");
+        check(result.build.dedup_stats.images_seen == 5, "every deployment claims its binaries");
+
+        // Binding the template by hand produces the same image
+        app::AppInitializer initializer(result.template_sequence);
+        check(initializer.has_vrd("G_Kernel.DataSet.0"), "template holds VRD slots");
+        auto data = app::read_binary_file("dataset.bin");
+        for (size_t i = 0; i < 8; ++i) {
+            initializer.load_vrd_data("G_Kernel.DataSet." + std::to_string(i),
+                                      std::vector<uint8_t>(data.begin() + i * 64, data.begin() + (i + 1) * 64));
+        }
+        check(initializer.generate_init_sequence() == result.init_sequence, "manual binding matches compiler");
+
+        // Templates alone do not need VRD data
+        app::CompileOptions template_only;
+        template_only.bind_vrds = false;
+        auto template_result = compiler.compile(manifest, template_only);
+        check(template_result.init_sequence.empty(), "no image without binding");
+        check(template_result.template_sequence == result.template_sequence, "template is deterministic");
+
+        // Each kernel is ready once its last command is loaded; in deployment order
+        // the vcore kernel waits for both copies of G_Kernel and their VRD data
+        check(result.kernel_ready.size() == 3, "one ready offset per deployment");
+        check(result.kernel_ready[2].kernel == "S_Kernel", "deployment order by default");
+        check(result.kernel_ready[0].offset < result.kernel_ready[1].offset &&
+              result.kernel_ready[2].offset == result.init_sequence.size(), "ready offsets follow load order");
+
+        // A weight on the last deployment moves it to the front when prioritized
+        std::istringstream weighted_input(kManifest + "deploy S_Kernel 2 14 2 2 7\n");
+        auto weighted = app::parse_manifest(weighted_input, "");
+        check(weighted.deployments[3].weight == 7, "deployment weight parsed");
+        app::CompileOptions prioritized;
+        prioritized.build.prioritize = true;
+        prioritized.index_commands = true;
+        auto fast_start = compiler.compile(weighted, prioritized);
+        check(fast_start.kernel_ready[0].deployment == 3, "heaviest deployment loads first");
+        check(fast_start.kernel_ready[1].deployment == 0 && fast_start.kernel_ready[3].deployment == 2,
+              "equal weights keep deployment order");
+        check(fast_start.kernel_ready[0].offset < result.kernel_ready[0].offset, "prioritized kernel ready earlier");
+        check(fast_start.index.ordinal_at_offset(fast_start.kernel_ready[0].offset - 1) + 1 ==
+              fast_start.kernel_ready[0].command_count, "ready offset ends on a command boundary");
+        check(compiler.compile(weighted).kernel_ready[3].deployment == 3, "weights ignored unless prioritized");
+
+        // Syntax errors report the line
+        std::istringstream bad_input("application A\nkernel K 3x3\n");
+        bool threw = false;
+        try {
+            app::parse_manifest(bad_input, "");
+        } catch (const std::runtime_error& e) {
+            threw = true;
+        }
+        check(threw, "invalid kernel size is rejected");
+
+        std::istringstream unknown_input("deploy Missing 0 0 2 2\n");
+        threw = false;
+        try {
+            app::parse_manifest(unknown_input, "");
+        } catch (const std::runtime_error& e) {
+            threw = std::string(e.what()).find("Line 1") != std::string::npos;
+        }
+        check(threw, "unknown kernel is reported with its line");
+
+        // Numbers must fit their field instead of wrapping
+        auto manifest_error = [](const std::string& text) -> std::string {
+            std::istringstream bad(text);
+            try {
+                app::parse_manifest(bad, "");
+            } catch (const std::runtime_error& e) {
+                return e.what();
+            }
+            return "";
+        };
+        const std::string kernel = "kernel K 2x2\nbinary K k.ePM\n";
+        check(manifest_error(kernel + "vrd K D -1 64 MSS_Distributed\n").find("Line 3: invalid number") == 0,
+              "negative VRD size rejected");
+        check(manifest_error(kernel + "vrd K D 8 0x100000040 MSS_Distributed\n").find("invalid number") !=
+              std::string::npos, "VRD size beyond 32 bits rejected");
+        check(manifest_error(kernel + "deploy K 2147483648 0 2 2\n").find("invalid number") != std::string::npos,
+              "coordinate beyond int rejected");
+        check(manifest_error(kernel + "deploy K 0 0 2 2 -1\n").find("invalid number") != std::string::npos,
+              "negative weight rejected");
+
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
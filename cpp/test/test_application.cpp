@@ -0,0 +1,137 @@
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include "../src/application.hpp"
+#include "test_support.hpp"
+
+bool same_sequences(const std::vector<app::BirdCommandSequence>& a,
+                    const std::vector<app::BirdCommandSequence>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].description != b[i].description ||
+            a[i].network_type != b[i].network_type ||
+            a[i].commands.size() != b[i].commands.size()) {
+            return false;
+        }
+        for (size_t j = 0; j < a[i].commands.size(); ++j) {
+            const auto& ca = a[i].commands[j];
+            const auto& cb = b[i].commands[j];
+            if (ca.type != cb.type || ca.dst_addr != cb.dst_addr ||
+                ca.value != cb.value || ca.data != cb.data) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+size_t binary_loads(const app::BuildResult& result) {
+    size_t count = 0;
+    for (const auto& sequence : result.sequences) {
+        if (sequence.network_type == app::KernelImage::load_network()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+app::Application create_application(size_t kernel_count) {
+    auto g_pm = std::make_shared<const app::KernelImage>(app::KernelImage::from_file("app_g.vcore.elf.ePM"));
+    auto g_dm = std::make_shared<const app::KernelImage>(app::KernelImage::from_file("app_g.vcore.elf.eDMw"));
+    auto s_pm = std::make_shared<const app::KernelImage>(app::KernelImage::from_file("app_s.ncore.elf.ePM"));
+
+    app::Application application("ExampleApp", app::Grid::chip());
+
+    // 2x2 kernels along the first rows, each with PM and DM
+    for (size_t i = 0; i < kernel_count; ++i) {
+        auto kernel = std::make_shared<app::Kernel>("G_Kernel" + std::to_string(i), app::KernelSize::SIZE_2X2);
+        kernel->add_binary(g_pm);
+        kernel->add_binary(g_dm);
+        kernel->add_vrd(app::VrdComponent{"DataSet", 8, 64, app::AllocationType::MSS_DISTRIBUTED, false});
+        int x = static_cast<int>((i % 8) * 2);
+        int y = static_cast<int>((i / 8) * 2);
+        application.add_kernel(kernel, app::KernelSuperGroup(x, y, 2, 2, app::KernelSize::SIZE_2X2));
+    }
+
+    // Vcore kernel that lists the same PM image twice (as in kernel_config.py)
+    auto kernel_s = std::make_shared<app::Kernel>("S_Kernel", app::KernelSize::ONE_VCORE);
+    kernel_s->add_binary(s_pm);
+    kernel_s->add_binary(s_pm);
+    application.add_kernel(kernel_s, app::KernelSuperGroup(0, 14, 2, 2, app::KernelSize::ONE_VCORE));
+
+    return application;
+}
+
+int main() {
+    try {
+        create_sample_binaries("app");
+
+        auto application = create_application(16);
+
+        app::BuildOptions serial;
+        serial.num_threads = 1;
+        app::BuildOptions parallel;
+        parallel.num_threads = 4;
+
+        auto serial_result = application.build(serial);
+        auto parallel_result = application.build(parallel);
+
+        std::cout << "Generated " << serial_result.sequences.size() << " sequences for "
+                  << application.kernels().size() << " kernels" << std::endl;
+
+        check(same_sequences(serial_result.sequences, parallel_result.sequences),
+              "parallel build matches serial build");
+
+        // Grid settings first, then a network switch before the first kernel block
+        check(serial_result.sequences[0].description == "NOC Broadcast and AXI2AHB Network Configuration",
+              "grid APB settings come first");
+        check(serial_result.sequences[1].description.rfind("AXI2AHB Bridge Switch to", 0) == 0,
+              "network switch precedes the first kernel block");
+
+        // Spans cover every sequence after the grid settings, in order
+        check(serial_result.kernel_spans.size() == application.kernels().size(), "one span per kernel");
+        size_t expected_first = 1;
+        size_t expected_command = serial_result.sequences[0].commands.size();
+        for (const auto& span : serial_result.kernel_spans) {
+            check(span.first_sequence == expected_first, "spans are contiguous");
+            check(span.first_command == expected_command, "command ranges are contiguous");
+            size_t commands = 0;
+            for (size_t i = span.first_sequence; i < span.end_sequence; ++i) {
+                commands += serial_result.sequences[i].commands.size();
+            }
+            check(span.end_command == span.first_command + commands, "command range covers the span");
+            expected_first = span.end_sequence;
+            expected_command = span.end_command;
+        }
+        check(expected_first == serial_result.sequences.size(), "spans reach the end");
+
+        // Kernels on the load network share the G images, and the repeated
+        // vcore PM image is loaded once
+        const auto& dedup = serial_result.dedup_stats;
+        check(dedup.images_emitted == 3 && dedup.images_deduplicated == 15 * 2 + 1, "binaries loaded once per network");
+        check(binary_loads(serial_result) == 3, "one load sequence per emitted image");
+
+        app::BuildOptions no_dedup;
+        no_dedup.deduplicate_binaries = false;
+        auto full_result = application.build(no_dedup);
+        check(binary_loads(full_result) == 16 * 2 + 2, "disabling deduplication loads every image");
+
+        // Unbuilt kernels are rejected
+        app::Application empty_app("Empty", app::Grid::haps());
+        empty_app.add_kernel(std::make_shared<app::Kernel>("NoBinary", app::KernelSize::SIZE_2X2),
+                             app::KernelSuperGroup(0, 0, 2, 2, app::KernelSize::SIZE_2X2));
+        bool threw = false;
+        try {
+            empty_app.build();
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        check(threw, "kernel without binaries is rejected");
+
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,69 @@
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include "../src/binary_dedup.hpp"
+#include "test_support.hpp"
+
+// Helper function to create a small PM image file in the decoder format
+void create_pm_image(const std::string& filename, const std::string& first_word) {
+    std::ofstream file(filename);
+    file << "@000000 " << first_word << "000000000000000000000000\n";
+    file << "@000004 6c0080a1000000004000000000000000\n";
+    file << "@000010 80003003\n";
+}
+
+int main() {
+    try {
+        create_pm_image("dedup_a.vcore.elf.ePM", "79bc0000");
+        create_pm_image("dedup_b.vcore.elf.ePM", "79bc0000");
+        create_pm_image("dedup_c.vcore.elf.ePM", "7a713100");
+
+        auto image_a = std::make_shared<const app::KernelImage>(app::KernelImage::from_file("dedup_a.vcore.elf.ePM"));
+        auto image_b = std::make_shared<const app::KernelImage>(app::KernelImage::from_file("dedup_b.vcore.elf.ePM"));
+        auto image_c = std::make_shared<const app::KernelImage>(app::KernelImage::from_file("dedup_c.vcore.elf.ePM"));
+
+        // Decoding: two contiguous lines unify, the short line is aligned to 16 bytes
+        check(image_a->type() == app::KernelBinaryType::VCORE_PM, "suffix selects VCORE_PM");
+        check(image_a->segments().size() == 2, "two segments after unification");
+        check(image_a->segments()[0].addr == 0x1000, "PM offset applied");
+        check(image_a->segments()[1].addr == 0x1040, "word address converted to bytes");
+        check(image_a->segments()[1].data.size() == 16, "short segment padded to 16 bytes");
+
+        check(image_a->content_hash() == image_b->content_hash(), "identical files hash equal");
+        check(image_a->content_hash() != image_c->content_hash(), "different files hash differently");
+
+        const app::NetworkType network = app::KernelImage::load_network();
+        const app::NetworkType other_network{app::BroadcastType::SUPER_PE_BRCST, app::GridDestinationType::VCORE};
+
+        app::BinaryDeduplicator dedup;
+
+        // Same image twice in one kernel (e.g. PM listed as PM and DM): loaded once
+        auto sequences = dedup.generate_bird_sequences({image_a, image_b});
+        check(sequences.size() == 1, "duplicate image in one kernel loaded once");
+
+        // Another kernel on the same network reuses the resident image
+        check(!dedup.claim(network, image_b), "image reused across kernels on the same network");
+
+        // Another network still needs its own copy
+        check(dedup.claim(other_network, image_a), "other network loads its own copy");
+
+        // Loading different contents over the same range evicts the resident image
+        check(dedup.claim(network, image_c), "different image is loaded");
+        check(dedup.claim(network, image_a), "overwritten image is loaded again");
+
+        const auto& stats = dedup.stats();
+        std::cout << "Images seen: " << stats.images_seen
+                  << ", emitted: " << stats.images_emitted
+                  << ", deduplicated: " << stats.images_deduplicated
+                  << ", bytes saved: " << stats.bytes_saved << std::endl;
+        check(stats.images_seen == 6, "six images offered");
+        check(stats.images_deduplicated == 2, "two loads skipped");
+        check(stats.bytes_saved == 2 * image_a->size_bytes(), "saved bytes match skipped images");
+
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
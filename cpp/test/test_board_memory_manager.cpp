@@ -0,0 +1,127 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../src/board_memory_manager.hpp"
+#include "test_support.hpp"
+
+using app::BoardMemoryManager;
+using app::BoardRequirement;
+using app::DimensionRequirement;
+
+BoardRequirement requirement(const std::string& id, uint64_t size, DimensionRequirement chip,
+                             DimensionRequirement pe = DimensionRequirement::all()) {
+    BoardRequirement req;
+    req.chip = chip;
+    req.requirement.allocation_id = id;
+    req.requirement.size = size;
+    req.requirement.pe = pe;
+    return req;
+}
+
+// Batch over four chips: a buffer everywhere, one per chip pair, per-chip
+// buffers and auto-selected chips
+std::string run_batch(size_t num_threads) {
+    BoardMemoryManager board(4, 2, 1, 2, 8192);
+    for (int chip = 0; chip < 4; ++chip) {
+        for (int i = 0; i < 3; ++i) {
+            board.collect(requirement("c" + std::to_string(chip) + "_" + std::to_string(i), 256 * (i + chip + 1),
+                                      DimensionRequirement::specific(chip),
+                                      i == 1 ? DimensionRequirement::automatic() : DimensionRequirement::all()));
+        }
+    }
+    board.collect(requirement("auto_chip", 1024, DimensionRequirement::automatic()));
+    board.collect(requirement("pair", 512, DimensionRequirement::group(0x6)));
+    board.collect(requirement("everywhere", 128, DimensionRequirement::all()));
+    auto result = board.allocate_all(num_threads);
+    check(result.successful == 15 && result.failed == 0 && result.coordinated == 3, "batch allocated");
+
+    std::string placements;
+    for (const auto& record : board.requirements()) {
+        placements += record.requirement.requirement.allocation_id + "@" + std::to_string(record.address) + ":";
+        for (int chip : record.chips) {
+            placements += std::to_string(chip);
+        }
+        placements += " ";
+    }
+    return placements;
+}
+
+int main() {
+    try {
+        // Requirements over several chips share one address
+        BoardMemoryManager board(4, 2, 1, 2, 4096);
+        check(board.allocate(requirement("global", 1024, DimensionRequirement::all())), "board-wide buffer");
+        check(board.requirements().back().chips.size() == 4 && board.requirements().back().address == 0,
+              "every chip at address 0");
+        check(board.allocate(requirement("chip1", 2048, DimensionRequirement::specific(1))), "chip 1 buffer");
+        check(board.requirements().back().address == 1024 && board.chip(1).requirements().size() == 2,
+              "chip buffers go to the chip's shard");
+        check(board.allocate(requirement("pair", 512, DimensionRequirement::group(0x3))), "chips 0 and 1");
+        check(board.requirements().back().address == 3072, "first address free on both chips");
+        check(board.chip(0).requirements().back().placement.address == 3072, "chip 0 holds the pair at 3072");
+
+        // Auto-selected chips go to the emptiest chip that fits
+        check(board.allocate(requirement("auto", 2048, DimensionRequirement::automatic(),
+                                         DimensionRequirement::automatic())), "auto chip");
+        const auto& automatic = board.requirements().back();
+        check(automatic.chips == std::vector<int>{2} && automatic.address == 1024, "emptiest chip");
+        check(board.chip(2).requirements().back().placement.pe == 0, "PE resolved on the chip");
+        check(!board.allocate(requirement("too_big", 4096, DimensionRequirement::group(0x3))), "no common address");
+        check(!board.requirements().back().fulfilled, "failure recorded");
+
+        auto summary = board.summary();
+        check(summary.requirements == 4 + 1 + 2 + 1 + 1 && summary.fulfilled == 8, "summary over every chip");
+        check(summary.pending == 1, "coordinator failure pending");
+        check(summary.allocated_bytes == (1024 * 4 + 2048 + 512 * 2) * 4 + 2048 * 2, "allocated bytes over the board");
+
+        // Chip batches run in parallel with the same placements
+        std::string sequential = run_batch(1);
+        check(run_batch(4) == sequential, "parallel batch matches the sequential one");
+        check(sequential.rfind("everywhere@0:0123 pair@128:12 ", 0) == 0, "board-wide buffer first");
+
+        bool threw = false;
+        try {
+            board.allocate(requirement("bad_chip", 64, DimensionRequirement::specific(4)));
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        check(threw, "chip out of range rejected");
+        threw = false;
+        try {
+            board.collect(requirement("bad_mask", 64, DimensionRequirement::group(0x10)));
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        check(threw, "chip mask beyond the board rejected");
+
+        // One sink receives the events of every chip's parallel batch
+        BoardMemoryManager traced(8, 2, 1, 2, 1 << 20);
+        app::RingBufferSink ring(1 << 16);
+        traced.set_trace_sink(&ring);
+        for (int chip = 0; chip < 8; ++chip) {
+            for (int i = 0; i < 200; ++i) {
+                traced.collect(requirement("t" + std::to_string(chip) + "_" + std::to_string(i), 64,
+                                           DimensionRequirement::specific(chip), DimensionRequirement::automatic()));
+            }
+        }
+        check(traced.allocate_all(8).successful == 1600, "traced batch allocated");
+        size_t allocated = 0;
+        for (const auto& event : ring.events()) {
+            allocated += event.type == app::TraceEventType::ALLOCATED ? 1 : 0;
+        }
+        check(allocated == 1600 && ring.dropped() == 0, "every chip's allocations traced");
+        uint64_t emitted = ring.count();
+        traced.set_trace_sink(nullptr);
+        check(traced.allocate(requirement("untraced", 64, DimensionRequirement::all())) && ring.count() == emitted,
+              "sink unset on every chip");
+
+        auto profiled = BoardMemoryManager::from_profile(app::TargetProfile::haps(), 2);
+        check(profiled.chip_count() == 2 && profiled.chip(1).pe_count() == 8, "chips with the profile's geometry");
+
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
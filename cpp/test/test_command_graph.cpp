@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include "../src/application.hpp"
+#include "../src/command_graph.hpp"
+#include "test_support.hpp"
+
+bool has_edge(const app::CommandGraph& graph, size_t from, size_t to) {
+    const auto& preds = graph.predecessors(to);
+    return std::find(preds.begin(), preds.end(), from) != preds.end();
+}
+
+int main() {
+    try {
+        // Hand-built blocks: two deployments, a shared global write and a barrier
+        const app::NetworkType direct{app::BroadcastType::DIRECT, app::GridDestinationType::APB};
+        const app::NetworkType mss{app::BroadcastType::SUPER_MSS_BRCST, app::GridDestinationType::MSS};
+
+        app::BuildResult build;
+        build.sequences.resize(8, app::BirdCommandSequence{"", mss, {}});
+        build.sequences[0] = app::BirdCommandSequence{"Config", direct, {}};
+        build.sequences[0].add_single_command(0x100, 1, true);                            // 0: barrier
+        build.sequences[1] = app::BirdCommandSequence{"Switch", direct, {}};             // 1: switch to MSS
+        build.sequences[2].add_dma_command(0x1000, std::vector<uint8_t>(32, 0));          // 2: deployment 0
+        build.sequences[3].add_dma_command(0x1000, std::vector<uint8_t>(32, 0));          // 3: deployment 1, same address
+        build.sequences[4].add_dma_command(0x1010, std::vector<uint8_t>(16, 0));          // 4: deployment 0, overlaps 2
+        build.sequences[5].add_dma_command(0x1020, std::vector<uint8_t>(16, 0));          // 5: deployment 0, disjoint
+        build.sequences[6].add_vrd_command(0x1018, 16, "slot");                           // 6: global, overlaps 2, 3, 4, 5
+        build.sequences[7].add_single_command(0x2000, 1, true);                           // 7: global barrier
+        build.network_switches = {1};
+        build.kernel_spans = {
+            app::KernelSpan{0, 1, 3, 0, 0},
+            app::KernelSpan{1, 3, 4, 0, 0},
+            app::KernelSpan{0, 4, 6, 0, 0}
+        };
+
+        auto accesses = app::sequence_accesses(build, 4);
+        check(accesses.writes.size() == 1 && accesses.writes[0].scope == 0 && accesses.writes[0].begin == 0x1010 &&
+              accesses.writes[0].end == 0x1020, "DMA write range scoped to its deployment");
+        check(accesses.reads.size() == 1 && accesses.reads[0].space == app::AccessSpace::BRIDGE, "bridge read");
+        check(app::sequence_accesses(build, 0).barrier, "SAFE_SINGLE makes a barrier");
+        check(!app::sequence_accesses(build, 1).barrier && app::sequence_accesses(build, 1).idempotent,
+              "network switches are idempotent, not barriers");
+
+        auto graph = app::CommandGraph::build(build);
+        check(graph.size() == 8, "one node per sequence");
+        check(has_edge(graph, 0, 1) && has_edge(graph, 0, 2) && has_edge(graph, 0, 3), "barrier precedes everything");
+        check(has_edge(graph, 1, 2) && has_edge(graph, 1, 3), "sequences wait for their network switch");
+        check(!has_edge(graph, 2, 3), "deployments do not conflict");
+        check(has_edge(graph, 2, 4) && !has_edge(graph, 2, 5), "overlapping writes are ordered, disjoint ones not");
+        check(has_edge(graph, 3, 6) && has_edge(graph, 4, 6) && has_edge(graph, 5, 6),
+              "global writes conflict with every deployment");
+        check(!has_edge(graph, 2, 6), "only the last writer of a range is a dependency");
+        for (size_t node = 1; node < 7; ++node) {
+            check(has_edge(graph, node, 7), "barrier waits for every block since the last barrier");
+        }
+        check(graph.depth() == 6, "critical path: config, switch, 2, 4, 6, barrier");
+        auto levels = graph.parallel_levels();
+        check(levels[2] == std::vector<size_t>({2, 3, 5}), "independent blocks share a level");
+
+        // Legal reorderings
+        check(graph.is_legal_order(graph.topological_order()), "default order is legal");
+        check(graph.topological_order() == std::vector<size_t>({0, 1, 2, 3, 4, 5, 6, 7}), "ties keep stitched order");
+        std::vector<uint32_t> priority(8, 0);
+        priority[5] = 3;
+        priority[3] = 2;
+        auto prioritized = graph.topological_order(priority);
+        check(prioritized == std::vector<size_t>({0, 1, 5, 3, 2, 4, 6, 7}), "ready blocks start by priority");
+        check(!graph.is_legal_order({0, 1, 4, 2, 3, 5, 6, 7}), "overlapping writes cannot swap");
+
+        // A real build: kernels on disjoint supergroups only meet at the grid barrier
+        create_sample_image("app_g.vcore.elf.ePM", "79bc0000");
+        auto g_pm = std::make_shared<const app::KernelImage>(app::KernelImage::from_file("app_g.vcore.elf.ePM"));
+        app::Application application("GraphApp", app::Grid::chip());
+        for (int i = 0; i < 4; ++i) {
+            auto kernel = std::make_shared<app::Kernel>("K" + std::to_string(i), app::KernelSize::SIZE_2X2);
+            kernel->add_binary(g_pm);
+            kernel->add_vrd(app::VrdComponent{"DataSet", 8, 64, app::AllocationType::MSS_DISTRIBUTED, false});
+            application.add_kernel(kernel, app::KernelSuperGroup(i * 2, 0, 2, 2, app::KernelSize::SIZE_2X2));
+        }
+        auto result = application.build();
+        auto app_graph = app::CommandGraph::build(result);
+        check(app_graph.size() == result.sequences.size(), "graph covers the build");
+        check(app_graph.is_legal_order(app_graph.topological_order()), "stitched order is legal");
+        check(app_graph.depth() < result.sequences.size() / 2, "kernel blocks load in parallel");
+        const auto& first = result.kernel_spans[0];
+        const auto& second = result.kernel_spans[1];
+        for (size_t a = first.first_sequence; a < first.end_sequence; ++a) {
+            for (size_t b = second.first_sequence; b < second.end_sequence; ++b) {
+                bool a_switch = std::binary_search(result.network_switches.begin(), result.network_switches.end(), a);
+                check(a_switch || !has_edge(app_graph, a, b), "no dependency between kernel blocks");
+            }
+        }
+
+        // Binary loads share one network, so they conflict across deployments
+        app::BuildResult loads;
+        loads.sequences.resize(2, app::BirdCommandSequence{"", app::KernelImage::load_network(), {}});
+        loads.sequences[0].add_dma_command(0x1000, std::vector<uint8_t>(16, 1));
+        loads.sequences[1].add_dma_command(0x1000, std::vector<uint8_t>(16, 2));
+        loads.kernel_spans = {app::KernelSpan{0, 0, 1, 0, 1}, app::KernelSpan{1, 1, 2, 1, 2}};
+        check(has_edge(app::CommandGraph::build(loads), 0, 1), "binary loads ordered across deployments");
+
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "../src/app_initializer.hpp"
+#include "../src/command_index.hpp"
+#include "../src/template_encoder.hpp"
+#include "test_support.hpp"
+
+bool same_entries(const app::CommandIndex& a, const app::CommandIndex& b) {
+    if (a.size() != b.size() || a.sequence_size() != b.sequence_size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].offset != b[i].offset || a[i].type != b[i].type || a[i].length != b[i].length ||
+            a[i].dst_addr != b[i].dst_addr || a[i].dst_size != b[i].dst_size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    try {
+        // 100 register writes, DMA blocks at 0x10000 + 0x100 * n and one VRD slot
+        app::BirdCommandSequence seq{
+            "Test",
+            app::NetworkType{app::BroadcastType::SUPER_MSS_BRCST, app::GridDestinationType::APB},
+            {}
+        };
+        for (uint32_t i = 0; i < 100; ++i) {
+            seq.add_single_command(0x1000 + i * 4, i);
+            if (i % 10 == 0) {
+                seq.add_dma_command(0x10000 + i * 0x10, std::vector<uint8_t>(64, static_cast<uint8_t>(i)));
+            }
+        }
+        seq.add_vrd_command(0x20000, 32, "slot");
+        seq.add_single_command(0x1000, 0xFFFF);
+
+        app::AppInitializer initializer(app::encode_init_template({seq}));
+        initializer.load_vrd_data("slot", std::vector<uint8_t>(32, 0x5A));
+
+        app::GenerateOptions options;
+        options.checksum_trailer = true;
+        app::CommandIndex emitted;
+        auto image = initializer.generate_init_sequence(options, nullptr, &emitted);
+        auto scanned = app::CommandIndex::build(image.data(), image.size());
+        std::cout << "Indexed " << emitted.size() << " commands in " << image.size() << " bytes" << std::endl;
+
+        check(emitted.size() == 113, "one entry per command and the trailer");
+        check(same_entries(emitted, scanned), "emitted index matches a scan of the image");
+
+        // Random access by ordinal and offset
+        const auto& vrd = emitted.at(110);
+        check(vrd.type == app::CommandType::DMA_WRITE && vrd.dst_addr == 0x20000 && vrd.dst_size == 32,
+              "VRD slot indexed as its DMA write");
+        check(emitted.ordinal_at_offset(vrd.offset + 7) == 110, "offset inside a command");
+        check(emitted[112].type == app::CommandType::IMAGE_CHECKSUM, "trailer indexed last");
+        auto range = emitted.byte_range(110, 113);
+        check(range.first == vrd.offset && range.second == image.size(), "byte range of the tail");
+
+        // Address queries: register 0x1000 is written twice, DMA blocks are 0x40 bytes every 0xA0
+        auto writes = emitted.find_writes(0x1000, 0x1004);
+        check(writes.size() == 2 && writes[0] == 0 && writes[1] == 111,
+              "both writes of a register found in order");
+        check(emitted[writes[1]].dst_addr == 0x1000, "last write is the final register write");
+        check(emitted.find_writes(0x10030, 0x10031).size() == 1, "DMA range found by an inner address");
+        check(emitted.find_writes(0x10040, 0x100A0).empty(), "interval between two blocks");
+        check(emitted.find_writes(0x10040, 0x100A1).size() == 1, "only blocks touching the interval");
+        check(emitted.find_writes(0x30000, 0x40000).empty(), "no writes in an empty interval");
+        check(emitted.find_writes(0, 0xFFFFFFFF).size() == 112, "every writing command found");
+
+        bool threw = false;
+        try {
+            emitted.at(113);
+        } catch (const std::out_of_range&) {
+            threw = true;
+        }
+        check(threw, "ordinal past the end rejected");
+
+        // Indexes can be stored next to the image
+        auto restored = app::CommandIndex::deserialize(emitted.serialize());
+        check(same_entries(emitted, restored), "serialization round trip");
+        check(restored.find_writes(0x1000, 0x1004) == writes, "restored index answers queries");
+
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
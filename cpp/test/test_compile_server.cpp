@@ -0,0 +1,168 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+#include <thread>
+#include <sys/mman.h>
+#include "../src/compile_server.hpp"
+#include "test_support.hpp"
+
+int main() {
+    try {
+        create_sample_image("srv_g.vcore.elf.ePM", "79bc0000");
+        create_sample_image("srv_s.ncore.elf.ePM", "07808000");
+        create_vrd_data("srv_dataset.bin", 8 * 64);
+        {
+            std::ofstream manifest("srv_app.manifest");
+            manifest << "application ServerApp\n"
+                     << "grid chip\n"
+                     << "kernel G 2x2\n"
+                     << "binary G srv_g.vcore.elf.ePM\n"
+                     << "vrd G DataSet 8 64 PE_Distributed srv_dataset.bin\n"
+                     << "kernel S 1Vcore\n"
+                     << "binary S srv_s.ncore.elf.ePM\n"
+                     << "deploy G 0 0 2 2\n"
+                     << "deploy G 4 4 2 2\n"
+                     << "deploy S 0 14 2 2\n";
+        }
+        std::string manifest_path = std::filesystem::absolute("srv_app.manifest").string();
+
+        // Reference image compiled in-process
+        app::AppCompiler local;
+        auto expected = local.compile(app::load_manifest(manifest_path)).init_sequence;
+
+        app::CompileServer server("compile_server_test.sock", nullptr, 2);
+        server.start();
+
+        app::CompileRequest request;
+        request.manifest_path = manifest_path;
+        request.num_threads = 1;
+
+        // First request warms the caches, concurrent ones are served from them
+        auto first = app::request_compile(server.socket_path(), request);
+        check(first.ok, "first request succeeds: " + first.message);
+        check(first.image.read() == expected, "served image matches local compile");
+        check(first.image.generation() == 1, "first image is generation 1");
+        check(first.image.map().header().payload_size == expected.size(), "header records payload size");
+
+        // Generating in place and copying produce the same image
+        app::CompileResult bound;
+        auto initializer = local.bind(app::load_manifest(manifest_path), app::BuildOptions(), &bound);
+        auto in_place = app::SharedImage::generate(initializer, 7);
+        auto copied = app::SharedImage::create(expected, 7);
+        check(in_place.read() == expected, "in-place image matches");
+        check(in_place.checksum() == copied.checksum() && in_place.generation() == 7, "same header");
+
+        // Unsealed descriptors are rejected
+        bool threw = false;
+        try {
+            app::SharedImage::adopt(memfd_create("unsealed", MFD_CLOEXEC));
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        check(threw, "unsealed memfd rejected");
+
+        std::vector<std::vector<uint8_t>> images(4);
+        std::vector<std::thread> clients;
+        for (size_t i = 0; i < images.size(); ++i) {
+            clients.emplace_back([&, i] {
+                auto response = app::request_compile(server.socket_path(), request);
+                if (response.ok) {
+                    images[i] = response.image.read();
+                }
+            });
+        }
+        for (auto& client : clients) {
+            client.join();
+        }
+        for (const auto& image : images) {
+            check(image == expected, "concurrent request matches local compile");
+        }
+        check(app::request_compile(server.socket_path(), request).image.generation() == 6,
+              "generations increase per image");
+
+        auto stats = server.cache()->stats();
+        std::cout << "Templates: " << stats.template_hits << " hits, " << stats.template_misses
+                  << " misses" << std::endl;
+        check(stats.template_misses == 1 && stats.template_hits == 5, "template built once");
+        check(stats.image_misses == 2, "each binary decoded once");
+        check(stats.apb_misses == 3 && stats.apb_hits == 0, "APB settings generated once per deployment");
+        check(stats.apb_entries == 3 && stats.apb_evictions == 0, "APB settings kept per deployment");
+
+        // A changed binary invalidates the template
+        create_sample_image("srv_s.ncore.elf.ePM", "07808001");
+        std::filesystem::last_write_time("srv_s.ncore.elf.ePM",
+            std::filesystem::last_write_time("srv_s.ncore.elf.ePM") + std::chrono::seconds(1));
+        auto changed = app::request_compile(server.socket_path(), request);
+        check(changed.ok && changed.image.read() != expected, "changed binary is recompiled");
+        check(server.cache()->stats().image_misses == 3, "only the changed binary is decoded again");
+        check(server.cache()->stats().apb_hits == 3, "rebuild reuses memoized APB settings");
+
+        // A target limiting DMA bursts gets normalized images from the server, resume and verify alike
+        {
+            std::ofstream profile("srv_burst.profile");
+            profile << "base chip\nname burst\ndma_burst 64\n";
+        }
+        auto within_burst = [](const std::vector<uint8_t>& image) {
+            auto index = app::CommandIndex::build(image.data(), image.size());
+            for (const auto& entry : index.entries()) {
+                if (entry.type == app::CommandType::DMA_WRITE && entry.dst_size > 64) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        app::CompileRequest burst = request;
+        burst.target = std::filesystem::absolute("srv_burst.profile").string();
+        burst.checksum_trailer = true;
+        auto burst_manifest = app::load_manifest(manifest_path);
+        burst_manifest.target = burst.target;
+        app::CompileOptions burst_options;
+        burst_options.generate.checksum_trailer = true;
+        auto normalized = local.compile(burst_manifest, burst_options);
+        check(normalized.dma_stats.split > 0 && within_burst(normalized.init_sequence), "local image normalized");
+
+        auto served_burst = app::request_compile(server.socket_path(), burst);
+        check(served_burst.ok && served_burst.image.read() == normalized.init_sequence,
+              "served image normalized to the target's bursts");
+        burst.target.clear();
+        burst.dma.max_burst = 64;
+        check(app::request_compile(server.socket_path(), burst).image.read() == normalized.init_sequence,
+              "DMA rules forwarded to the server");
+
+        auto resumed = local.resume(burst_manifest, 1, burst_options);
+        check(resumed.dma_stats.split > 0 && within_burst(resumed.init_sequence), "resumed image normalized");
+        check(app::verify_init_sequence(resumed.init_sequence.data(), resumed.init_sequence.size()).ok,
+              "resumed image has a valid trailer");
+
+        auto verified = local.verify(burst_manifest, normalized.init_sequence.data(), normalized.init_sequence.size());
+        check(verified.ok && verified.has_trailer, "normalized image verifies: " + verified.error);
+        auto corrupted = normalized.init_sequence;
+        corrupted[corrupted.size() / 2] ^= 0xFF;
+        check(!local.verify(burst_manifest, corrupted.data(), corrupted.size()).ok, "corrupted image rejected");
+
+        // Compile errors are reported, not fatal to the server
+        request.manifest_path = "/nonexistent/app.manifest";
+        auto failed = app::request_compile(server.socket_path(), request);
+        check(!failed.ok && failed.message.find("Failed to open manifest") != std::string::npos,
+              "missing manifest reported");
+
+        server.stop();
+        check(!std::filesystem::exists("compile_server_test.sock"), "socket removed on stop");
+
+        // A bounded memo drops the least recently used APB settings
+        app::CompileServer bounded("compile_server_test.sock", std::make_shared<app::CompileCache>(64, 2), 1);
+        bounded.start();
+        request.manifest_path = manifest_path;
+        auto evicted = app::request_compile(bounded.socket_path(), request);
+        check(evicted.ok && evicted.image.read() == changed.image.read(), "bounded memo compiles the same image");
+        auto bounded_stats = bounded.cache()->stats();
+        check(bounded_stats.apb_entries == 2 && bounded_stats.apb_evictions == 1, "APB memo held to its capacity");
+        bounded.stop();
+
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "../src/app_compiler.hpp"
+#include "../src/cost_model.hpp"
+#include "../src/dma_normalizer.hpp"
+#include "../src/stream_partitioner.hpp"
+#include "../src/template_encoder.hpp"
+#include "test_support.hpp"
+
+const std::string kManifest = sample_manifest("CostApp", "cost", "cost_dataset.bin");
+
+// Setup, kernels and unattributed commands partition the total
+void check_breakdown(const app::LoadEstimate& estimate, const std::string& label) {
+    uint64_t by_type = 0;
+    for (const auto& type : estimate.by_type) {
+        by_type += type.second.ns;
+    }
+    uint64_t by_network = estimate.unattributed.ns;
+    for (const auto& network : estimate.by_network) {
+        by_network += network.second.ns;
+    }
+    uint64_t parts = estimate.setup.ns + estimate.unattributed.ns;
+    uint64_t previous_ready = 0;
+    for (const auto& kernel : estimate.kernels) {
+        parts += kernel.cost.ns;
+        check(kernel.ready_ns > previous_ready, label + ": kernels get ready in load order");
+        previous_ready = kernel.ready_ns;
+    }
+    check(by_type == estimate.total.ns, label + ": types add up to the total");
+    check(by_network == estimate.total.ns, label + ": networks add up to the total");
+    check(parts == estimate.total.ns, label + ": setup, kernels and the rest add up to the total");
+    check(estimate.switches.ns > 0 && estimate.switches.ns < parts, label + ": switches are part of the kernels");
+}
+
+int main() {
+    try {
+        create_sample_binaries("cost");
+        create_vrd_data("cost_dataset.bin", 8 * 64);
+
+        // Per-command costs follow the profile: 1 ns per link byte, 2 ns per DMA byte
+        app::TargetProfile profile;
+        profile.command_overhead_ns = 10;
+        profile.apb_write_ns = 5;
+        profile.safe_write_ns = 100;
+        profile.switch_ns = 1000;
+        profile.link_mbps = 1000;
+        profile.dma_mbps = 500;
+        app::CostModel model(profile);
+        check(model.command_ns(app::CommandEntry{0, app::CommandType::APB_WRITE, 8, 0x100, 4}) == 10 + 13 + 5,
+              "APB write cost");
+        check(model.command_ns(app::CommandEntry{0, app::CommandType::SAFE_APB_WRITE, 8, 0x100, 4}) ==
+              10 + 13 + 5 + 100, "safe write waits for completion");
+        check(model.command_ns(app::CommandEntry{0, app::CommandType::DMA_WRITE, 72, 0x1000, 64}) ==
+              10 + 13 + 128, "DMA payload at the slower of link and DMA engine");
+        check(model.command_ns(app::CommandEntry{0, app::CommandType::CHECKPOINT, 4, 0, 0}) == 10 + 9,
+              "other commands cost overhead and link time");
+
+        std::istringstream input(kManifest);
+        auto manifest = app::parse_manifest(input, "");
+        app::AppCompiler compiler;
+        app::CompileOptions options;
+        options.estimate_load = true;
+        options.generate.checksum_trailer = true;
+        auto result = compiler.compile(manifest, options);
+        const auto& estimate = result.load_estimate;
+        check(estimate.total.bytes == result.init_sequence.size(), "every image byte is costed");
+        check(estimate.kernels.size() == 3 && estimate.kernels[2].deployment == 2, "one entry per kernel");
+        check(estimate.unattributed.commands == 1, "trailer has no build sequence");
+        check(estimate.kernels.back().ready_ns + estimate.unattributed.ns == estimate.total.ns,
+              "last kernel ready before the trailer");
+        check_breakdown(estimate, "chip");
+
+        auto type_only = app::CostModel(app::TargetProfile::chip()).estimate(
+            result.init_sequence.data(), result.init_sequence.size());
+        check(estimate.total.ns - type_only.total.ns ==
+              app::TargetProfile::chip().switch_ns * result.build.network_switches.size(),
+              "build attribution only adds switch settling");
+
+        // Slower targets take longer for the same image
+        manifest.target = "haps";
+        manifest.grid = "chip";
+        auto haps = compiler.compile(manifest, options);
+        check(haps.init_sequence == result.init_sequence, "same image on a chip-sized haps target");
+        check(haps.load_estimate.total.ns > estimate.total.ns, "haps loads slower");
+        manifest.target.clear();
+        manifest.grid.clear();
+
+        // Normalized images are attributed through the normalizer's mapping
+        options.dma.max_burst = 16;
+        auto normalized = compiler.compile(manifest, options);
+        check(normalized.load_estimate.total.bytes == normalized.init_sequence.size(), "normalized image costed");
+        check(normalized.load_estimate.by_type.at(app::CommandType::DMA_WRITE).commands ==
+              normalized.dma_stats.output_dmas, "costed DMAs are the normalized ones");
+        check(normalized.load_estimate.kernels.size() == 3, "kernels attributed after normalization");
+        check_breakdown(normalized.load_estimate, "normalized");
+        check(normalized.load_estimate.total.ns > estimate.total.ns, "small bursts cost more overhead");
+
+        // A DMA merged across sequences counts towards the last one merged
+        const app::NetworkType mss{app::BroadcastType::SUPER_MSS_BRCST, app::GridDestinationType::MSS};
+        app::BuildResult adjacent;
+        adjacent.sequences.resize(2, app::BirdCommandSequence{"", mss, {}});
+        adjacent.sequences[0].add_dma_command(0x1000, std::vector<uint8_t>(32, 1));
+        adjacent.sequences[1].add_dma_command(0x1020, std::vector<uint8_t>(32, 2));
+        adjacent.kernel_spans = {app::KernelSpan{0, 0, 1, 0, 1}, app::KernelSpan{1, 1, 2, 1, 2}};
+        auto adjacent_image = app::encode_init_template(adjacent.sequences);
+        auto merged = app::normalize_dma(adjacent_image.data(), adjacent_image.size(), app::DmaRules());
+        check(merged.stats.merged == 1 && merged.stats.output_dmas == 1, "DMAs merged across sequences");
+        auto merged_estimate = model.estimate(adjacent, adjacent_image.data(), adjacent_image.size(), merged);
+        check(merged_estimate.kernels[0].cost.commands == 0 && merged_estimate.kernels[1].cost.commands == 1 &&
+              merged_estimate.kernels[1].cost.bytes == merged.data.size(),
+              "merged DMA attributed to the second kernel");
+
+        // Streams are costed by command type
+        options.dma = app::DmaOptions();
+        options.generate.checksum_trailer = false;
+        auto plain = compiler.compile(manifest, options);
+        auto streams = app::partition_image(plain.build, plain.init_sequence.data(), plain.init_sequence.size());
+        uint64_t longest = 0;
+        for (const auto& stream : streams.streams) {
+            longest = std::max(longest, model.estimate(stream.data.data(), stream.data.size()).total.ns);
+        }
+        check(longest < model.estimate(plain.build, plain.init_sequence.data(), plain.init_sequence.size()).total.ns,
+              "longest stream is shorter than the whole image");
+
+        // Images must match the build they are attributed to
+        bool threw = false;
+        try {
+            model.estimate(plain.build, plain.init_sequence.data(), plain.init_sequence.size() / 2);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        check(threw, "truncated image rejected");
+
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,135 @@
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include "../src/dma_normalizer.hpp"
+#include "../src/image_verifier.hpp"
+#include "../src/template_encoder.hpp"
+#include "test_support.hpp"
+
+// Memory contents after loading every DMA of an image
+std::map<uint32_t, uint8_t> load_memory(const std::vector<uint8_t>& image) {
+    std::map<uint32_t, uint8_t> memory;
+    auto index = app::CommandIndex::build(image.data(), image.size());
+    for (const auto& entry : index.entries()) {
+        if (entry.type == app::CommandType::DMA_WRITE) {
+            for (uint32_t i = 0; i < entry.dst_size; ++i) {
+                memory[entry.dst_addr + i] = image[entry.offset + 13 + i];
+            }
+        }
+    }
+    return memory;
+}
+
+std::vector<uint8_t> pattern(size_t size, uint8_t seed) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<uint8_t>(seed + i * 7);
+    }
+    return data;
+}
+
+// Append a DMA_WRITE without the 16-byte restriction of add_dma_command
+void append_dma(std::vector<uint8_t>& image, uint32_t dst, const std::vector<uint8_t>& data) {
+    auto put = [&](uint32_t value) {
+        for (int i = 0; i < 4; ++i) image.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    };
+    image.push_back(static_cast<uint8_t>(app::CommandType::DMA_WRITE));
+    put(static_cast<uint32_t>(data.size() + 8));
+    put(dst);
+    put(static_cast<uint32_t>(data.size()));
+    image.insert(image.end(), data.begin(), data.end());
+}
+
+int main() {
+    try {
+        // Three back-to-back DMAs to contiguous memory, a register write, then
+        // an unaligned VRD-sized transfer and an oversized one
+        app::BirdCommandSequence seq{
+            "Test",
+            app::NetworkType{app::BroadcastType::SUPER_MSS_BRCST, app::GridDestinationType::MSS},
+            {}
+        };
+        seq.add_dma_command(0x1000, pattern(16, 1));
+        seq.add_dma_command(0x1010, pattern(32, 2));
+        seq.add_dma_command(0x1030, pattern(16, 3));
+        seq.add_single_command(0x50000000, 7);
+        auto image = app::encode_init_template({seq});
+        append_dma(image, 0x2004, pattern(40, 4));
+        append_dma(image, 0x4000, pattern(1024, 5));
+
+        app::DmaRules rules;
+        rules.max_burst = 256;
+        app::ImageIntegrity integrity;
+        app::CommandIndex index;
+        auto normalized = app::normalize_dma(image.data(), image.size(), rules, &integrity, &index);
+
+        check(normalized.stats.input_dmas == 5, "input DMAs counted");
+        check(normalized.stats.merged == 2, "contiguous DMAs merged");
+        check(load_memory(normalized.data) == load_memory(image), "memory contents unchanged");
+        for (const auto& entry : index.entries()) {
+            if (entry.type != app::CommandType::DMA_WRITE) {
+                continue;
+            }
+            check(entry.dst_size <= rules.max_burst, "no DMA exceeds the burst");
+            bool aligned = entry.dst_addr % 16 == 0 && entry.dst_size % 16 == 0;
+            bool unaligned_piece = entry.dst_addr == 0x2004 || entry.dst_addr == 0x2020;
+            check(aligned || unaligned_piece, "only the head and tail of unaligned transfers stay unaligned");
+        }
+        // Merged run of 64 bytes, head/body/tail of the unaligned one, 4 bursts of the big one
+        check(normalized.stats.output_dmas == 1 + 3 + 4, "expected transfer count");
+        check(normalized.stats.split == 2, "unaligned and oversized transfers split");
+
+        // Positions of input commands map onto the output
+        check(normalized.end_command[2] == 0 && normalized.end_command[0] == 0, "merged inputs end with the run");
+        check(normalized.end_command[3] == 1, "register write follows the run");
+        check(normalized.end_offset[5] == normalized.data.size(), "last input ends the image");
+
+        // Checksums and index describe the output
+        check(index.sequence_size() == normalized.data.size(), "index covers the output");
+        check(app::verify_init_sequence(normalized.data.data(), normalized.data.size(),
+                                        &integrity.command_checksums).ok, "command checksums match");
+
+        // Padding widens unaligned transfers instead
+        rules.pad = true;
+        rules.pad_byte = 0xEE;
+        auto padded = app::normalize_dma(image.data(), image.size(), rules);
+        check(padded.stats.padded == 1 && padded.stats.pad_bytes == 8, "unaligned transfer padded to 48 bytes");
+        auto padded_memory = load_memory(padded.data);
+        check(padded_memory.at(0x2000) == 0xEE && padded_memory.at(0x202C) == 0xEE, "pad byte around the data");
+        for (const auto& entry : app::CommandIndex::build(padded.data.data(), padded.data.size()).entries()) {
+            if (entry.type == app::CommandType::DMA_WRITE) {
+                check(entry.dst_addr % 16 == 0 && entry.dst_size % 16 == 0, "every padded transfer aligned");
+            }
+        }
+
+        // Without merging or bursts only alignment applies; trailers are regenerated
+        std::vector<uint8_t> with_trailer = image;
+        {
+            app::AppInitializer initializer(image);
+            app::GenerateOptions options;
+            options.checksum_trailer = true;
+            with_trailer = initializer.generate_init_sequence(options);
+        }
+        app::DmaRules no_merge;
+        no_merge.merge = false;
+        auto plain = app::normalize_dma(with_trailer.data(), with_trailer.size(), no_merge);
+        check(plain.stats.merged == 0 && plain.stats.output_dmas == 5 + 2, "only the unaligned DMA split");
+        check(app::verify_init_sequence(plain.data.data(), plain.data.size(), nullptr, true).ok, "trailer regenerated");
+
+        bool threw = false;
+        try {
+            app::DmaRules bad;
+            bad.max_burst = 100;
+            app::normalize_dma(image.data(), image.size(), bad);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        check(threw, "burst must be a multiple of the alignment");
+
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,131 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "../src/app_initializer.hpp"
+#include "../src/crc32c.hpp"
+#include "../src/image_verifier.hpp"
+#include "../src/template_encoder.hpp"
+#include "test_support.hpp"
+
+// Template with register writes, a DMA block and one VRD slot
+app::AppInitializer create_initializer() {
+    app::BirdCommandSequence seq{
+        "Test",
+        app::NetworkType{app::BroadcastType::SUPER_MSS_BRCST, app::GridDestinationType::APB},
+        {}
+    };
+    seq.add_single_command(0x1000, 0x5000);
+    seq.add_single_command(0x1004, 0x0001, true);
+    seq.add_dma_command(0x2000, std::vector<uint8_t>(32, 0xAB));
+    seq.add_vrd_command(0x3000, 16, "slot");
+    seq.add_single_command(0x1008, 0x0002);
+
+    app::AppInitializer initializer(app::encode_init_template({seq}));
+    std::vector<uint8_t> vrd_data(16);
+    for (size_t i = 0; i < vrd_data.size(); ++i) {
+        vrd_data[i] = static_cast<uint8_t>(i);
+    }
+    initializer.load_vrd_data("slot", vrd_data);
+    return initializer;
+}
+
+int main() {
+    try {
+        // Reference value of the Castagnoli polynomial
+        const std::string digits = "123456789";
+        const auto* digit_bytes = reinterpret_cast<const uint8_t*>(digits.data());
+        check(app::crc32c(0, digit_bytes, digits.size()) == 0xE3069283, "CRC32C check value");
+        check(app::crc32c_software(0, digit_bytes, digits.size()) == 0xE3069283, "software CRC32C check value");
+        std::cout << "CRC32C hardware acceleration: "
+                  << (app::crc32c_hardware_accelerated() ? "yes" : "no") << std::endl;
+
+        // Both implementations agree for every length and split point
+        std::vector<uint8_t> noise(1000);
+        for (size_t i = 0; i < noise.size(); ++i) {
+            noise[i] = static_cast<uint8_t>(i * 131 + 7);
+        }
+        for (size_t length = 0; length < 40; ++length) {
+            check(app::crc32c(0, noise.data() + 3, length) == app::crc32c_software(0, noise.data() + 3, length),
+                  "hardware and software agree");
+        }
+        uint32_t split = app::crc32c(app::crc32c(0, noise.data(), 333), noise.data() + 333, noise.size() - 333);
+        check(split == app::crc32c(0, noise.data(), noise.size()), "checksums extend across calls");
+
+        auto initializer = create_initializer();
+        auto plain = initializer.generate_init_sequence();
+
+        // Inline checksums match a separate pass over the output
+        app::GenerateOptions options;
+        options.command_checksums = true;
+        app::ImageIntegrity integrity;
+        auto same = initializer.generate_init_sequence(options, &integrity);
+        check(same == plain, "checksums do not change the image");
+        check(integrity.command_checksums.size() == 5, "one checksum per command");
+        check(integrity.image_checksum == app::crc32c(0, plain.data(), plain.size()), "image checksum");
+        check(app::verify_init_sequence(plain, integrity).ok, "unmodified image verifies");
+
+        // The trailer covers everything before it
+        options.checksum_trailer = true;
+        auto with_trailer = initializer.generate_init_sequence(options, &integrity);
+        check(with_trailer.size() == plain.size() + 13, "trailer appended");
+        check(with_trailer.size() == initializer.init_sequence_size(options), "size pre-pass includes trailer");
+        check(integrity.image_checksum == app::crc32c(0, with_trailer.data(), with_trailer.size()),
+              "image checksum includes trailer");
+        auto verified = app::verify_init_sequence(with_trailer.data(), with_trailer.size(), nullptr, true);
+        check(verified.ok && verified.has_trailer && verified.command_count == 5, "trailer verifies");
+
+        // Corruption is located by command checksums and caught by the trailer
+        auto corrupted = with_trailer;
+        corrupted[40] ^= 0x01;   // Inside the DMA block, the third command
+        verified = app::verify_init_sequence(corrupted.data(), corrupted.size(), &integrity.command_checksums);
+        check(!verified.ok && verified.failed_command == 2 && verified.failed_offset == 26,
+              "first mismatching command reported");
+        verified = app::verify_init_sequence(corrupted.data(), corrupted.size());
+        check(!verified.ok && verified.error == "Image checksum mismatch", "trailer detects corruption");
+
+        verified = app::verify_init_sequence(plain.data(), plain.size() - 1);
+        check(!verified.ok && verified.failed_command == 4, "truncated image rejected");
+        check(!app::verify_init_sequence(plain.data(), plain.size(), nullptr, true).ok, "missing trailer rejected");
+
+        // Parallel comparison against the template and VRD data
+        for (size_t threads : {1, 4}) {
+            app::SourceVerifyOptions source_options;
+            source_options.num_threads = threads;
+            source_options.chunk_bytes = 16;   // Several chunks even for this small image
+            verified = app::verify_against_source(initializer, with_trailer.data(), with_trailer.size(), source_options);
+            check(verified.ok && verified.has_trailer && verified.command_count == 5, "generated image matches source");
+
+            // Byte 90 lies in the VRD data, byte 20 in the second register write
+            corrupted = with_trailer;
+            corrupted[90] ^= 0x01;
+            corrupted[20] ^= 0x01;
+            verified = app::verify_against_source(initializer, corrupted.data(), corrupted.size(), source_options);
+            check(!verified.ok && verified.failed_command == 1 && verified.failed_offset == 13,
+                  "first mismatching command reported by parallel verifier");
+
+            corrupted = plain;
+            corrupted[90] ^= 0x01;
+            verified = app::verify_against_source(initializer, corrupted.data(), corrupted.size(), source_options);
+            check(!verified.ok && verified.failed_command == 3 && verified.error == "VRD slot data differs",
+                  "VRD data mismatch reported");
+        }
+
+        // A prebuilt index is reused
+        auto index = app::CommandIndex::build(plain.data(), plain.size());
+        check(index.size() == 5 && index[3].type == app::CommandType::DMA_WRITE, "image index");
+        app::SourceVerifyOptions indexed;
+        indexed.index = &index;
+        check(app::verify_against_source(initializer, plain.data(), plain.size(), indexed).ok, "verify with index");
+        verified = app::verify_against_source(initializer, plain.data(), index[4].offset);
+        check(!verified.ok && verified.failed_command == 4, "missing command reported");
+
+        // Regenerating from an image replaces its trailer
+        app::AppInitializer reloaded(with_trailer);
+        check(reloaded.generate_init_sequence(options) == with_trailer, "stale trailer replaced");
+
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
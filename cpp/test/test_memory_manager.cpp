@@ -0,0 +1,333 @@
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "../src/memory_manager.hpp"
+#include "../src/requirement_stream.hpp"
+#include "test_support.hpp"
+
+using app::DimensionRequirement;
+using app::MemoryManager;
+using app::MemoryRequirement;
+using app::SliceAllocationMode;
+
+MemoryRequirement requirement(const std::string& id, uint64_t size, DimensionRequirement pe,
+                              DimensionRequirement mss, DimensionRequirement slice,
+                              SliceAllocationMode mode = SliceAllocationMode::SERIAL, uint32_t width = 1) {
+    MemoryRequirement req;
+    req.allocation_id = id;
+    req.size = size;
+    req.pe = pe;
+    req.mss = mss;
+    req.slice = slice;
+    req.mode = mode;
+    req.interleave_width = width;
+    return req;
+}
+
+// Running totals match a recompute over the mappings
+void check_totals(const MemoryManager& manager, const std::string& label) {
+    check(manager.total_requested_bytes() == manager.total_allocated_bytes(),
+          label + ": requested bytes match allocated bytes");
+    uint64_t allocated = 0;
+    size_t coordinates = 0;
+    for (const auto& mapping : manager.stats()) {
+        allocated += mapping.total_allocated * mapping.coordinates;
+        coordinates += mapping.coordinates;
+        check(mapping.total_free + mapping.total_allocated == manager.slice_size(), label + ": mapping totals");
+    }
+    size_t fulfilled = 0;
+    for (const auto& record : manager.requirements()) {
+        fulfilled += record.fulfilled ? 1 : 0;
+    }
+    auto summary = manager.summary();
+    check(summary.allocated_bytes == allocated, label + ": allocated bytes kept up to date");
+    check(summary.free_bytes == coordinates * manager.slice_size() - allocated, label + ": free bytes");
+    check(summary.fulfilled == fulfilled && summary.pending == manager.requirements().size() - fulfilled,
+          label + ": fulfilled and pending counts");
+    check(summary.forks - summary.merges == summary.mappings - 1,
+          label + ": every fork adds one mapping, every merge removes one");
+}
+
+// Message of the runtime_error thrown by fn, or empty if none
+template <typename Fn>
+std::string error_of(Fn fn) {
+    try {
+        fn();
+    } catch (const std::runtime_error& e) {
+        return e.what();
+    }
+    return "";
+}
+
+int main() {
+    try {
+        const auto all = DimensionRequirement::all();
+
+        // Broad requirements share the universal mapping; narrow ones fork it
+        MemoryManager manager(2, 2, 8);
+        check(manager.allocate(requirement("global", 512, all, all, all)), "global allocation");
+        check(manager.mapping_count() == 1, "no fork for a global allocation");
+        check(manager.allocate(requirement("pe0", 256, DimensionRequirement::specific(0), all, all)),
+              "PE allocation");
+        check(manager.mapping_count() == 2, "PE allocation forks");
+        check(manager.requirements().back().placement.address == 512, "first fit after the global buffer");
+        check(manager.allocate(requirement("mss0", 128, all, DimensionRequirement::specific(0), all)),
+              "MSS allocation across mappings");
+        check(manager.mapping_count() == 4, "MSS allocation forks both PE mappings");
+        check(manager.requirements().back().placement.address == 768, "address free in every mapping");
+        check_totals(manager, "forks");
+
+        // The original groups are masks, and PARALLEL stripes over the group
+        auto group = requirement("group", 1024, DimensionRequirement::specific(1), DimensionRequirement::specific(1),
+                                 DimensionRequirement::group(app::kSliceGroup0_3), SliceAllocationMode::PARALLEL);
+        check(manager.slice_allocation_size(group) == 256, "four-slice group takes a quarter per slice");
+        check(manager.allocate(group), "group allocation");
+        check(manager.requirements().back().placement.slices.size() == 4, "group covers four slices");
+        check(manager.describe_scope(group) == "PE1 x MSS1 x Slice-0_3 PARALLEL", "group description");
+        check_totals(manager, "group");
+
+        // Any mask stripes over its slices in whole interleave units
+        auto every_other = requirement("striped", 1000, all, all, DimensionRequirement::group(0x55),
+                                       SliceAllocationMode::PARALLEL, 64);
+        check(manager.slice_allocation_size(every_other) == 256, "1000 bytes over 4 slices in 64-byte stripes");
+        every_other.slice = all;
+        check(manager.slice_allocation_size(every_other) == 128, "all 8 slices in 64-byte stripes");
+        every_other.slice = DimensionRequirement::group(0x3);
+        every_other.interleave_width = 1;
+        check(manager.slice_allocation_size(every_other) == 500, "two slices take half each");
+        check(manager.total_allocation_size(every_other) == 2 * 2 * 2 * 500, "striped total over every PE and MSS");
+        check(manager.allocate(every_other), "two-slice stripe");
+        check_totals(manager, "stripes");
+
+        // Materialized coordinates cover every allocated byte
+        auto placed = manager.materialize();
+        uint64_t placed_bytes = 0;
+        for (size_t i = 0; i < placed.count(); ++i) {
+            placed_bytes += placed.size[i];
+        }
+        check(placed.pe.size() == placed.count() && placed_bytes == manager.total_allocated_bytes(),
+              "one entry per allocated coordinate");
+
+        MemoryManager small(2, 2, 2, 4096);
+        check(small.allocate(requirement("a", 64, DimensionRequirement::specific(0), all,
+                                         DimensionRequirement::group(0x2))), "a");
+        check(!small.allocate(requirement("too_big", 8192, all, all, all)), "too big");
+        check(small.allocate(requirement("b", 32, DimensionRequirement::automatic(),
+                                         DimensionRequirement::specific(1), all)), "b");
+        auto coordinates = small.materialize();
+        const uint32_t expected_requirement[] = {0, 0, 2, 2};
+        const uint32_t expected_pe[] = {0, 0, 1, 1};
+        const uint32_t expected_mss[] = {0, 1, 1, 1};
+        const uint32_t expected_slice[] = {1, 1, 0, 1};
+        check(coordinates.count() == 4, "failed requirements take no entries");
+        for (size_t i = 0; i < 4; ++i) {
+            check(coordinates.requirement[i] == expected_requirement[i] && coordinates.pe[i] == expected_pe[i] &&
+                  coordinates.mss[i] == expected_mss[i] && coordinates.slice[i] == expected_slice[i],
+                  "coordinate " + std::to_string(i));
+            check(coordinates.address[i] == 0 && coordinates.size[i] == (i < 2 ? 64u : 32u), "address and size");
+        }
+
+        // Automatic selection picks the emptiest resource
+        MemoryManager automatic(2, 2, 4);
+        check(automatic.allocate(requirement("pe0", 4096, DimensionRequirement::specific(0), all, all)),
+              "fill PE 0");
+        check(automatic.allocate(requirement("auto", 1024, DimensionRequirement::automatic(), all, all)),
+              "auto PE");
+        check(automatic.requirements().back().placement.pe == 1, "emptier PE selected");
+        check_totals(automatic, "automatic");
+
+        // Batches allocate broad scopes and large sizes first
+        MemoryManager batch(2, 2, 4);
+        batch.collect(requirement("small_pe", 64, DimensionRequirement::specific(0), all, all));
+        batch.collect(requirement("large_global", 4096, all, all, all));
+        batch.collect(requirement("auto", 128, DimensionRequirement::automatic(), all, all));
+        batch.collect(requirement("small_global", 32, all, all, all));
+        auto result = batch.allocate_all();
+        check(result.successful == 4 && result.failed == 0, "batch allocated");
+        const char* expected[] = {"large_global", "small_global", "small_pe", "auto"};
+        for (size_t i = 0; i < 4; ++i) {
+            const auto& step = result.steps[i];
+            check(batch.requirements()[step.requirement].requirement.allocation_id == expected[i], "batch order");
+        }
+        check(batch.requirements()[3].placement.pe == 1, "auto avoids the PE with the extra buffer");
+        check_totals(batch, "batch");
+
+        // Failures are recorded but take no memory
+        MemoryManager tiny(1, 1, 1);
+        check(!tiny.allocate(requirement("too_big", 2 * 1024 * 1024, all, all, all)), "oversized fails");
+        check(!tiny.requirements().back().fulfilled && tiny.total_allocated_bytes() == 0, "failure takes no memory");
+        check(!tiny.allocate(requirement("auto_too_big", 2 * 1024 * 1024, DimensionRequirement::automatic(), all, all)),
+              "no combination fits");
+        check(tiny.summary().pending == 2, "failures stay pending");
+        check_totals(tiny, "failures");
+
+        // The largest free block follows allocations into the gaps
+        app::SliceMemoryMap map(1024);
+        check(map.allocate_at(256, 128, "middle") && map.largest_free_block() == 640, "tail is largest");
+        check(map.allocate_at(512, 512, "tail") && map.largest_free_block() == 256, "head is largest");
+        check(!map.allocate_at(300, 16, "overlap") && !map.allocate_at(1024, 1, "past the end"), "taken ranges rejected");
+        uint64_t address = 0;
+        check(map.allocate(200, "head", address) && address == 0 && map.largest_free_block() == 128, "first fit");
+        check(map.total_free() == 1024 - 128 - 512 - 200, "free total");
+
+        // Explain mode keeps the best candidates of every resolved requirement
+        MemoryManager explained(2, 2, 4, 8192);
+        explained.set_explain(2);
+        check(explained.allocate(requirement("pe0", 4096, DimensionRequirement::specific(0), all, all)), "pe0");
+        check(explained.explanations().empty(), "nothing to explain without auto-selection");
+        check(explained.allocate(requirement("auto_pe", 1024, DimensionRequirement::automatic(), all, all)),
+              "auto PE");
+        check(explained.allocate(requirement("auto_mss", 512, all, DimensionRequirement::automatic(), all)),
+              "auto MSS");
+        check(explained.explanations().size() == 2, "one explanation per resolved requirement");
+        const auto& pe_choice = explained.explanations()[0];
+        check(pe_choice.requirement == 1 && pe_choice.combinations == 2 && pe_choice.candidates.size() == 2,
+              "both PEs scored");
+        check(pe_choice.candidates[0].pe == 1 && pe_choice.candidates[0].score == 8192 &&
+              pe_choice.candidates[0].mss == -1, "emptier PE first");
+        check(pe_choice.candidates[1].pe == 0 && pe_choice.candidates[1].min_free == 4096 &&
+              pe_choice.candidates[1].penalty == 0, "fuller PE second");
+        const auto& mss_choice = explained.explanations()[1].candidates[0];
+        check(mss_choice.mappings == 2 && mss_choice.score == 4096 * 0.8 && mss_choice.penalty == 4096 - 4096 * 0.8,
+              "cross-mapping penalty");
+        check(explained.requirements()[2].placement.mss == mss_choice.mss, "first candidate chosen");
+
+        app::SliceMemoryMap gaps(1000);
+        check(gaps.allocate_at(100, 100, "a") && gaps.largest_free_block_after(50) == 800, "small fit in the head");
+        check(gaps.largest_free_block_after(200) == 600, "large fit splits the largest block");
+
+        // Placement policies, per manager or per requirement
+        auto placed_pe = [&](app::PlacementPolicyKind manager_policy, MemoryRequirement auto_pe,
+                             const app::PlacementPolicy* custom = nullptr) {
+            MemoryManager policed(4, 2, 4, 8192);
+            policed.set_placement_policy(custom ? custom : &app::placement_policy(manager_policy));
+            check(policed.allocate(requirement("global", 1024, all, all, all)), "global");
+            check(policed.allocate(requirement("pe0", 2048, DimensionRequirement::specific(0), all, all)), "pe0");
+            check(policed.allocate(auto_pe), "auto PE with a policy");
+            return policed.requirements().back().placement.pe;
+        };
+        auto auto_pe = requirement("auto", 1024, DimensionRequirement::automatic(), all, all);
+        check(placed_pe(app::PlacementPolicyKind::DEFAULT, auto_pe) == 1, "worst fit takes the emptiest PE");
+        check(placed_pe(app::PlacementPolicyKind::BEST_FIT, auto_pe) == 0, "best fit packs into PE 0");
+        check(placed_pe(app::PlacementPolicyKind::FEWEST_FORKS, auto_pe) == 0, "PE 0 needs no fork");
+        auto_pe.home_pe = 3;
+        check(placed_pe(app::PlacementPolicyKind::PE_LOCALITY, auto_pe) == 3, "home PE");
+        auto_pe.policy = app::PlacementPolicyKind::WORST_FIT;
+        check(placed_pe(app::PlacementPolicyKind::BEST_FIT, auto_pe) == 1, "requirement policy overrides");
+
+        struct LastPePolicy : app::PlacementPolicy {
+            double score(const app::PlacementContext& context) const override {
+                return context.requirement.pe.value;
+            }
+        } last_pe;
+        auto_pe.policy = app::PlacementPolicyKind::DEFAULT;
+        check(placed_pe(app::PlacementPolicyKind::DEFAULT, auto_pe, &last_pe) == 3, "custom policy");
+
+        MemoryManager balanced(1, 2, 4, 8192);
+        balanced.set_placement_policy(&app::placement_policy(app::PlacementPolicyKind::MSS_BALANCE));
+        check(balanced.allocate(requirement("mss0", 512, all, DimensionRequirement::specific(0), all)), "mss0");
+        check(balanced.allocate(requirement("auto_slice", 64, all, DimensionRequirement::automatic(),
+                                            DimensionRequirement::automatic())), "auto MSS and slice");
+        check(balanced.requirements().back().placement.mss == 1 && balanced.mss_allocated_bytes(0, 1) == 64,
+              "least loaded MSS");
+        // Lookahead keeps the auto slice out of the next requirement's slices
+        for (size_t depth : {0, 1}) {
+            MemoryManager ahead(1, 1, 4, 8192);
+            ahead.set_lookahead(depth);
+            check(ahead.allocate(requirement("pre", 512, all, all, DimensionRequirement::specific(0))), "pre");
+            ahead.collect(requirement("auto", 64, all, all, DimensionRequirement::automatic()));
+            ahead.collect(requirement("pair", 64, DimensionRequirement::specific(0), DimensionRequirement::specific(0),
+                                      DimensionRequirement::group(0x6)));
+            auto ahead_result = ahead.allocate_all();
+            check(ahead_result.successful == 2, "lookahead batch allocated");
+            check(ahead.requirements()[1].placement.slices == std::vector<int>{depth ? 3 : 1}, "auto slice");
+            check(ahead.fork_count() == (depth ? 2u : 3u) && ahead_result.forks_avoided == depth &&
+                  ahead.summary().forks_avoided == depth, "fork avoided");
+            check_totals(ahead, "lookahead");
+        }
+        // Mappings a failed requirement forked merge back
+        MemoryManager merging(2, 1, 2, 1024);
+        check(!merging.allocate(requirement("too_big", 2048, DimensionRequirement::specific(0), all, all)), "too big");
+        check(merging.mapping_count() == 2 && merging.merge_equal_mappings() == 1 && merging.mapping_count() == 1,
+              "forks merge back");
+        merging.set_auto_merge(true);
+        check(merging.allocate(requirement("pe0", 64, DimensionRequirement::specific(0), all, all)), "pe0 buffer");
+        check(!merging.allocate(requirement("too_big", 2048, all, all, DimensionRequirement::specific(1))), "fail");
+        check(merging.mapping_count() == 2 && merging.fork_count() == 4 && merging.merge_count() == 3,
+              "automatic merge after the failure");
+        check(merging.merge_equal_mappings() == 0, "different allocations stay apart");
+        check(merging.allocate(requirement("global", 64, all, all, all)), "global over the merged mappings");
+        check(merging.requirements().back().placement.address == 64, "merged mappings keep their allocations");
+        check_totals(merging, "merging");
+        app::SliceMemoryMap left(1024), right(1024);
+        check(left.allocate_at(0, 8, "a") && left.allocate_at(64, 8, "b") && right.allocate_at(64, 8, "b") &&
+              right.allocate_at(0, 8, "a"), "same allocations in another order");
+        check(left.state_hash() == right.state_hash() && left.same_state(right), "order-independent state");
+
+        check(!error_of([] { app::parse_placement_policy("first-fit"); }).empty(), "unknown policy rejected");
+        check(app::parse_placement_policy("mss-balance") == app::PlacementPolicyKind::MSS_BALANCE, "policy names");
+
+        // Streams replay the same decisions and print back to themselves
+        std::istringstream text(
+            "geometry 2 2 4 4096  # small\n"
+            "alloc pe0 4096 0 all all\n"
+            "collect big 512 all all all\n"
+            "collect striped 1000 1 1 mask:0x5 parallel 64\n"
+            "collect auto 1024 auto all all\n"
+            "batch\n");
+        auto stream = app::RequirementStream::parse(text);
+        std::istringstream printed(stream.to_string());
+        check(app::RequirementStream::parse(printed).to_string() == stream.to_string(), "stream round trip");
+        auto replayed = stream.replay();
+        check(replayed.requirements().size() == 4, "every requirement replayed");
+        check(app::format_record(replayed.requirements()[0]) == "pe0 ok 0x0 0 -1 0xf 4096 2", "specific PE record");
+        check(app::format_record(replayed.requirements()[1]) == "big fail", "full PE 0 fails the global buffer");
+        check(app::format_record(replayed.requirements()[2]) == "auto ok 0x0 1 -1 0xf 1024 2",
+              "auto PE before narrower scopes");
+        check(app::format_record(replayed.requirements()[3]) == "striped ok 0x400 1 1 0x5 512 3",
+              "two-slice stripe record");
+        // PE locality counts grid steps: on a 2x2 grid PE 3, not PE 2, neighbours home PE 1
+        std::istringstream local_text(
+            "geometry 4 1 1 4096 2\n"
+            "alloc pe0 1024 0 all all\n"
+            "alloc pe1 4096 1 all all\n"
+            "alloc near 64 auto all all parallel policy pe-locality home 1\n");
+        auto local_stream = app::RequirementStream::parse(local_text);
+        std::istringstream local_printed(local_stream.to_string());
+        check(app::RequirementStream::parse(local_printed).to_string() == local_stream.to_string(),
+              "policy and home round trip");
+        check(local_stream.operations[2].requirement.policy == app::PlacementPolicyKind::PE_LOCALITY &&
+              local_stream.operations[2].requirement.home_pe == 1, "per-requirement policy and home PE");
+        check(local_stream.replay().requirements()[2].placement.pe == 3, "nearest PE by Manhattan distance");
+        std::istringstream bad("alloc x 1 all all bogus\n");
+        check(!error_of([&] { app::RequirementStream::parse(bad); }).empty(), "bad dimension rejected");
+        std::istringstream wrapping("alloc x 1 4294967295 all all\n");
+        check(error_of([&] { app::RequirementStream::parse(wrapping); }).find("invalid number") != std::string::npos,
+              "index beyond int rejected rather than read as auto");
+
+        // Requirements must fit the geometry
+        bool threw = false;
+        try {
+            manager.allocate(requirement("bad_mask", 64, all, all, DimensionRequirement::group(0x100)));
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        check(threw, "mask beyond the slices rejected");
+        threw = false;
+        try {
+            manager.allocate(requirement("bad_width", 64, all, all, all, SliceAllocationMode::PARALLEL, 0));
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        check(threw, "zero interleave width rejected");
+
+        auto profiled = MemoryManager::from_profile(app::TargetProfile::haps());
+        check(profiled.pe_count() == 8 && profiled.slices_per_mss() == 8, "geometry from the profile");
+
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,100 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "../src/app_initializer.hpp"
+#include "../src/command_index.hpp"
+#include "../src/image_verifier.hpp"
+#include "../src/register_shadow.hpp"
+#include "../src/template_encoder.hpp"
+#include "test_support.hpp"
+
+uint32_t read_uint32(const std::vector<uint8_t>& data, size_t pos) {
+    return static_cast<uint32_t>(data[pos]) |
+           (static_cast<uint32_t>(data[pos + 1]) << 8) |
+           (static_cast<uint32_t>(data[pos + 2]) << 16) |
+           (static_cast<uint32_t>(data[pos + 3]) << 24);
+}
+
+int main() {
+    try {
+        // Register writes interleaved with DMA blocks; 0x100 is written repeatedly
+        app::BirdCommandSequence seq{
+            "Test",
+            app::NetworkType{app::BroadcastType::SUPER_MSS_BRCST, app::GridDestinationType::APB},
+            {}
+        };
+        for (uint32_t i = 0; i < 20; ++i) {
+            seq.add_single_command(0x100, i, i % 5 == 0);
+            seq.add_single_command(0x200 + i * 4, i);
+            seq.add_dma_command(0x10000 + i * 0x100, std::vector<uint8_t>(16, static_cast<uint8_t>(i)));
+        }
+        seq.add_vrd_command(0x20000, 16, "slot");
+
+        app::AppInitializer initializer(app::encode_init_template({seq}));
+        initializer.load_vrd_data("slot", std::vector<uint8_t>(16, 0x5A));
+        check(initializer.command_count() == 61, "commands generated by the template");
+
+        // Checkpoints every 10 commands name the command after them
+        app::GenerateOptions options;
+        options.checkpoint_interval = 10;
+        options.checksum_trailer = true;
+        app::CommandIndex index;
+        auto image = initializer.generate_init_sequence(options, nullptr, &index);
+        size_t checkpoints = 0;
+        size_t generated = 0;
+        for (const auto& entry : index.entries()) {
+            if (entry.type == app::CommandType::CHECKPOINT) {
+                check(read_uint32(image, entry.offset + 5) == generated, "checkpoint ordinal");
+                ++checkpoints;
+            } else if (entry.type != app::CommandType::IMAGE_CHECKSUM) {
+                ++generated;
+            }
+        }
+        check(checkpoints == 6, "one checkpoint per 10 commands");
+        check(image.size() == initializer.init_sequence_size(options), "size pre-pass counts checkpoints");
+        check(app::verify_init_sequence(image.data(), image.size(), nullptr, true).ok, "image with checkpoints verifies");
+        check(app::verify_against_source(initializer, image.data(), image.size()).ok,
+              "checkpoints skipped when comparing with the source");
+
+        // The shadow keeps the last write of every register, in order of last write
+        auto shadow = initializer.register_state(30);
+        check(shadow.size() == 11, "registers written by the first 30 commands");
+        uint32_t value = 0;
+        check(shadow.lookup(0x100, value) && value == 9, "last value of a rewritten register");
+        auto writes = shadow.writes();
+        check(writes.back().addr == 0x224 && writes[writes.size() - 2].addr == 0x100,
+              "rewritten register moves to its last write");
+        check(!writes[writes.size() - 2].safe, "safety follows the last write");
+
+        // Resuming at a checkpoint replays the register state, then the remaining commands
+        app::GenerateOptions resume_options;
+        resume_options.checksum_trailer = true;
+        auto resumed = initializer.generate_resume_sequence(30, resume_options);
+        auto resumed_index = app::CommandIndex::build(resumed.data(), resumed.size());
+        check(resumed_index.size() == 11 + 31 + 1, "prefix, remaining commands and trailer");
+        check(app::verify_init_sequence(resumed.data(), resumed.size(), nullptr, true).ok, "resumed image verifies");
+
+        auto full = initializer.generate_init_sequence();
+        auto full_index = app::CommandIndex::build(full.data(), full.size());
+        auto tail = full_index.byte_range(30, full_index.size());
+        check(std::equal(full.begin() + tail.first, full.end(), resumed.begin() + resumed_index[11].offset),
+              "remaining commands are copied unchanged");
+
+        check(initializer.generate_resume_sequence(0) == full, "resuming at 0 is the full image");
+        check(initializer.generate_resume_sequence(61).size() == initializer.register_state(61).size() * 13,
+              "resuming at the end only restores registers");
+
+        bool threw = false;
+        try {
+            initializer.generate_resume_sequence(62);
+        } catch (const std::out_of_range&) {
+            threw = true;
+        }
+        check(threw, "resume point past the end rejected");
+
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
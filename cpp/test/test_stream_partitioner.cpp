@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "../src/app_compiler.hpp"
+#include "../src/image_verifier.hpp"
+#include "../src/stream_partitioner.hpp"
+#include "../src/template_encoder.hpp"
+#include "test_support.hpp"
+
+uint32_t read_uint32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+// Command executed by the simulated loader
+struct Executed {
+    size_t stream;
+    std::string bytes;
+};
+
+// Run all streams like a loader with one thread per stream. The pick function
+// chooses the next runnable stream; waits block until their fence is signaled.
+template <typename Pick>
+std::vector<Executed> run_streams(const app::PartitionedImage& image, Pick pick) {
+    std::vector<size_t> pos(image.streams.size(), 0);
+    std::set<uint32_t> signaled;
+    std::vector<Executed> executed;
+
+    while (true) {
+        std::vector<size_t> runnable;
+        bool done = true;
+        for (size_t s = 0; s < image.streams.size(); ++s) {
+            const auto& data = image.streams[s].data;
+            if (pos[s] >= data.size()) {
+                continue;
+            }
+            done = false;
+            auto type = static_cast<app::CommandType>(data[pos[s]]);
+            if (type != app::CommandType::FENCE_WAIT || signaled.count(read_uint32(&data[pos[s] + 5]))) {
+                runnable.push_back(s);
+            }
+        }
+        if (done) {
+            return executed;
+        }
+        check(!runnable.empty(), "streams deadlocked");
+
+        size_t s = pick(runnable);
+        const auto& data = image.streams[s].data;
+        auto type = static_cast<app::CommandType>(data[pos[s]]);
+        size_t size = 5 + read_uint32(&data[pos[s] + 1]);
+        if (type == app::CommandType::FENCE_SIGNAL) {
+            signaled.insert(read_uint32(&data[pos[s] + 5]));
+        } else if (type != app::CommandType::FENCE_WAIT && type != app::CommandType::IMAGE_CHECKSUM) {
+            executed.push_back(Executed{s, std::string(data.begin() + pos[s], data.begin() + pos[s] + size)});
+        }
+        pos[s] += size;
+    }
+}
+
+// Bridge registers touched by network switches
+bool is_switch_command(const std::string& bytes) {
+    uint32_t addr = read_uint32(reinterpret_cast<const uint8_t*>(bytes.data()) + 5);
+    return (addr & 0xFF000000) == 0x70000000;
+}
+
+int main() {
+    try {
+        // Hand-built stream: configuration, two networks, and a barrier in the middle of B
+        const app::NetworkType direct{app::BroadcastType::DIRECT, app::GridDestinationType::APB};
+        const app::NetworkType net_a{app::BroadcastType::SUPER_MSS_BRCST, app::GridDestinationType::MSS};
+        const app::NetworkType net_b{app::BroadcastType::SUPER_PE_BRCST, app::GridDestinationType::APB};
+
+        app::BuildResult build;
+        app::BirdCommandSequence config{"Config", direct, {}};
+        config.add_single_command(0x71000000, 1, true);
+        config.add_single_command(0x71000004, 2, true);
+        app::BirdCommandSequence to_a{"Switch to A", direct, {}};
+        to_a.add_single_command(0x70001004, 1);
+        to_a.add_single_command(0x70001008, 1, true);
+        app::BirdCommandSequence to_b{"Switch to B", direct, {}};
+        to_b.add_single_command(0x70002004, 2);
+        to_b.add_single_command(0x70002008, 1, true);
+        app::BirdCommandSequence a1{"A1", net_a, {}};
+        a1.add_dma_command(0x10000000, std::vector<uint8_t>(64, 1));
+        a1.add_dma_command(0x10000100, std::vector<uint8_t>(64, 2));
+        app::BirdCommandSequence b1{"B1", net_b, {}};
+        b1.add_single_command(0x50000200, 1);
+        b1.add_single_command(0x50000204, 2, true);
+        b1.add_single_command(0x50000208, 3);
+        app::BirdCommandSequence a2{"A2", net_a, {}};
+        a2.add_dma_command(0x10000200, std::vector<uint8_t>(64, 3));
+
+        build.sequences = {config, to_a, a1, to_b, b1, to_a, a2};
+        build.network_switches = {1, 3, 5};
+        auto image = app::encode_init_template(build.sequences);
+
+        app::PartitionOptions options;
+        options.num_streams = 4;
+        options.checksum_trailer = true;
+        auto partitioned = app::partition_image(build, image.data(), image.size(), options);
+        check(partitioned.streams.size() == 3, "no more streams than domains");
+        for (const auto& stream : partitioned.streams) {
+            check(stream.domains.size() == 1, "one domain per stream");
+            check(app::verify_init_sequence(stream.data.data(), stream.data.size(), nullptr, true).ok,
+                  "every stream is a valid image with a trailer");
+        }
+        check(partitioned.streams[0].domains[0] == net_a, "largest domain first");
+
+        // The original order of the commands that are not network switches
+        std::vector<std::string> original;
+        auto index = app::CommandIndex::build(image.data(), image.size());
+        for (const auto& entry : index.entries()) {
+            std::string bytes(image.begin() + entry.offset, image.begin() + entry.offset + entry.size());
+            if (!is_switch_command(bytes)) {
+                original.push_back(bytes);
+            }
+        }
+
+        // Under any schedule, everything before a barrier runs before it and nothing after it
+        auto round_robin = [turn = size_t(0)](const std::vector<size_t>& runnable) mutable {
+            return runnable[turn++ % runnable.size()];
+        };
+        auto last_first = [](const std::vector<size_t>& runnable) { return runnable.back(); };
+        for (const auto& executed : {run_streams(partitioned, round_robin), run_streams(partitioned, last_first)}) {
+            std::vector<std::string> order;
+            for (const auto& command : executed) {
+                if (!is_switch_command(command.bytes)) {
+                    order.push_back(command.bytes);
+                }
+            }
+            check(std::multiset<std::string>(order.begin(), order.end()) ==
+                  std::multiset<std::string>(original.begin(), original.end()), "every command loaded once");
+
+            for (size_t i = 0; i < original.size(); ++i) {
+                if (static_cast<app::CommandType>(original[i][0]) != app::CommandType::SAFE_APB_WRITE) {
+                    continue;
+                }
+                size_t at = std::find(order.begin(), order.end(), original[i]) - order.begin();
+                check(std::multiset<std::string>(order.begin(), order.begin() + at) ==
+                      std::multiset<std::string>(original.begin(), original.begin() + i),
+                      "barrier separates earlier and later commands");
+            }
+
+            // Commands to one domain keep their order
+            std::vector<std::string> domain_a;
+            for (const auto& command : executed) {
+                if (static_cast<app::CommandType>(command.bytes[0]) == app::CommandType::DMA_WRITE) {
+                    domain_a.push_back(command.bytes);
+                }
+            }
+            check(domain_a.size() == 3 && domain_a[0][13] == 1 && domain_a[1][13] == 2 && domain_a[2][13] == 3,
+                  "DMA writes keep their order");
+        }
+
+        // Streams switch their own bridge: A's stream repeats its switch only once
+        size_t switches = 0;
+        for (const auto& command : run_streams(partitioned, last_first)) {
+            if (command.stream == 0 && is_switch_command(command.bytes)) {
+                ++switches;
+            }
+        }
+        check(switches == 2, "switch emitted when the stream changes network");
+
+        // A real application: the grid settings are barriers, after which kernels stream independently
+        create_sample_binaries("app");
+        std::istringstream manifest_input(sample_manifest("StreamApp", "app", ""));
+        app::CompileOptions compile_options;
+        compile_options.generate.checkpoint_interval = 8;
+        auto compiled = app::AppCompiler().compile(app::parse_manifest(manifest_input, ""), compile_options);
+        app::PartitionOptions wide;
+        wide.num_streams = 8;
+        auto streams = app::partition_image(compiled.build, compiled.init_sequence.data(),
+                                            compiled.init_sequence.size(), wide);
+        check(streams.streams.size() > 1, "application split into several streams");
+        size_t dma_bytes = 0;
+        for (const auto& command : run_streams(streams, round_robin)) {
+            if (static_cast<app::CommandType>(command.bytes[0]) == app::CommandType::DMA_WRITE) {
+                dma_bytes += command.bytes.size();
+            }
+        }
+        size_t image_dma_bytes = 0;
+        for (const auto& entry : app::CommandIndex::build(compiled.init_sequence.data(),
+                                                          compiled.init_sequence.size()).entries()) {
+            if (entry.type == app::CommandType::DMA_WRITE) {
+                image_dma_bytes += entry.size();
+            }
+        }
+        check(dma_bytes == image_dma_bytes, "all DMA data loaded");
+
+        bool threw = false;
+        try {
+            app::partition_image(compiled.build, image.data(), image.size());
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        check(threw, "image of another build rejected");
+
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
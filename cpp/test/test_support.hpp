@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+// Fixtures shared by the tests
+
+inline void check(bool condition, const std::string& message) {
+    if (!condition) {
+        throw std::runtime_error("Check failed: " + message);
+    }
+}
+
+// Small kernel binary file in the decoder format
+inline void create_sample_image(const std::string& filename, const std::string& first_word) {
+    std::ofstream file(filename);
+    file << "@000000 " << first_word << "000000000000000000000000\n";
+    file << "@000004 6c0080a1000000004000000000000000\n";
+}
+
+// VRD data file of size bytes counting up
+inline void create_vrd_data(const std::string& filename, size_t size) {
+    std::ofstream file(filename, std::ios::binary);
+    for (size_t i = 0; i < size; ++i) {
+        file.put(static_cast<char>(i & 0xFF));
+    }
+}
+
+// Binaries of the sample application: <prefix>_g.vcore.elf.ePM, <prefix>_g.vcore.elf.eDMw
+// and <prefix>_s.ncore.elf.ePM
+inline void create_sample_binaries(const std::string& prefix) {
+    create_sample_image(prefix + "_g.vcore.elf.ePM", "79bc0000");
+    create_sample_image(prefix + "_g.vcore.elf.eDMw", "00000000");
+    create_sample_image(prefix + "_s.ncore.elf.ePM", "07808000");
+}
+
+// Manifest of the sample application over the binaries of create_sample_binaries():
+// two copies of a 2x2 kernel with a VRD, unless vrd_file is empty, and one vcore kernel
+inline std::string sample_manifest(const std::string& name, const std::string& prefix,
+                                   const std::string& vrd_file) {
+    std::string manifest = "application " + name + "\n"
+                           "kernel G_Kernel 2x2\n"
+                           "binary G_Kernel " + prefix + "_g.vcore.elf.ePM\n"
+                           "binary G_Kernel " + prefix + "_g.vcore.elf.eDMw\n";
+    if (!vrd_file.empty()) {
+        manifest += "vrd G_Kernel DataSet 8 64 MSS_Distributed " + vrd_file + "\n";
+    }
+    return manifest +
+           "kernel S_Kernel 1Vcore\n"
+           "binary S_Kernel " + prefix + "_s.ncore.elf.ePM\n"
+           "deploy G_Kernel 0 0 2 2\n"
+           "deploy G_Kernel 2 0 2 2\n"
+           "deploy S_Kernel 0 14 2 2\n";
+}
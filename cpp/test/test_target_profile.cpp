@@ -0,0 +1,108 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "../src/app_compiler.hpp"
+#include "../src/target_profile.hpp"
+#include "test_support.hpp"
+
+// Message of the runtime_error thrown by fn, or empty if none
+template <typename Fn>
+std::string error_of(Fn fn) {
+    try {
+        fn();
+    } catch (const std::runtime_error& e) {
+        return e.what();
+    }
+    return "";
+}
+
+app::TargetProfile parse(const std::string& text) {
+    std::istringstream input(text);
+    return app::TargetProfile::parse(input);
+}
+
+int main() {
+    try {
+        // Built-in profiles match the hard-coded grids they replace
+        auto chip = app::TargetProfile::chip();
+        auto haps = app::TargetProfile::haps();
+        check(chip.size_x == 16 && chip.size_y == 16 && chip.line_id_count == 16, "chip profile");
+        check(haps.size_x == 4 && haps.size_y == 2 && haps.name == "haps", "haps profile");
+        check(app::Grid::haps().profile().name == "haps" && app::Grid::haps().size_x() == 4, "haps grid");
+        check(app::Grid(8, 8).profile().line_id_count == 16, "sized grid keeps the chip's limits");
+
+        // Files start from a base and override single limits
+        auto tuned = parse(
+            "# Wide-burst prototype\n"
+            "base haps\n"
+            "name proto\n"
+            "grid 8x4\n"
+            "dma_burst 0x100   # bytes\n"
+            "dma_align 64\n"
+            "broadcast_groups 6\n");
+        check(tuned.name == "proto" && tuned.size_x == 8 && tuned.size_y == 4, "name and grid");
+        check(tuned.command_overhead_ns == haps.command_overhead_ns, "unset keys come from the base");
+        auto rules = tuned.dma_rules();
+        check(rules.max_burst == 256 && rules.alignment == 64, "DMA rules from the profile");
+
+        auto round_trip = parse(tuned.to_string());
+        check(round_trip.to_string() == tuned.to_string(), "to_string parses back to the same profile");
+
+        // Errors name the line
+        check(error_of([] { parse("line_ids 8\nbogus 1\n"); }).find("Line 2") != std::string::npos,
+              "unknown key reported with its line");
+        check(error_of([] { parse("line_ids -1\n"); }).find("invalid number") != std::string::npos,
+              "negative number rejected");
+        check(error_of([] { parse("dma_align 0x100000010\n"); }).find("invalid number") != std::string::npos,
+              "number beyond 32 bits rejected");
+        check(error_of([] { parse("name a\nbase chip\n"); }).find("must come first") != std::string::npos,
+              "base after other keys rejected");
+        check(error_of([] { parse("dma_align 24\n"); }).find("power of two") != std::string::npos,
+              "bad alignment rejected");
+        check(error_of([] { parse("dma_burst 100\n"); }).find("multiple") != std::string::npos,
+              "burst not a multiple of the alignment rejected");
+        check(!error_of([] { app::TargetProfile::resolve("missing_profile.txt"); }).empty(),
+              "missing profile file rejected");
+
+        // The grid's bridge and NOC enforce the profile's limits: five
+        // networks are configured up front, and every kernel takes three
+        // broadcast groups
+        app::TargetProfile few_lines;
+        few_lines.line_id_count = 4;
+        check(error_of([&] { app::Grid grid(few_lines); }).find("all 4") != std::string::npos,
+              "line IDs limited by the profile");
+
+        app::Application application("Limited", app::Grid(tuned));
+        auto kernel = std::make_shared<app::Kernel>("K", app::KernelSize::SIZE_2X2);
+        application.add_kernel(kernel, app::KernelSuperGroup(0, 0, 2, 2, app::KernelSize::SIZE_2X2));
+        application.add_kernel(kernel, app::KernelSuperGroup(2, 0, 2, 2, app::KernelSize::SIZE_2X2));
+        check(error_of([&] {
+            application.add_kernel(kernel, app::KernelSuperGroup(4, 0, 2, 2, app::KernelSize::SIZE_2X2));
+        }).find("broadcast groups") != std::string::npos, "broadcast groups limited by the profile");
+
+        // Manifests name a target; a grid line overrides its size
+        {
+            std::ofstream file("proto.target");
+            file << tuned.to_string();
+        }
+        std::istringstream manifest_input("application A\ntarget proto.target\n");
+        auto manifest = app::parse_manifest(manifest_input, "");
+        check(app::target_profile(manifest).name == "proto", "target file from the manifest");
+        manifest.grid = "16x16";
+        auto resized = app::target_profile(manifest);
+        check(resized.size_x == 16 && resized.dma_max_burst == 256, "grid overrides only the size");
+
+        std::istringstream haps_input("grid haps\n");
+        check(app::target_profile(app::parse_manifest(haps_input, "")).command_overhead_ns ==
+              haps.command_overhead_ns, "haps grid selects the haps profile");
+        std::istringstream default_input("application A\n");
+        check(app::target_profile(app::parse_manifest(default_input, "")).name == "chip", "chip by default");
+
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
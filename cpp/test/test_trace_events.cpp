@@ -0,0 +1,92 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../src/memory_manager.hpp"
+#include "../src/trace_events.hpp"
+#include "test_support.hpp"
+
+app::MemoryRequirement requirement(const std::string& id, uint64_t size, app::DimensionRequirement pe) {
+    app::MemoryRequirement req;
+    req.allocation_id = id;
+    req.size = size;
+    req.pe = pe;
+    return req;
+}
+
+int main() {
+    try {
+        // Records are fixed little-endian layouts with interned subjects
+        app::RingBufferSink ring(3);
+        ring.emit(app::TraceEventType::ALLOCATED, "a", 0x1122, 2, 3);
+        ring.emit(app::TraceEventType::FORKED, "b", 1, 2);
+        ring.emit(app::TraceEventType::ALLOCATED, "a", 4);
+        auto bytes = ring.bytes();
+        check(bytes.size() == 3 * app::RingBufferSink::kRecordSize, "three records");
+        check(bytes[0] == 2 && bytes[1] == 0 && bytes[4] == 0 && bytes[8] == 0x22 && bytes[9] == 0x11,
+              "type, subject and values little endian");
+        check(bytes[64 + 4] == 0 && ring.subjects().size() == 2, "repeated subjects are interned");
+
+        // Once full, the oldest events are overwritten
+        ring.emit(app::TraceEventType::FAILED, "c", 5, 1);
+        auto events = ring.events();
+        check(ring.count() == 4 && ring.dropped() == 1, "one event dropped");
+        check(events.size() == 3 && events[0].subject == "b" && events[2].subject == "c" &&
+              events[2].values[1] == 1, "oldest first after wrapping");
+        ring.clear();
+        check(ring.events().empty() && ring.subjects().empty(), "cleared");
+
+        // Subjects of overwritten records are reused, not kept
+        app::RingBufferSink small(2);
+        for (int i = 0; i < 1000; ++i) {
+            small.emit(app::TraceEventType::ALLOCATED, "id" + std::to_string(i), static_cast<uint64_t>(i));
+        }
+        auto latest = small.events();
+        check(small.subjects().size() <= 2 && latest.size() == 2 && latest[0].subject == "id998" &&
+              latest[1].subject == "id999", "subject table bounded by the capacity");
+        small.clear();
+        check(small.subjects().empty(), "clear drops the subjects");
+
+        bool threw = false;
+        try {
+            app::RingBufferSink::decode(bytes.data(), bytes.size() - 1, ring.subjects());
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        check(threw, "partial record rejected");
+
+        // The memory manager reports ordering, forks, allocations and failures
+        std::vector<app::TraceEvent> seen;
+        app::CallbackSink callback([&](const app::TraceEvent& event) { seen.push_back(event); });
+        app::MemoryManager manager(2, 1, 1);
+        check(manager.allocate(requirement("silent", 64, app::DimensionRequirement::all())), "untraced allocation");
+        manager.set_trace_sink(&callback);
+        manager.collect(requirement("pe0", 256, app::DimensionRequirement::specific(0)));
+        manager.collect(requirement("global", 512, app::DimensionRequirement::all()));
+        manager.collect(requirement("too_big", 2 * 1024 * 1024, app::DimensionRequirement::all()));
+        manager.collect(requirement("auto_too_big", 2 * 1024 * 1024, app::DimensionRequirement::automatic()));
+        manager.allocate_all();
+
+        const app::TraceEventType expected[] = {
+            app::TraceEventType::REQUIREMENT_ORDERED, app::TraceEventType::REQUIREMENT_ORDERED,
+            app::TraceEventType::REQUIREMENT_ORDERED, app::TraceEventType::REQUIREMENT_ORDERED,
+            app::TraceEventType::FAILED, app::TraceEventType::ALLOCATED, app::TraceEventType::FORKED,
+            app::TraceEventType::ALLOCATED, app::TraceEventType::FAILED};
+        check(seen.size() == 9, "one event per step");
+        for (size_t i = 0; i < seen.size(); ++i) {
+            check(seen[i].type == expected[i], "event " + std::to_string(i));
+        }
+        check(seen[4].subject == "too_big" &&
+              seen[4].values[1] == static_cast<uint64_t>(app::FailureReason::NO_ADDRESS), "no address");
+        check(seen[5].subject == "global" && seen[5].values[0] == 64, "global after the untraced buffer");
+        check(seen[6].values[0] == 1 && seen[6].values[1] == 2, "fork from one to two mappings");
+        check(seen[7].values[0] == 576 && seen[7].values[1] == 256 && seen[7].values[2] == 2, "pe0 placement");
+        check(seen[8].subject == "auto_too_big" &&
+              seen[8].values[1] == static_cast<uint64_t>(app::FailureReason::NO_COMBINATION), "no combination");
+
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
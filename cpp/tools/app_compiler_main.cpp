@@ -0,0 +1,405 @@
+#include <cctype>
+#include <cstdlib>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "app_compiler.hpp"
+#include "command_graph.hpp"
+#include "image_verifier.hpp"
+#include "register_shadow.hpp"
+#include "stream_partitioner.hpp"
+
+#ifdef __linux__
+#include <csignal>
+#include "compile_server.hpp"
+#endif
+
+namespace {
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " <manifest> -o <image> [options]\n"
+#ifdef __linux__
+              << "       " << program << " --serve <socket> [--workers <n>]\n"
+#endif
+              << "       " << program << " [<manifest>] --verify <image>\n"
+              << "Options:\n"
+              << "  -o <file>          Write the final initialization image\n"
+              << "  --template <file>  Write the binary sequence with VRD slots\n"
+              << "  --threads <n>      Worker threads (default: hardware concurrency)\n"
+              << "  --no-dedup         Load every kernel binary, even if already resident\n"
+              << "  --prioritize       Load kernels by descending deployment weight\n"
+              << "  --target <t>       Target profile (chip, haps or a profile file) instead of\n"
+              << "                     the manifest's; DMAs are normalized if it limits bursts\n"
+              << "  --dma-burst <n>    Split DMAs into bursts of at most n bytes (default: target)\n"
+              << "  --dma-align <n>    Align DMA destinations and lengths to n bytes (default:\n"
+              << "                     target, once DMA normalization is enabled)\n"
+              << "  --dma-pad          Pad unaligned DMAs instead of splitting them\n"
+              << "  --streams <n>      Also split the image into up to n streams for parallel\n"
+              << "                     loaders, written to <image>.0 .. <image>.<n-1>\n"
+              << "  --stats            Print build statistics and the estimated load time\n"
+              << "  --trailer          Append a CRC32C checksum trailer to the image\n"
+              << "  --index <file>     Write the command index of the image\n"
+              << "  --checkpoints <n>  Insert a checkpoint command every n commands\n"
+              << "  --resume-from <k>  Write an image that restores the registers written by\n"
+              << "                     commands 0..k-1 and continues at command k\n"
+              << "  --verify <image>   Check the framing and checksum trailer of an image, and\n"
+              << "                     with a manifest, that it matches the compiled application\n"
+              << "                     (command by command unless its DMAs are normalized)\n"
+#ifdef __linux__
+              << "  --connect <socket> Compile on a running compile server\n"
+              << "  --serve <socket>   Run a compile server until SIGINT/SIGTERM\n"
+              << "  --workers <n>      Requests served concurrently by the server\n"
+#endif
+              ;
+}
+
+// Invalid command line, reported with the usage
+struct UsageError : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// Decimal option value that fits 32 bits
+uint32_t parse_count(const std::string& option, const std::string& value) {
+    if (!value.empty() && std::isdigit(static_cast<unsigned char>(value[0]))) {
+        try {
+            size_t consumed = 0;
+            unsigned long long number = std::stoull(value, &consumed);
+            if (consumed == value.size() && number <= std::numeric_limits<uint32_t>::max()) {
+                return static_cast<uint32_t>(number);
+            }
+        } catch (const std::logic_error&) {
+        }
+    }
+    throw UsageError("Invalid value '" + value + "' for " + option);
+}
+
+void write_file(const std::string& path, const std::vector<uint8_t>& data) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open output file: " + path);
+    }
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+std::string format_us(uint64_t ns) {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1) << ns / 1000.0 << " us";
+    return text.str();
+}
+
+#ifdef __linux__
+int serve(const std::string& socket_path, size_t num_workers) {
+    // Block the stop signals in every thread and wait for them here
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    app::CompileServer server(socket_path, nullptr, num_workers);
+    server.start();
+    std::cout << "Serving on " << socket_path << std::endl;
+
+    int signal = 0;
+    sigwait(&signals, &signal);
+    server.stop();
+
+    auto stats = server.cache()->stats();
+    std::cout << "Stopped. Templates: " << stats.template_hits << " hits, " << stats.template_misses
+              << " misses; images: " << stats.image_hits << " hits, " << stats.image_misses << " misses; "
+              << "APB settings: " << stats.apb_entries << " kept, " << stats.apb_evictions << " evicted" << std::endl;
+    return 0;
+}
+#endif
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string manifest_path;
+    std::string output_path;
+    std::string template_path;
+    std::string connect_path;
+    std::string serve_path;
+    std::string verify_path;
+    std::string index_path;
+    std::string target;
+    size_t num_workers = 0;
+    size_t resume_from = 0;
+    size_t num_streams = 0;
+    bool resume = false;
+    bool print_stats = false;
+    app::CompileOptions options;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto next_value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    print_usage(argv[0]);
+                    std::exit(2);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "-o") {
+                output_path = next_value();
+            } else if (arg == "--template") {
+                template_path = next_value();
+            } else if (arg == "--threads") {
+                options.build.num_threads = parse_count(arg, next_value());
+            } else if (arg == "--no-dedup") {
+                options.build.deduplicate_binaries = false;
+            } else if (arg == "--prioritize") {
+                options.build.prioritize = true;
+            } else if (arg == "--target") {
+                target = next_value();
+            } else if (arg == "--dma-burst") {
+                options.dma.max_burst = parse_count(arg, next_value());
+            } else if (arg == "--dma-align") {
+                options.dma.alignment = parse_count(arg, next_value());
+            } else if (arg == "--dma-pad") {
+                options.dma.pad = true;
+            } else if (arg == "--streams") {
+                num_streams = parse_count(arg, next_value());
+            } else if (arg == "--stats") {
+                print_stats = true;
+            } else if (arg == "--trailer") {
+                options.generate.checksum_trailer = true;
+            } else if (arg == "--index") {
+                index_path = next_value();
+            } else if (arg == "--checkpoints") {
+                options.generate.checkpoint_interval = parse_count(arg, next_value());
+            } else if (arg == "--resume-from") {
+                resume_from = parse_count(arg, next_value());
+                resume = true;
+            } else if (arg == "--verify") {
+                verify_path = next_value();
+#ifdef __linux__
+            } else if (arg == "--connect") {
+                connect_path = next_value();
+            } else if (arg == "--serve") {
+                serve_path = next_value();
+            } else if (arg == "--workers") {
+                num_workers = parse_count(arg, next_value());
+#endif
+            } else if (arg == "-h" || arg == "--help") {
+                print_usage(argv[0]);
+                return 0;
+            } else if (manifest_path.empty() && arg[0] != '-') {
+                manifest_path = arg;
+            } else {
+                print_usage(argv[0]);
+                return 2;
+            }
+        }
+
+        // Manifest with the target overridden from the command line
+        auto load_manifest = [&]() {
+            auto manifest = app::load_manifest(manifest_path);
+            if (!target.empty()) {
+                manifest.target = target;
+            }
+            return manifest;
+        };
+
+        if (!verify_path.empty()) {
+            auto image = app::read_binary_file(verify_path);
+            app::VerifyResult verified;
+            if (!manifest_path.empty()) {
+                app::AppCompiler compiler;
+                verified = compiler.verify(load_manifest(), image.data(), image.size(), options);
+            } else {
+                verified = app::verify_init_sequence(image.data(), image.size());
+            }
+            if (!verified.ok) {
+                throw std::runtime_error(verified.error + " at command " + std::to_string(verified.failed_command) +
+                                         " (offset " + std::to_string(verified.failed_offset) + ")");
+            }
+            std::cout << "OK: " << verified.command_count << " commands, "
+                      << (verified.has_trailer ? "checksum trailer verified" : "no checksum trailer") << std::endl;
+            return 0;
+        }
+
+#ifdef __linux__
+        if (!serve_path.empty()) {
+            return serve(serve_path, num_workers);
+        }
+#endif
+
+        if (manifest_path.empty() || (output_path.empty() && template_path.empty())) {
+            print_usage(argv[0]);
+            return 2;
+        }
+
+        if (resume) {
+            if (output_path.empty() || !template_path.empty() || !connect_path.empty()) {
+                throw std::runtime_error("--resume-from produces the final image only; use -o");
+            }
+            auto manifest = load_manifest();
+            options.index_commands = !index_path.empty();
+            app::AppCompiler compiler;
+            auto result = compiler.resume(manifest, resume_from, options);
+            write_file(output_path, result.init_sequence);
+            if (!index_path.empty()) {
+                write_file(index_path, result.index.serialize());
+            }
+            if (print_stats) {
+                auto registers = compiler.bind(manifest, options.build).register_state(resume_from);
+                std::cout << "Registers restored: " << registers.size() << "\n"
+                          << "Image bytes: " << result.init_sequence.size() << std::endl;
+            }
+            return 0;
+        }
+
+#ifdef __linux__
+        if (!connect_path.empty()) {
+            if (!template_path.empty() || !index_path.empty() || output_path.empty()) {
+                throw std::runtime_error("--connect produces the final image only; use -o");
+            }
+            app::CompileRequest request;
+            request.manifest_path = std::filesystem::absolute(manifest_path).string();
+            request.num_threads = options.build.num_threads;
+            request.deduplicate_binaries = options.build.deduplicate_binaries;
+            request.prioritize = options.build.prioritize;
+            request.checksum_trailer = options.generate.checksum_trailer;
+            request.dma = options.dma;
+            request.target = target;
+            if (!target.empty() && target != "chip" && target != "haps") {
+                request.target = std::filesystem::absolute(target).string();
+            }
+
+            auto response = app::request_compile(connect_path, request);
+            if (!response.ok) {
+                throw std::runtime_error(response.message);
+            }
+            write_file(output_path, response.image.read());
+            if (print_stats) {
+                std::cout << response.message << std::endl;
+            }
+            return 0;
+        }
+#endif
+
+        options.bind_vrds = !output_path.empty();
+        options.index_commands = !index_path.empty();
+        options.estimate_load = print_stats && options.bind_vrds;
+        if (options.index_commands && !options.bind_vrds) {
+            throw std::runtime_error("--index needs the final image; use -o");
+        }
+
+        auto manifest = load_manifest();
+        auto profile = app::target_profile(manifest);
+        auto dma_rules = app::dma_rules_for(manifest, options.dma);
+
+        app::AppCompiler compiler;
+        auto result = compiler.compile(manifest, options);
+
+        if (!template_path.empty()) {
+            write_file(template_path, result.template_sequence);
+        }
+        if (!output_path.empty()) {
+            write_file(output_path, result.init_sequence);
+        }
+        if (!index_path.empty()) {
+            write_file(index_path, result.index.serialize());
+        }
+
+        app::PartitionedImage partitioned;
+        if (num_streams > 0) {
+            if (output_path.empty()) {
+                throw std::runtime_error("--streams needs the final image; use -o");
+            }
+            app::PartitionOptions partition_options;
+            partition_options.num_streams = num_streams;
+            partition_options.checksum_trailer = options.generate.checksum_trailer;
+            partition_options.normalize_dma = dma_rules.has_value();
+            partition_options.dma_rules = dma_rules.value_or(app::DmaRules());
+
+            // Partitioning needs the image as generated from the build
+            const auto* source = &result.init_sequence;
+            std::vector<uint8_t> unnormalized;
+            if (dma_rules) {
+                unnormalized = compiler.bind(manifest, options.build).generate_init_sequence(options.generate);
+                source = &unnormalized;
+            }
+            partitioned = app::partition_image(result.build, source->data(), source->size(), partition_options);
+            for (size_t i = 0; i < partitioned.streams.size(); ++i) {
+                write_file(output_path + "." + std::to_string(i), partitioned.streams[i].data);
+            }
+        }
+
+        if (print_stats) {
+            const auto& dedup = result.build.dedup_stats;
+            auto graph = app::CommandGraph::build(result.build);
+            std::cout << "Target: " << profile.name << " (" << profile.size_x << "x" << profile.size_y << ")\n"
+                      << "Kernels: " << result.build.kernel_spans.size() << "\n"
+                      << "Sequences: " << result.build.sequences.size() << "\n"
+                      << "Template bytes: " << result.template_sequence.size() << "\n"
+                      << "Image bytes: " << result.init_sequence.size() << "\n"
+                      << "Image CRC32C: 0x" << std::hex << result.integrity.image_checksum << std::dec << "\n"
+                      << "Binaries deduplicated: " << dedup.images_deduplicated
+                      << " (" << dedup.bytes_saved << " bytes saved)" << "\n"
+                      << "Dependency graph: " << graph.size() << " nodes, " << graph.edge_count()
+                      << " edges, depth " << graph.depth() << std::endl;
+            if (dma_rules) {
+                const auto& dma = result.dma_stats;
+                std::cout << "DMAs: " << dma.input_dmas << " in, " << dma.output_dmas << " out ("
+                          << dma.merged << " merged, " << dma.split << " split, " << dma.padded << " padded, "
+                          << dma.pad_bytes << " pad bytes)" << std::endl;
+            }
+            const auto& estimate = result.load_estimate;
+            if (options.estimate_load) {
+                std::cout << "Estimated load time: " << format_us(estimate.total.ns) << " (setup "
+                          << format_us(estimate.setup.ns) << ", network switches " << format_us(estimate.switches.ns)
+                          << ")" << std::endl;
+                for (const auto& type : estimate.by_type) {
+                    std::cout << "  " << app::command_type_name(type.first) << ": " << type.second.commands
+                              << " commands, " << format_us(type.second.ns) << std::endl;
+                }
+                for (const auto& network : estimate.by_network) {
+                    std::cout << "  " << network.first.value() << ": " << network.second.commands << " commands, "
+                              << format_us(network.second.ns) << std::endl;
+                }
+            }
+            for (size_t i = 0; i < result.kernel_ready.size(); ++i) {
+                const auto& ready = result.kernel_ready[i];
+                std::cout << "Kernel " << ready.kernel << " (deployment " << ready.deployment << ") ready after "
+                          << ready.command_count << " commands, " << ready.offset << " bytes";
+                if (i < estimate.kernels.size()) {
+                    std::cout << ", est. " << format_us(estimate.kernels[i].ready_ns);
+                }
+                std::cout << std::endl;
+            }
+            app::CostModel model(profile);
+            uint64_t parallel_ns = 0;
+            for (size_t i = 0; i < partitioned.streams.size(); ++i) {
+                const auto& stream = partitioned.streams[i];
+                uint64_t stream_ns = model.estimate(stream.data.data(), stream.data.size()).total.ns;
+                parallel_ns = std::max(parallel_ns, stream_ns);
+                std::cout << "Stream " << i << ": " << stream.domains.size() << " domains, "
+                          << stream.command_count << " commands, " << stream.data.size() << " bytes, est. "
+                          << format_us(stream_ns) << std::endl;
+            }
+            if (!partitioned.streams.empty()) {
+                // Fence waits are not modeled, so this is a lower bound
+                std::cout << "Fences: " << partitioned.fence_count << "\n"
+                          << "Estimated parallel load time: " << format_us(parallel_ns) << " or more" << std::endl;
+            }
+        }
+        return 0;
+    } catch (const UsageError& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        print_usage(argv[0]);
+        return 2;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "requirement_stream.hpp"
+
+namespace {
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " <stream|-> [options]\n"
+              << "Replays a requirement stream on the native memory manager and prints one\n"
+              << "line per requirement, then the totals and the fastest replay time.\n"
+              << "Options:\n"
+              << "  --repeat <n>  Replay n times and report the fastest (default: 1)\n"
+              << "  --summary     Print only the totals and the time\n"
+              << "  --explain <k> Print the k best candidates of every auto-selected placement\n"
+              << "  --policy <p>  Placement policy of requirements without their own: worst-fit\n"
+              << "                (default), best-fit, fewest-forks, pe-locality or mss-balance\n"
+              << "  --lookahead <n> Weigh the next n batch requirements against forks\n"
+              << "  --merge       Merge mappings left with equal allocations\n"
+              << "  --coordinates Print every placed coordinate as\n"
+              << "                coord <id> <pe> <mss> <slice> <address> <bytes>\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    size_t repeat = 1;
+    bool summary_only = false;
+    bool coordinates = false;
+    app::ReplayOptions options;
+    std::string policy = "worst-fit";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--repeat" && i + 1 < argc) {
+            repeat = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--explain" && i + 1 < argc) {
+            options.explain = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--lookahead" && i + 1 < argc) {
+            options.lookahead = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--policy" && i + 1 < argc) {
+            policy = argv[++i];
+        } else if (arg == "--coordinates") {
+            coordinates = true;
+        } else if (arg == "--merge") {
+            options.merge = true;
+        } else if (arg == "--summary") {
+            summary_only = true;
+        } else if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (path.empty()) {
+            path = arg;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (path.empty()) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    try {
+        options.policy = app::parse_placement_policy(policy);
+        app::RequirementStream stream;
+        if (path == "-") {
+            stream = app::RequirementStream::parse(std::cin);
+        } else {
+            std::ifstream file(path);
+            if (!file) {
+                throw std::runtime_error("Failed to open requirement stream: " + path);
+            }
+            stream = app::RequirementStream::parse(file);
+        }
+
+        // Time replays without parsing or output
+        uint64_t best_ns = UINT64_MAX;
+        app::MemoryManager manager(1, 1, 1, 1);
+        for (size_t run = 0; run < repeat; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            manager = stream.replay(options);
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            best_ns = std::min<uint64_t>(best_ns, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+
+        if (!summary_only) {
+            for (const auto& record : manager.requirements()) {
+                std::cout << app::format_record(record) << '\n';
+            }
+            for (const auto& explanation : manager.explanations()) {
+                std::cout << app::format_explanation(manager, explanation);
+            }
+            if (coordinates) {
+                app::CoordinatePlacements placed = manager.materialize();
+                for (size_t i = 0; i < placed.count(); ++i) {
+                    std::cout << "coord " << manager.requirements()[placed.requirement[i]].requirement.allocation_id
+                              << ' ' << placed.pe[i] << ' ' << placed.mss[i] << ' ' << placed.slice[i] << " 0x"
+                              << std::hex << placed.address[i] << std::dec << ' ' << placed.size[i] << '\n';
+                }
+            }
+        }
+        auto summary = manager.summary();
+        std::cout << "mappings " << summary.mappings << " forks " << summary.forks << " allocated "
+                  << summary.allocated_bytes << '\n';
+        if (options.lookahead > 0) {
+            std::cout << "forks_avoided " << summary.forks_avoided << '\n';
+        }
+        std::cout << "time_ns " << best_ns << '\n';
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -2,11 +2,14 @@ from typing import Dict, List, Optional, Tuple, Union, Any, Set
 from hw_components import KernelSizeComponent, BroadCastNetwork
 from kernel_types import KernelSize, KernelLocation, KernelSuperGroup
 from grid_noc import GridNOC
+from target_profile import TargetProfile
 from bird import NetworkType, BirdCommandSequence
 
 class Grid:
     """Represents the hardware platform grid configuration"""
-    def __init__(self, size_x: int, size_y: int):
+    def __init__(self, size_x: int, size_y: int, profile: Optional[TargetProfile] = None):
+        # Device limits; the grid size given here overrides the profile's
+        self.profile = profile or TargetProfile.chip()
         self.size_x = size_x
         self.size_y = size_y
         # Set of regular nodes (x, y) that are allocated
@@ -14,7 +17,7 @@ class Grid:
         # Dict mapping (x, y) to set of allocated vcores
         self.allocated_vcores: Dict[Tuple[int, int], Set[int]] = {}
         # Network components
-        self.noc = GridNOC()
+        self.noc = GridNOC(self.profile)
         
     def add_broadcast_network(self, supergroup: KernelSuperGroup, network_type: NetworkType) -> BroadCastNetwork:
         """Add a broadcast network for a specific supergroup and network type.
@@ -130,12 +133,14 @@ class Grid:
 
 class Chip(Grid):
     """Represents a 16x16 chip grid"""
-    def __init__(self):
-        super().__init__(16, 16)
+    def __init__(self, profile: Optional[TargetProfile] = None):
+        profile = profile or TargetProfile.chip()
+        super().__init__(profile.size_x, profile.size_y, profile)
 
 
 class Haps(Grid):
-    """Represents a 16x16 chip grid"""
-    def __init__(self):
-        super().__init__(4, 2)
+    """Represents a 4x2 HAPS prototyping grid"""
+    def __init__(self, profile: Optional[TargetProfile] = None):
+        profile = profile or TargetProfile.haps()
+        super().__init__(profile.size_x, profile.size_y, profile)
 
@@ -1,14 +1,19 @@
 from typing import Dict, List, Optional, Tuple, Union, Any
 from hw_components import BroadCastNetwork, AXI2AHB
+from target_profile import TargetProfile
 from kernel_types import KernelSize, KernelLocation, KernelSuperGroup
 from bird import NetworkType, BirdCommandSequence, GridDestinationType, BroadcastType
 
 class GridNOC:
     """Handles all network-related functionality for a grid"""
     
-    def __init__(self):
+    def __init__(self, profile: Optional[TargetProfile] = None):
+        profile = profile or TargetProfile.chip()
         # Network components
-        self.axi2ahb = AXI2AHB()
+        self.axi2ahb = AXI2AHB(line_id_count=profile.line_id_count)
+        # Broadcast networks the target can hold, 0 for no limit
+        self.broadcast_groups = profile.broadcast_groups
+        self.broadcast_group_count = 0
         # Command sequence for all broadcast networks
         self.broadcast_sequence = BirdCommandSequence(
             description="NOC Broadcast and AXI2AHB Network Configuration",
@@ -39,6 +44,9 @@ class GridNOC:
             supergroup: The supergroup this network will serve
             network_type: The type of network to create
         """
+        if self.broadcast_groups and self.broadcast_group_count >= self.broadcast_groups:
+            raise ValueError(f"No available broadcast groups (all {self.broadcast_groups} are in use)")
+        self.broadcast_group_count += 1
         # Create a temporary broadcast network to get its settings
         network = BroadCastNetwork(
             f"network_{network_type.value}_{supergroup.x}_{supergroup.y}",
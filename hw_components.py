@@ -9,6 +9,7 @@ from kernel_types import (
 )
 from bird import BirdCommandSequence, NetworkType, BroadcastType, GridDestinationType, BirdCommand, BirdCommandType
 from apb_config import config_vcore, broadcast_config, barrier_config
+from trace_events import EventSink, EventType, default_sink
 
 class HWComponent:
     """Base class for hardware components"""
@@ -412,8 +413,11 @@ class BroadCastNetwork(HWComponent):
 class AXI2AHB(HWComponent):
     """Class representing the AXI2AHB bridge configuration for all networks"""
 
-    def __init__(self, name: str = "AXI2AHB_Bridge"):
+    def __init__(self, name: str = "AXI2AHB_Bridge", line_id_count: int = 16,
+                 events: Optional[EventSink] = None):
         super().__init__(name)
+        self.line_id_count = line_id_count
+        self.events = events or default_sink()
         # Dictionary mapping network_type to line_id
         self.network_configs: Dict[NetworkType, int] = {}
         # Dictionary mapping line_id to network_type
@@ -425,21 +429,22 @@ class AXI2AHB(HWComponent):
         Args:
             network_type: The type of network to configure
         """
-        # Find next available line_id (0-15)
+        # Find next available line_id
         line_id = self._get_next_line_id()
         
         # Store configuration
-        print(f"Adding network {network_type} to AXI2AHB bridge at line_id {line_id}")
+        if self.events.enabled:
+            self.events.emit(EventType.NETWORK_ADDED, str(network_type), line_id)
         self.network_configs[network_type] = line_id
         self.line_id_to_network[line_id] = network_type
 
     def _get_next_line_id(self) -> int:
-        """Find the next available line ID (0-15)"""
+        """Find the next available line ID"""
         used_ids = set(self.line_id_to_network.keys())
-        for i in range(16):
+        for i in range(self.line_id_count):
             if i not in used_ids:
                 return i
-        raise ValueError("No available line IDs (all 16 are in use)")
+        raise ValueError(f"No available line IDs (all {self.line_id_count} are in use)")
 
     def get_apb_settings(self) -> BirdCommandSequence:
         """Returns APB settings for all configured networks in the AXI2AHB bridge.
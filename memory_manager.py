@@ -1,8 +1,11 @@
 from typing import Dict, List, Optional, Tuple, Set, Any
 from dataclasses import dataclass, field
 from enum import Enum
+import bisect
 import copy
 
+from trace_events import EventSink, EventType, FailureReason, default_sink
+
 
 class DimensionScope(Enum):
     ALL = "all"           # All resources in this dimension
@@ -19,6 +22,19 @@ class SliceGroup(Enum):
     GROUP_0_3 = "group_0_3"  # Slices 0, 1, 2, 3
     GROUP_4_7 = "group_4_7"  # Slices 4, 5, 6, 7
 
+    @property
+    def mask(self) -> int:
+        """Slice bitmask of the group"""
+        return 0x0F if self == SliceGroup.GROUP_0_3 else 0xF0
+
+
+def slice_mask(slices) -> int:
+    """Bitmask of slice indices, e.g. slice_mask(range(0, 8, 2)) == 0x55"""
+    mask = 0
+    for slice_id in slices:
+        mask |= 1 << slice_id
+    return mask
+
 
 class RequirementState(Enum):
     PENDING = "pending"       # Not yet allocated
@@ -47,8 +63,9 @@ class AllocationDetails:
     allocated_address: int
     resolved_pe: int
     resolved_mss: int
-    resolved_slice_values: List[int]  # For slice groups, this will be [0,1,2,3] or [4,5,6,7]
+    resolved_slice_values: List[int]  # For slice groups, the slices of the group mask
     mapping_count_at_allocation: int  # How many mappings existed when this was allocated
+    slice_allocation_size: int = 0    # Bytes allocated in each covered slice
     
     def __str__(self):
         slice_str = f"{self.resolved_slice_values}" if len(self.resolved_slice_values) > 1 else str(self.resolved_slice_values[0])
@@ -60,6 +77,7 @@ class DimensionRequirement:
     scope: DimensionScope
     value: Optional[int] = None
     group: Optional[SliceGroup] = None
+    mask: Optional[int] = None   # GROUP scope: any slice bitmask, instead of group
     
     def needs_selection(self) -> bool:
         return self.scope == DimensionScope.SPECIFIC and self.value is None
@@ -71,17 +89,23 @@ class DimensionRequirement:
         elif self.scope == DimensionScope.SPECIFIC:
             return [self.value] if self.value is not None else list(range(dimension_size))
         elif self.scope == DimensionScope.GROUP:
-            return self._get_group_values(self.group)
+            return self._get_group_values(dimension_size)
         else:
             raise ValueError(f"Unknown scope: {self.scope}")
     
-    def _get_group_values(self, group: SliceGroup) -> List[int]:
-        if group == SliceGroup.GROUP_0_3:
-            return [0, 1, 2, 3]
-        elif group == SliceGroup.GROUP_4_7:
-            return [4, 5, 6, 7]
-        else:
-            raise ValueError(f"Unknown slice group: {group}")
+    def group_mask(self) -> int:
+        """Bitmask of a GROUP scope: mask if given, else the mask of group"""
+        if self.mask is not None:
+            return self.mask
+        if self.group is not None:
+            return self.group.mask
+        raise ValueError("Group scope needs a group or a mask")
+    
+    def _get_group_values(self, dimension_size: int) -> List[int]:
+        mask = self.group_mask()
+        if mask <= 0 or mask >> dimension_size:
+            raise ValueError(f"Slice mask 0x{mask:x} does not fit {dimension_size} slices")
+        return [i for i in range(dimension_size) if mask >> i & 1]
 
 
 @dataclass
@@ -99,6 +123,9 @@ class MemoryRequirement:
     slice_req: DimensionRequirement        # Slice dimension requirement
     allocation_mode: SliceAllocationMode = SliceAllocationMode.SERIAL
     allocation_id: str = ""
+    interleave_width: int = 1              # PARALLEL: bytes per slice per stripe
+    placement_policy: str = "default"      # "default"/"worst-fit" or "pe-locality"
+    home_pe: int = 0                       # pe-locality: PE to stay close to
     
     # State tracking fields
     state: RequirementState = field(default=RequirementState.PENDING)
@@ -142,28 +169,35 @@ class MemoryRequirement:
         
         return coords
     
+    def _dimension_count(self, index: int) -> int:
+        """Number of resources the requirement covers in one dimension"""
+        dim_req = self.dimension_reqs[index]
+        if dim_req.scope == DimensionScope.SPECIFIC:
+            return 1
+        return len(dim_req.get_possible_values(self.get_dimension_sizes()[index]))
+    
+    def slice_allocation_size(self) -> int:
+        """
+        Bytes allocated in each covered slice. SERIAL allocates size in every
+        slice; PARALLEL stripes size over the covered slices in stripes of
+        interleave_width bytes, rounded up to whole stripes.
+        """
+        if self.allocation_mode != SliceAllocationMode.PARALLEL:
+            return self.size
+        if self.interleave_width <= 0:
+            raise ValueError("Interleave width must be positive")
+        stripe = self._dimension_count(2) * self.interleave_width
+        return -(-self.size // stripe) * self.interleave_width
+    
     def total_allocation_size(self) -> int:
         """
-        Calculate the total number of bytes that will be allocated for this requirement.
-        Returns size * number_of_affected_coordinates based on the requirement scopes.
-        For parallel allocation mode, the effective size per coordinate is size // 4.
+        Calculate the total number of bytes that will be allocated for this requirement:
+        slice_allocation_size() in each affected coordinate.
         """
-        dimension_sizes = self.get_dimension_sizes()
-        
-        # Total coordinates = product of affected counts across all dimensions
         total_coordinates = 1
-
-        # Calculate affected count for each dimension based on scope
-        affected_counts = []
-        for i, dim_req in enumerate(self.dimension_reqs):
-            if dim_req.scope == DimensionScope.ALL:
-                total_coordinates *= dimension_sizes[i]
-            elif dim_req.scope == DimensionScope.GROUP:
-                assert self.allocation_mode == SliceAllocationMode.PARALLEL
-            else: # SPECIFIC (no need to multiply)
-                pass
-           
-        return self.size * total_coordinates
+        for i in range(len(self.dimension_reqs)):
+            total_coordinates *= self._dimension_count(i)
+        return self.slice_allocation_size() * total_coordinates
     
     def mark_fulfilled(self, allocated_address: int, resolved_req: 'MemoryRequirement', mapping_count: int):
         """Mark this requirement as fulfilled with allocation details"""
@@ -174,7 +208,7 @@ class MemoryRequirement:
         # Handle slice values (could be single value or group)
         slice_req = resolved_req.dimension_reqs[2]
         if slice_req.scope == DimensionScope.GROUP:
-            resolved_slice_values = slice_req.get_possible_values(8)  # 8 slices per MSS
+            resolved_slice_values = slice_req.get_possible_values(MemoryRequirement.slices_per_mss)
         else:
             resolved_slice_values = [slice_req.value]
         
@@ -183,7 +217,8 @@ class MemoryRequirement:
             resolved_pe=resolved_pe,
             resolved_mss=resolved_mss,
             resolved_slice_values=resolved_slice_values,
-            mapping_count_at_allocation=mapping_count
+            mapping_count_at_allocation=mapping_count,
+            slice_allocation_size=resolved_req.slice_allocation_size()
         )
         self.state = RequirementState.FULFILLED
     
@@ -204,100 +239,103 @@ class MemoryRequirement:
 
 
 class SliceMemoryMap:
+    """
+    Allocations of one slice. Free ranges, their sizes and the allocated
+    total are kept up to date on every allocation, so statistics queries
+    do not rescan the allocations. The state hash combines the allocations
+    independently of their order, so maps holding the same allocations
+    hash equal.
+    """
     def __init__(self, slice_size: int = 1024*1024):  # 1MB default
         self.slice_size = slice_size
         self.allocations = []  # List of (start, size, allocation_id)
         self.next_address = 0
+        self._allocated = 0
+        self._free_ranges: List[Tuple[int, int]] = [(0, slice_size)]  # Sorted (start, end)
+        self._free_sizes: Dict[int, int] = {slice_size: 1}             # Size -> number of free ranges
+        self._largest = slice_size
+        self._state_hash = 0
     
     def get_total_allocated(self) -> int:
         """Return total allocated bytes in this map"""
-        return sum(size for _, size, _ in self.allocations)
+        return self._allocated
     
     def get_total_free(self) -> int:
         """Return total free bytes in this map"""
-        return self.slice_size - self.get_total_allocated()
+        return self.slice_size - self._allocated
     
     def get_largest_free_block(self) -> int:
         """Return size of largest contiguous free block"""
-        if not self.allocations:
-            return self.slice_size
-        
-        # Calculate gaps between allocations
-        sorted_allocs = sorted(self.allocations, key=lambda x: x[0])
-        max_gap = 0
-        
-        # Check gap before first allocation
-        if sorted_allocs:
-            max_gap = max(max_gap, sorted_allocs[0][0])
-        
-        # Check gaps between allocations
-        for i in range(len(sorted_allocs) - 1):
-            current_end = sorted_allocs[i][0] + sorted_allocs[i][1]
-            next_start = sorted_allocs[i + 1][0]
-            gap = next_start - current_end
-            max_gap = max(max_gap, gap)
-        
-        # Check gap after last allocation
-        if sorted_allocs:
-            last_end = sorted_allocs[-1][0] + sorted_allocs[-1][1]
-            max_gap = max(max_gap, self.slice_size - last_end)
-        
-        return max_gap
+        return self._largest
     
     def can_accommodate(self, size: int) -> bool:
         """Check if this map can accommodate an allocation of given size"""
-        return self.get_largest_free_block() >= size
+        return self._largest >= size
     
     def get_free_ranges(self) -> List[Tuple[int, int]]:
         """Get list of (start, end) free ranges"""
-        if not self.allocations:
-            return [(0, self.slice_size)]
-        
-        sorted_allocs = sorted(self.allocations, key=lambda x: x[0])
-        free_ranges = []
-        
-        # Range before first allocation
-        if sorted_allocs[0][0] > 0:
-            free_ranges.append((0, sorted_allocs[0][0]))
-        
-        # Ranges between allocations
-        for i in range(len(sorted_allocs) - 1):
-            current_end = sorted_allocs[i][0] + sorted_allocs[i][1]
-            next_start = sorted_allocs[i + 1][0]
-            if next_start > current_end:
-                free_ranges.append((current_end, next_start))
-        
-        # Range after last allocation
-        last_end = sorted_allocs[-1][0] + sorted_allocs[-1][1]
-        if last_end < self.slice_size:
-            free_ranges.append((last_end, self.slice_size))
-        
-        return free_ranges
+        return list(self._free_ranges)
     
     def allocate_serial(self, size: int, allocation_id: str) -> Optional[int]:
         """Normal contiguous allocation"""
-        free_ranges = self.get_free_ranges()
-        for start, end in free_ranges:
+        if self._largest < size:
+            return None
+        for index, (start, end) in enumerate(self._free_ranges):
             if end - start >= size:
-                self.allocations.append((start, size, allocation_id))
+                self._take(index, start, size, allocation_id)
                 return start
         return None
     
     def allocate_at_address(self, address: int, size: int, allocation_id: str) -> bool:
         """Allocate at specific address"""
         # Check if address range is free
-        free_ranges = self.get_free_ranges()
-        for start, end in free_ranges:
-            if start <= address and address + size <= end:
-                self.allocations.append((address, size, allocation_id))
-                return True
+        index = bisect.bisect_right(self._free_ranges, (address, float('inf'))) - 1
+        if index < 0:
+            return False
+        start, end = self._free_ranges[index]
+        if start <= address and address + size <= end:
+            self._take(index, address, size, allocation_id)
+            return True
         return False
     
+    def _take(self, index: int, address: int, size: int, allocation_id: str):
+        """Split free range index around an allocation inside it"""
+        start, end = self._free_ranges[index]
+        pieces = [(a, b) for a, b in ((start, address), (address + size, end)) if a < b]
+        self._free_ranges[index:index + 1] = pieces
+        
+        self._free_sizes[end - start] -= 1
+        if self._free_sizes[end - start] == 0:
+            del self._free_sizes[end - start]
+        for a, b in pieces:
+            self._free_sizes[b - a] = self._free_sizes.get(b - a, 0) + 1
+        if end - start == self._largest and end - start not in self._free_sizes:
+            # Pieces are smaller than the split range
+            self._largest = max(self._free_sizes, default=0)
+        
+        self.allocations.append((address, size, allocation_id))
+        self._allocated += size
+        self._state_hash ^= hash((address, size, allocation_id))
+    
+    def state_hash(self) -> int:
+        """Hash of the allocations, kept up to date on every allocation"""
+        return self._state_hash
+    
+    def same_state(self, other: 'SliceMemoryMap') -> bool:
+        """Whether both maps hold the same allocations"""
+        return (self._state_hash == other._state_hash and self._allocated == other._allocated and
+                sorted(self.allocations) == sorted(other.allocations))
+    
     def clone(self) -> 'SliceMemoryMap':
         """Create a deep copy of this memory map"""
         new_map = SliceMemoryMap(self.slice_size)
         new_map.allocations = self.allocations.copy()
         new_map.next_address = self.next_address
+        new_map._allocated = self._allocated
+        new_map._free_ranges = self._free_ranges.copy()
+        new_map._free_sizes = self._free_sizes.copy()
+        new_map._largest = self._largest
+        new_map._state_hash = self._state_hash
         return new_map
 
 
@@ -454,10 +492,17 @@ class UnifiedDimensionResolver:
         if len(affected_mappings) == 0:
             return -1  # Invalid combination
         
+        if req.placement_policy == "pe-locality":
+            if not all(mapping.can_accommodate(req.slice_allocation_size()) for mapping in affected_mappings):
+                return -1
+            return self._pe_locality_score(test_req, affected_mappings)
+        if req.placement_policy not in ("default", "worst-fit"):
+            raise ValueError(f"Unknown placement policy: {req.placement_policy}")
+
         if len(affected_mappings) == 1:
             # Single mapping - check if it can accommodate
             mapping = next(iter(affected_mappings))
-            if mapping.can_accommodate(req.size):
+            if mapping.can_accommodate(req.slice_allocation_size()):
                 return mapping.get_total_free()  # Score by free space
             else:
                 return -1
@@ -465,17 +510,39 @@ class UnifiedDimensionResolver:
             # Multiple mappings - would need intersection
             # Score by minimum free space across all mappings
             min_free = min(mapping.get_total_free() for mapping in affected_mappings)
-            if all(mapping.can_accommodate(req.size) for mapping in affected_mappings):
+            if all(mapping.can_accommodate(req.slice_allocation_size()) for mapping in affected_mappings):
                 return min_free * 0.8  # Slight penalty for cross-mapping allocation
             else:
                 return -1
 
+    def _pe_locality_score(self, req: MemoryRequirement, affected_mappings: Set[SliceMemoryMap]) -> float:
+        """Grid steps from the home PE, then most free space (matches the native PeLocalityPolicy)"""
+        manager = self.memory_manager
+        distance = 0
+        pe = req.pe_req
+        if pe.scope == DimensionScope.SPECIFIC:
+            width = manager.grid_width
+            distance = abs(pe.value % width - req.home_pe % width) + abs(pe.value // width - req.home_pe // width)
+        min_free = min(mapping.get_total_free() for mapping in affected_mappings)
+        return float(manager.pe_count - min(distance, manager.pe_count)) + min_free / (manager.slice_size + 1)
+
 
 class MappingCentricMemoryManager:
-    def __init__(self, pe_count: int, mss_per_pe: int = 4, slices_per_mss: int = 8):
+    def __init__(self, pe_count: int, mss_per_pe: int = 4, slices_per_mss: int = 8,
+                 slice_size: int = 1024*1024, events: Optional[EventSink] = None,
+                 auto_merge: bool = False, grid_width: Optional[int] = None):
         self.pe_count = pe_count
+        # PEs per grid row for pe-locality distances; one row by default
+        self.grid_width = grid_width or pe_count
         self.mss_per_pe = mss_per_pe
         self.slices_per_mss = slices_per_mss
+        self.slice_size = slice_size
+        
+        # Allocation, fork and failure events; disabled by default
+        self.events = events or default_sink()
+        
+        # Merge mappings with equal allocations after every allocation
+        self.auto_merge = auto_merge
         
         # Set the system dimensions for all MemoryRequirement instances
         MemoryRequirement.set_system_dimensions(pe_count, mss_per_pe, slices_per_mss)
@@ -489,11 +556,30 @@ class MappingCentricMemoryManager:
         # Track collected requirements waiting for batch allocation
         self.collected_requirements: List[MemoryRequirement] = []
         
+        # Running statistics, updated on every allocation
+        self._allocated_bytes = 0
+        self._requested_bytes = 0
+        self._fulfilled_count = 0
+        self._fork_count = 0
+        self._merge_count = 0
+        
         # Initialize with universal mapping covering all coordinates
         self._initialize_universal_mapping()
         
         # Initialize dimension resolver
         self.dimension_resolver = UnifiedDimensionResolver(self)
+
+    @classmethod
+    def from_profile(cls, profile, pe_count: Optional[int] = None, events: Optional[EventSink] = None,
+                     auto_merge: bool = False) -> 'MappingCentricMemoryManager':
+        """Manager with the memory geometry of a target_profile.TargetProfile.
+
+        pe_count defaults to every node of the profile's grid.
+        """
+        if pe_count is None:
+            pe_count = profile.size_x * profile.size_y
+        return cls(pe_count, profile.mss_per_pe, profile.slices_per_mss, profile.slice_size, events, auto_merge,
+                   profile.size_x)
     
     def _initialize_universal_mapping(self):
         """Start with one mapping covering all coordinates"""
@@ -503,7 +589,7 @@ class MappingCentricMemoryManager:
                      for slice_id in range(self.slices_per_mss)}
         
         universal_signature = MappingSignature(all_coords)
-        self.signature_to_map[universal_signature] = SliceMemoryMap()
+        self.signature_to_map[universal_signature] = SliceMemoryMap(self.slice_size)
     
     def get_mapping_for_coordinate(self, coord: ResourceCoordinate) -> SliceMemoryMap:
         """Find which mapping covers this coordinate"""
@@ -564,22 +650,62 @@ class MappingCentricMemoryManager:
                     self.signature_to_map[unaffected_signature] = original_mapping.clone()
                 
                 mappings_forked = True
+                self._fork_count += 1
         
         return mappings_forked
     
+    def merge_equal_mappings(self, subject: str = "") -> int:
+        """
+        Union the signatures of mappings holding the same allocations, as
+        forks leave behind when a forked requirement then fails or later
+        requirements cover the forked mappings alike. Candidates are found
+        by state hash and confirmed by comparing allocations.
+        Returns the number of mappings merged away.
+        """
+        by_hash: Dict[int, List[MappingSignature]] = {}
+        for signature, mapping in self.signature_to_map.items():
+            by_hash.setdefault(mapping.state_hash(), []).append(signature)
+        
+        mappings_before = len(self.signature_to_map)
+        for signatures in by_hash.values():
+            while len(signatures) > 1:
+                first = self.signature_to_map[signatures[0]]
+                equal = [sig for sig in signatures[1:] if self.signature_to_map[sig].same_state(first)]
+                if equal:
+                    coordinates = set(signatures[0].covered_coordinates)
+                    for signature in [signatures[0]] + equal:
+                        coordinates |= signature.covered_coordinates
+                        del self.signature_to_map[signature]
+                    self.signature_to_map[MappingSignature(coordinates)] = first
+                signatures = [sig for sig in signatures[1:] if sig not in equal]
+        
+        merged = mappings_before - len(self.signature_to_map)
+        self._merge_count += merged
+        if merged and self.events.enabled:
+            self.events.emit(EventType.MERGED, subject, mappings_before, len(self.signature_to_map))
+        return merged
+    
     def allocate_requirement(self, req: MemoryRequirement) -> bool:
         """Allocate requirement using the mapping-centric approach"""
         # Add to processed requirements list
         self.processed_requirements.append(req)
         
         # Resolve any unresolved dimensions
-        resolved_req = self.dimension_resolver.resolve_requirement(req)
+        try:
+            resolved_req = self.dimension_resolver.resolve_requirement(req)
+        except AllocationError:
+            if self.events.enabled:
+                self.events.emit(EventType.FAILED, req.allocation_id, req.size, FailureReason.NO_COMBINATION)
+            raise
         
         # Fork mappings if needed (before getting affected mappings)
+        mappings_before = len(self.signature_to_map)
         self._fork_mapping_if_needed(resolved_req)
         
         # Get current mapping count for tracking
         current_mapping_count = len(self.signature_to_map)
+        if self.events.enabled and current_mapping_count != mappings_before:
+            self.events.emit(EventType.FORKED, req.allocation_id, mappings_before, current_mapping_count)
         
         # Get affected mappings (after potential forking)
         affected_mappings = self.get_affected_mappings(resolved_req)
@@ -592,7 +718,8 @@ class MappingCentricMemoryManager:
             if resolved_req.allocation_mode == SliceAllocationMode.PARALLEL:
                 allocated_address = self._allocate_parallel_single_mapping(resolved_req, mapping)
             else:
-                allocated_address = mapping.allocate_serial(resolved_req.size, resolved_req.allocation_id)
+                allocated_address = mapping.allocate_serial(resolved_req.slice_allocation_size(),
+                                                            resolved_req.allocation_id)
         else:
             # Cross-mapping allocation using intersection
             allocated_address = self._allocate_cross_mapping(resolved_req, affected_mappings)
@@ -600,39 +727,47 @@ class MappingCentricMemoryManager:
         # If allocation succeeded, mark the original requirement as fulfilled
         if allocated_address is not None:
             req.mark_fulfilled(allocated_address, resolved_req, current_mapping_count)
-            return True
-        else:
-            return False
+            self._allocated_bytes += (resolved_req.slice_allocation_size() *
+                                      len(resolved_req.get_affected_coordinates()))
+            self._requested_bytes += req.total_allocation_size()
+            self._fulfilled_count += 1
+            if self.events.enabled:
+                self.events.emit(EventType.ALLOCATED, req.allocation_id, allocated_address,
+                                 resolved_req.slice_allocation_size(), current_mapping_count)
+        elif self.events.enabled:
+            self.events.emit(EventType.FAILED, req.allocation_id, req.size, FailureReason.NO_ADDRESS)
+        
+        if self.auto_merge:
+            self.merge_equal_mappings(req.allocation_id)
+        return allocated_address is not None
     
     def _allocate_parallel_single_mapping(self, req: MemoryRequirement, mapping: SliceMemoryMap) -> Optional[int]:
         """Allocate parallel requirement within single mapping"""
-        size_per_slice = req.size // 4
-        return mapping.allocate_serial(size_per_slice, req.allocation_id)
+        return mapping.allocate_serial(req.slice_allocation_size(), req.allocation_id)
     
     def _allocate_cross_mapping(self, req: MemoryRequirement, affected_mappings: Set[SliceMemoryMap]) -> Optional[int]:
         """Allocate requirement across multiple mappings using intersection"""
         mapping_list = list(affected_mappings)
         intersection_map = IntersectionMap(mapping_list)
         
-        if req.allocation_mode == SliceAllocationMode.PARALLEL:
-            size_per_slice = req.size // 4
-            allocated_addr = intersection_map.allocate(size_per_slice)
-        else:
-            allocated_addr = intersection_map.allocate(req.size)
-        
+        allocation_size = req.slice_allocation_size()
+        allocated_addr = intersection_map.allocate(allocation_size)
         if allocated_addr is None:
             return None
         
         # Apply allocation to all affected mappings
-        allocation_size = req.size // 4 if req.allocation_mode == SliceAllocationMode.PARALLEL else req.size
         intersection_map.apply_allocation_to_constituents(allocated_addr, allocation_size, req.allocation_id)
         
         return allocated_addr
     
     def get_memory_stats(self) -> Dict[str, Any]:
-        """Get statistics about current memory state"""
+        """Get statistics about current memory state, O(mappings)"""
         stats = {
             'total_mappings': len(self.signature_to_map),
+            'fork_count': self._fork_count,
+            'merge_count': self._merge_count,
+            'total_allocated_bytes': self._allocated_bytes,
+            'total_free_bytes': self._total_capacity() - self._allocated_bytes,
             'mappings': []
         }
         
@@ -650,48 +785,43 @@ class MappingCentricMemoryManager:
     
     def get_requirements_summary(self) -> Dict[str, Any]:
         """Get summary of all processed requirements and their fulfillment status"""
-        fulfilled_count = sum(1 for req in self.processed_requirements if req.is_fulfilled())
-        pending_count = len(self.processed_requirements) - fulfilled_count
-        
         return {
             'total_requirements': len(self.processed_requirements),
-            'fulfilled_count': fulfilled_count,
-            'pending_count': pending_count,
+            'fulfilled_count': self._fulfilled_count,
+            'pending_count': len(self.processed_requirements) - self._fulfilled_count,
             'requirements': self.processed_requirements
         }
     
     def total_allocated_bytes(self) -> int:
         """
-        Calculate the total number of bytes allocated across all coordinates in the system.
-        This multiplies each mapping's allocated bytes by the number of coordinates it covers.
+        Total number of bytes allocated across all coordinates in the system:
+        each allocation's slice size times the coordinates it was placed in.
         """
-        total_bytes = 0
-        
-        for signature, memory_map in self.signature_to_map.items():
-            # Get allocated bytes in this mapping
-            allocated_in_mapping = memory_map.get_total_allocated()
-            
-            # Get number of coordinates this mapping covers
-            coordinate_count = len(signature.covered_coordinates)
-            
-            # Each coordinate in this mapping has the same allocation pattern
-            total_bytes += allocated_in_mapping * coordinate_count
-        
-        return total_bytes
+        return self._allocated_bytes
+    
+    def _total_capacity(self) -> int:
+        return self.pe_count * self.mss_per_pe * self.slices_per_mss * self.slice_size
+    
+    def recompute_statistics(self) -> Dict[str, int]:
+        """
+        Recompute the running statistics from the mappings and requirements;
+        for checking that they were kept up to date.
+        """
+        allocated = sum(mapping.get_total_allocated() * len(signature.covered_coordinates)
+                        for signature, mapping in self.signature_to_map.items())
+        fulfilled = [req for req in self.processed_requirements if req.is_fulfilled()]
+        return {
+            'total_allocated_bytes': allocated,
+            'total_requested_bytes': sum(req.total_allocation_size() for req in fulfilled),
+            'fulfilled_count': len(fulfilled),
+        }
     
     def total_requested_allocations(self) -> int:
         """
-        Calculate the total number of bytes requested by all fulfilled requirements.
-        This sums the total_allocation_size() for all successfully allocated requirements.
-        Should equal total_allocated_bytes() for validation.
+        Total number of bytes requested by all fulfilled requirements, the sum of
+        their total_allocation_size(). Should equal total_allocated_bytes() for validation.
         """
-        total_requested = 0
-        
-        for req in self.processed_requirements:
-            if req.is_fulfilled():
-                total_requested += req.total_allocation_size()
-        
-        return total_requested
+        return self._requested_bytes
     
     def print_requirements_summary(self):
         """Print a detailed summary of all requirements and their fulfillment status"""
@@ -737,17 +867,15 @@ class MappingCentricMemoryManager:
         successful_count = 0
         failed_count = 0
         
-        print(f"Allocating {len(ordered_requirements)} requirements in optimized order...")
-        print()
-        
-        for i, req in enumerate(ordered_requirements, 1):
-            print(f"Step {i}: Allocating '{req.allocation_id}' ({req.size:,} bytes)")
-            
+        for req in ordered_requirements:
             # Record state before allocation
             mappings_before = len(self.signature_to_map)
             
-            # Attempt allocation
-            success = self.allocate_requirement(req)
+            # Attempt allocation; a requirement no resource combination can hold fails
+            try:
+                success = self.allocate_requirement(req)
+            except AllocationError:
+                success = False
             
             # Record state after allocation
             mappings_after = len(self.signature_to_map)
@@ -767,14 +895,8 @@ class MappingCentricMemoryManager:
             
             if success:
                 successful_count += 1
-                fork_msg = f" (forked: {mappings_before} -> {mappings_after})" if fork_occurred else " (no fork)"
-                print(f"  [SUCCESS]{fork_msg}")
-                if req.allocation_details:
-                    print(f"  Address: 0x{req.allocation_details.allocated_address:08x}")
             else:
                 failed_count += 1
-                print(f"  [FAILED] Could not allocate")
-            print()
         
         # Clear collected requirements after processing
         self.collected_requirements.clear()
@@ -824,17 +946,9 @@ class MappingCentricMemoryManager:
         # Sort by priority
         sorted_requirements = sorted(requirements, key=requirement_priority)
         
-        print("Requirement ordering strategy:")
-        print("  1. Process broadest scopes first (ALL > SPECIFIC > GROUP)")
-        print("  2. Minimize auto-selections early")
-        print("  3. Prioritize larger allocations")
-        print("  4. Process serial allocations before parallel")
-        print()
-        
-        for i, req in enumerate(sorted_requirements, 1):
-            scope_desc = self._describe_requirement_scope(req)
-            print(f"  {i}. {req.allocation_id}: {scope_desc} ({req.size:,} bytes)")
-        print()
+        if self.events.enabled:
+            for position, req in enumerate(sorted_requirements):
+                self.events.emit(EventType.REQUIREMENT_ORDERED, req.allocation_id, position)
         
         return sorted_requirements
     
@@ -858,8 +972,10 @@ class MappingCentricMemoryManager:
             else:
                 return f"Auto-{dim_name}"
         elif dim_req.scope == DimensionScope.GROUP:
-            group_name = dim_req.group.value.replace("group_", "")
-            return f"{dim_name}-{group_name}"
+            if dim_req.mask is None:
+                group_name = dim_req.group.value.replace("group_", "")
+                return f"{dim_name}-{group_name}"
+            return f"{dim_name}-mask0x{dim_req.mask:x}"
         else:
             return f"Unknown-{dim_name}"
 
@@ -1180,6 +1296,103 @@ def test_allocation_failure():
     print("✓ Allocation failure test passed")
 
 
+def test_incremental_statistics():
+    """Test running statistics against a full recompute"""
+    print("Testing incremental statistics...")
+    
+    manager = MappingCentricMemoryManager(pe_count=2, mss_per_pe=2, slices_per_mss=8, slice_size=4096)
+    requirements = [
+        (512, DimensionScope.ALL, DimensionScope.ALL, None),
+        (256, 0, DimensionScope.ALL, None),
+        (1024, DimensionScope.ALL, 1, 0x0F),
+        (2048, None, DimensionScope.ALL, None),
+        (8192, DimensionScope.ALL, DimensionScope.ALL, None),  # Too big, stays pending
+    ]
+    
+    def dimension(spec):
+        if spec == DimensionScope.ALL:
+            return DimensionRequirement(DimensionScope.ALL)
+        return DimensionRequirement(DimensionScope.SPECIFIC, value=spec)
+    
+    for i, (size, pe, mss, mask) in enumerate(requirements):
+        slice_req = (DimensionRequirement(DimensionScope.GROUP, mask=mask) if mask
+                     else DimensionRequirement(DimensionScope.ALL))
+        mode = SliceAllocationMode.PARALLEL if mask else SliceAllocationMode.SERIAL
+        manager.allocate_requirement(MemoryRequirement(size, dimension(pe), dimension(mss), slice_req,
+                                                       mode, f"req{i}"))
+        
+        recomputed = manager.recompute_statistics()
+        assert manager.total_allocated_bytes() == recomputed['total_allocated_bytes'], "allocated bytes drifted"
+        assert manager.total_requested_allocations() == recomputed['total_requested_bytes'], "requested bytes drifted"
+        assert manager.get_requirements_summary()['fulfilled_count'] == recomputed['fulfilled_count'], \
+            "fulfilled count drifted"
+        for mapping in manager.signature_to_map.values():
+            gaps = [end - start for start, end in mapping.get_free_ranges()]
+            assert mapping.get_largest_free_block() == max(gaps, default=0), "largest free block drifted"
+    
+    stats = manager.get_memory_stats()
+    summary = manager.get_requirements_summary()
+    assert summary['pending_count'] == 1, f"Oversized requirement should stay pending, got {summary['pending_count']}"
+    assert stats['fork_count'] == stats['total_mappings'] - 1, "Every fork adds one mapping"
+    assert stats['total_free_bytes'] == 2 * 2 * 8 * 4096 - stats['total_allocated_bytes'], "free bytes"
+    
+    print("✓ Incremental statistics test passed")
+
+
+def test_allocation_events():
+    """Test allocation, fork and failure events in a ring buffer"""
+    print("Testing allocation events...")
+    from trace_events import RingBufferSink, decode
+    
+    events = RingBufferSink(capacity=4)
+    manager = MappingCentricMemoryManager(pe_count=2, mss_per_pe=1, slices_per_mss=1, events=events)
+    all_dims = lambda: DimensionRequirement(DimensionScope.ALL)
+    manager.collect_requirement(MemoryRequirement(256, DimensionRequirement(DimensionScope.SPECIFIC, value=0),
+                                                  all_dims(), all_dims(), allocation_id="pe0"))
+    manager.collect_requirement(MemoryRequirement(512, all_dims(), all_dims(), all_dims(), allocation_id="global"))
+    manager.collect_requirement(MemoryRequirement(2*1024*1024, all_dims(), all_dims(), all_dims(),
+                                                  allocation_id="too_big"))
+    manager.allocate_all()
+    
+    kinds = [(event.type, event.subject) for event in events.events()]
+    assert events.count == 7 and events.dropped == 3, f"Expected 7 events, 3 dropped, got {events.count}"
+    assert kinds == [(EventType.FAILED, "too_big"), (EventType.ALLOCATED, "global"),
+                     (EventType.FORKED, "pe0"), (EventType.ALLOCATED, "pe0")], f"Unexpected events {kinds}"
+    assert events.events()[-1].values == (512, 256, 2), "pe0 placed after the global buffer"
+    assert decode(events.to_bytes(), events.subjects) == events.events(), "binary records round trip"
+    assert len(events.subjects) <= events.capacity, "subjects of overwritten records are reused"
+    events.clear()
+    assert events.events() == [] and events.subjects == [], "clear drops the subjects"
+    
+    print("✓ Allocation events test passed")
+
+
+def test_mapping_merge():
+    """Test that mappings left with the same allocations merge back"""
+    print("Testing mapping merge...")
+    pe0 = lambda size, name: MemoryRequirement(size, DimensionRequirement(DimensionScope.SPECIFIC, value=0),
+                                               DimensionRequirement(DimensionScope.ALL),
+                                               DimensionRequirement(DimensionScope.ALL), allocation_id=name)
+    
+    manager = MappingCentricMemoryManager(pe_count=2, mss_per_pe=1, slices_per_mss=2, slice_size=1024)
+    assert not manager.allocate_requirement(pe0(2048, "too_big")), "Oversized buffer should fail"
+    assert len(manager.signature_to_map) == 2, "The failed buffer leaves its fork behind"
+    assert manager.merge_equal_mappings() == 1 and len(manager.signature_to_map) == 1, "Forks should merge back"
+    
+    manager = MappingCentricMemoryManager(pe_count=2, mss_per_pe=1, slices_per_mss=2, slice_size=1024,
+                                          auto_merge=True)
+    assert not manager.allocate_requirement(pe0(2048, "too_big")), "Oversized buffer should fail"
+    assert manager.allocate_requirement(pe0(64, "small")), "PE 0 buffer should fit"
+    stats = manager.get_memory_stats()
+    assert stats['total_mappings'] == 2 and stats['fork_count'] == 2 and stats['merge_count'] == 1, \
+        f"Unexpected mapping counts {stats}"
+    assert manager.merge_equal_mappings() == 0, "Different allocations should not merge"
+    recomputed = manager.recompute_statistics()
+    assert recomputed['total_allocated_bytes'] == manager.total_allocated_bytes(), "Totals should survive merges"
+    
+    print("✓ Mapping merge test passed")
+
+
 def run_all_tests():
     """Run all unit tests"""
     print("Running memory manager unit tests...\n")
@@ -1193,6 +1406,9 @@ def run_all_tests():
         test_complex_multiple_requirements()
         test_cross_mapping_allocation()
         test_allocation_failure()
+        test_incremental_statistics()
+        test_allocation_events()
+        test_mapping_merge()
         
         print("\n✅ All tests passed!")
         
@@ -0,0 +1,190 @@
+"""Differential test of the native memory manager against MappingCentricMemoryManager.
+
+Generates random requirement streams (cpp/src/requirement_stream.hpp format),
+replays each one on both backends and compares every placement: address,
+resolved PE/MSS, slices, bytes per slice and mapping count, plus the final
+mapping, fork and allocated byte totals. Replays are timed on both sides.
+
+    python3 memory_manager_difftest.py --native cpp/_gate_build/mm_replay --seeds 200
+
+Without --native, cpp/build/mm_replay is used.
+
+--merge compares both with equal mappings merged after every allocation.
+
+A stream that diverges is written to difftest_seed<N>.txt for replaying with
+mm_replay. Exits 1 on any mismatch.
+"""
+import argparse
+import os
+import random
+import subprocess
+import sys
+import time
+from typing import List, Tuple
+
+from memory_manager import (AllocationError, DimensionRequirement, DimensionScope, MappingCentricMemoryManager,
+                            MemoryRequirement, SliceAllocationMode)
+
+DEFAULT_NATIVE = "cpp/build/mm_replay"
+
+
+def generate_stream(rng: random.Random, count: int) -> str:
+    """Random stream over a random small geometry"""
+    pe_count = rng.randint(1, 6)
+    mss_per_pe = rng.randint(1, 4)
+    slices_per_mss = rng.choice([2, 4, 8])
+    slice_size = rng.choice([4096, 16384, 65536])
+    grid_width = rng.randint(1, pe_count)
+    lines = [f"geometry {pe_count} {mss_per_pe} {slices_per_mss} {slice_size} {grid_width}"]
+
+    def dimension(size: int, allow_mask: bool) -> str:
+        choice = rng.random()
+        if choice < 0.35:
+            return "all"
+        if choice < 0.55:
+            return "auto"
+        if allow_mask and choice < 0.75:
+            return f"mask:0x{rng.randint(1, (1 << size) - 1):x}"
+        return str(rng.randrange(size))
+
+    collected = False
+    for i in range(count):
+        size = rng.choice([rng.randint(1, 256), rng.randint(1, slice_size // 4), rng.randint(1, slice_size)])
+        # Locality only decides between PEs, so its requirements select theirs
+        policy = rng.choice(["", "", "", "", " policy worst-fit",
+                             f" policy pe-locality home {rng.randrange(pe_count)}"])
+        pe = "auto" if "pe-locality" in policy else dimension(pe_count, False)
+        entry = (f"{rng.choice(['alloc', 'collect'])} r{i} {size} {pe} "
+                 f"{dimension(mss_per_pe, False)} {dimension(slices_per_mss, True)}")
+        if rng.random() < 0.3:
+            entry += f" parallel {rng.choice([1, 16, 64])}"
+        entry += policy
+        collected = collected or entry.startswith("collect")
+        lines.append(entry)
+        if collected and rng.random() < 0.1:
+            lines.append("batch")
+            collected = False
+    lines.append("batch")
+    return "\n".join(lines) + "\n"
+
+
+def _dimension(token: str) -> DimensionRequirement:
+    if token == "all":
+        return DimensionRequirement(DimensionScope.ALL)
+    if token == "auto":
+        return DimensionRequirement(DimensionScope.SPECIFIC, value=None)
+    if token.startswith("mask:"):
+        return DimensionRequirement(DimensionScope.GROUP, mask=int(token[5:], 0))
+    return DimensionRequirement(DimensionScope.SPECIFIC, value=int(token, 0))
+
+
+def replay_python(stream: str, merge: bool = False) -> Tuple[List[str], int]:
+    """Result lines of the Python manager, as printed by mm_replay, and the replay time"""
+    operations = [line.split("#")[0].split() for line in stream.splitlines()]
+    operations = [args for args in operations if args]
+    geometry = [int(value, 0) for value in operations[0][1:5]]
+    grid_width = int(operations[0][5], 0) if len(operations[0]) > 5 else None
+
+    start = time.perf_counter_ns()
+    manager = MappingCentricMemoryManager(*geometry, auto_merge=merge, grid_width=grid_width)
+    for args in operations[1:]:
+        if args[0] == "batch":
+            manager.allocate_all()
+            continue
+        req = MemoryRequirement(int(args[2], 0), _dimension(args[3]), _dimension(args[4]), _dimension(args[5]),
+                                allocation_id=args[1])
+        options = args[6:]
+        if options[:1] == ["parallel"]:
+            req.allocation_mode = SliceAllocationMode.PARALLEL
+            options = options[1:]
+            if options and options[0] not in ("policy", "home"):
+                req.interleave_width = int(options.pop(0), 0)
+        for key, value in zip(options[::2], options[1::2]):
+            if key == "policy":
+                req.placement_policy = value
+            else:
+                req.home_pe = int(value, 0)
+        if args[0] == "collect":
+            manager.collect_requirement(req)
+            continue
+        try:
+            manager.allocate_requirement(req)
+        except AllocationError:
+            pass
+    elapsed = time.perf_counter_ns() - start
+
+    lines = []
+    for req in manager.processed_requirements:
+        if not req.is_fulfilled():
+            lines.append(f"{req.allocation_id} fail")
+            continue
+        details = req.allocation_details
+        slices = details.resolved_slice_values
+        if slices == [None]:
+            slices = range(manager.slices_per_mss)
+        mask = sum(1 << slice_id for slice_id in slices)
+        pe = -1 if details.resolved_pe is None else details.resolved_pe
+        mss = -1 if details.resolved_mss is None else details.resolved_mss
+        lines.append(f"{req.allocation_id} ok 0x{details.allocated_address:x} {pe} {mss} 0x{mask:x} "
+                     f"{details.slice_allocation_size} {details.mapping_count_at_allocation}")
+    stats = manager.get_memory_stats()
+    lines.append(f"mappings {stats['total_mappings']} forks {stats['fork_count']} "
+                 f"allocated {manager.total_allocated_bytes()}")
+    return lines, elapsed
+
+
+def replay_native(binary: str, stream: str, merge: bool = False) -> Tuple[List[str], int]:
+    """Result lines and replay time of mm_replay"""
+    result = subprocess.run([binary, "-"] + (["--merge"] if merge else []), input=stream, capture_output=True,
+                            text=True)
+    if result.returncode != 0:
+        raise RuntimeError(f"{binary} failed: {result.stderr.strip()}")
+    lines = result.stdout.splitlines()
+    if not lines or not lines[-1].startswith("time_ns "):
+        raise RuntimeError(f"{binary} printed no replay time")
+    return lines[:-1], int(lines[-1].split()[1])
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--native", help=f"mm_replay binary (default: {DEFAULT_NATIVE})")
+    parser.add_argument("--seeds", type=int, default=100, help="Streams to compare")
+    parser.add_argument("--start-seed", type=int, default=0)
+    parser.add_argument("--requirements", type=int, default=40, help="Requirements per stream")
+    parser.add_argument("--merge", action="store_true", help="Merge equal mappings after every allocation")
+    args = parser.parse_args()
+
+    native = args.native or DEFAULT_NATIVE
+    if not os.path.exists(native):
+        print(f"{native} not found; build cpp/ into cpp/build or pass --native", file=sys.stderr)
+        return 2
+
+    python_ns = native_ns = 0
+    mismatches = 0
+    for seed in range(args.start_seed, args.start_seed + args.seeds):
+        stream = generate_stream(random.Random(seed), args.requirements)
+        expected, elapsed = replay_python(stream, args.merge)
+        python_ns += elapsed
+        actual, elapsed = replay_native(native, stream, args.merge)
+        native_ns += elapsed
+        if actual == expected:
+            continue
+
+        mismatches += 1
+        path = f"difftest_seed{seed}.txt"
+        with open(path, "w") as file:
+            file.write(stream)
+        line = next(i for i in range(max(len(actual), len(expected)))
+                    if i >= len(actual) or i >= len(expected) or actual[i] != expected[i])
+        print(f"seed {seed}: mismatch at result {line}, stream written to {path}")
+        print(f"  python: {expected[line] if line < len(expected) else '<missing>'}")
+        print(f"  native: {actual[line] if line < len(actual) else '<missing>'}")
+
+    print(f"{args.seeds} streams, {mismatches} mismatches")
+    print(f"python {python_ns / 1e6:.1f} ms, native {native_ns / 1e6:.1f} ms, "
+          f"speedup {python_ns / max(1, native_ns):.1f}x")
+    return 1 if mismatches else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,148 @@
+from dataclasses import dataclass
+
+
+@dataclass
+class TargetProfile:
+    """Device limits of a target platform (mirrors cpp/src/target_profile.hpp).
+
+    Profile files are line based, '#' starts a comment:
+
+        base chip|haps            # start from a built-in profile, must come first
+        name <name>
+        grid <size_x>x<size_y>
+        line_ids <n>              # AXI2AHB bridge line IDs
+        broadcast_groups <n>      # broadcast networks the NOC can hold, 0 for no limit
+        dma_burst <bytes>         # largest DMA payload, 0 for no limit
+        dma_align <bytes>
+        command_overhead_ns <ns>  # fixed loader cost of every command
+        apb_write_ns <ns>         # APB register write latency
+        safe_write_ns <ns>        # extra wait for a safe write to complete
+        switch_ns <ns>            # bridge settling time after a network switch
+        link_mbps <MB/s>          # command link bandwidth
+        dma_mbps <MB/s>           # DMA engine bandwidth
+        mss_per_pe <n>
+        slices_per_mss <n>
+        slice_size <bytes>
+    """
+    name: str = "chip"
+    size_x: int = 16
+    size_y: int = 16
+    line_id_count: int = 16
+    broadcast_groups: int = 0
+    dma_max_burst: int = 0
+    dma_alignment: int = 16
+    # Load time model (cpp/src/cost_model.hpp); nominal values until measured
+    command_overhead_ns: int = 40
+    apb_write_ns: int = 20
+    safe_write_ns: int = 200
+    switch_ns: int = 500
+    link_mbps: int = 1000
+    dma_mbps: int = 4000
+    # Memory geometry used by the allocators
+    mss_per_pe: int = 4
+    slices_per_mss: int = 8
+    slice_size: int = 1024 * 1024
+
+    # File key for every numeric field
+    _KEYS = {
+        "line_ids": "line_id_count",
+        "broadcast_groups": "broadcast_groups",
+        "dma_burst": "dma_max_burst",
+        "dma_align": "dma_alignment",
+        "command_overhead_ns": "command_overhead_ns",
+        "apb_write_ns": "apb_write_ns",
+        "safe_write_ns": "safe_write_ns",
+        "switch_ns": "switch_ns",
+        "link_mbps": "link_mbps",
+        "dma_mbps": "dma_mbps",
+        "mss_per_pe": "mss_per_pe",
+        "slices_per_mss": "slices_per_mss",
+        "slice_size": "slice_size",
+    }
+
+    @staticmethod
+    def chip() -> 'TargetProfile':
+        """16x16 chip"""
+        return TargetProfile()
+
+    @staticmethod
+    def haps() -> 'TargetProfile':
+        """4x2 HAPS prototyping platform: same device logic at prototyping clock rates"""
+        return TargetProfile(name="haps", size_x=4, size_y=2, command_overhead_ns=800, apb_write_ns=400,
+                             safe_write_ns=4000, switch_ns=10000, link_mbps=50, dma_mbps=200)
+
+    @staticmethod
+    def builtin(name: str) -> 'TargetProfile':
+        if name == "chip":
+            return TargetProfile.chip()
+        if name == "haps":
+            return TargetProfile.haps()
+        raise ValueError(f"Unknown target profile: {name}")
+
+    @staticmethod
+    def parse(text: str) -> 'TargetProfile':
+        """Parse a profile; keys not given keep the value of the base profile, or of chip."""
+        profile = TargetProfile.chip()
+        has_keys = False
+        for line_number, line in enumerate(text.splitlines(), 1):
+            args = line.split('#', 1)[0].split()
+            if not args:
+                continue
+            key = args[0]
+            if len(args) != 2:
+                raise ValueError(f"Line {line_number}: expected one value for '{key}'")
+            value = args[1]
+            try:
+                if key == "base":
+                    if has_keys:
+                        raise ValueError("'base' must come first")
+                    profile = TargetProfile.builtin(value)
+                elif key == "name":
+                    profile.name = value
+                elif key == "grid":
+                    size_x, _, size_y = value.partition('x')
+                    profile.size_x, profile.size_y = int(size_x, 0), int(size_y, 0)
+                elif key in TargetProfile._KEYS:
+                    setattr(profile, TargetProfile._KEYS[key], int(value, 0))
+                else:
+                    raise ValueError(f"unknown key '{key}'")
+            except ValueError as e:
+                raise ValueError(f"Line {line_number}: {e}") from None
+            has_keys = True
+        profile.validate()
+        return profile
+
+    @staticmethod
+    def load(path: str) -> 'TargetProfile':
+        with open(path) as f:
+            try:
+                return TargetProfile.parse(f.read())
+            except ValueError as e:
+                raise ValueError(f"{path}: {e}") from None
+
+    @staticmethod
+    def resolve(name_or_path: str) -> 'TargetProfile':
+        """Built-in profile if name_or_path is one, else the profile file at that path"""
+        if name_or_path in ("chip", "haps"):
+            return TargetProfile.builtin(name_or_path)
+        return TargetProfile.load(name_or_path)
+
+    def validate(self) -> None:
+        if self.size_x <= 0 or self.size_y <= 0:
+            raise ValueError("Target grid must not be empty")
+        if self.line_id_count <= 0:
+            raise ValueError("Target needs at least one line ID")
+        if self.dma_alignment <= 0 or self.dma_alignment & (self.dma_alignment - 1):
+            raise ValueError("DMA alignment must be a power of two")
+        if self.dma_max_burst % self.dma_alignment:
+            raise ValueError("DMA burst must be a multiple of the alignment")
+        if self.link_mbps <= 0 or self.dma_mbps <= 0:
+            raise ValueError("Target bandwidths must not be zero")
+        if min(self.mss_per_pe, self.slices_per_mss, self.slice_size) <= 0:
+            raise ValueError("Target memory geometry must not be empty")
+
+    def to_text(self) -> str:
+        """Profile in file syntax, identical to the native to_string"""
+        lines = [f"name {self.name}", f"grid {self.size_x}x{self.size_y}"]
+        lines += [f"{key} {getattr(self, attr)}" for key, attr in TargetProfile._KEYS.items()]
+        return "\n".join(lines) + "\n"
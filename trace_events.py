@@ -0,0 +1,162 @@
+"""Structured trace events (mirrors cpp/src/trace_events.hpp).
+
+Components emit events to a sink instead of printing. The default sink is
+disabled, and emitters check `sink.enabled` before building an event, so
+tracing costs one attribute test when it is off.
+
+RingBufferSink keeps the latest events as fixed 32-byte little-endian
+records, the same layout as the native RingBufferSink:
+
+    type u8, 3 padding bytes, subject u32, values 3 x u64
+
+subject indexes the sink's interned subject strings.
+"""
+import struct
+from dataclasses import dataclass
+from enum import IntEnum
+from typing import Callable, Dict, List, Tuple
+
+
+class EventType(IntEnum):
+    REQUIREMENT_ORDERED = 1  # subject: allocation id; values: position in the batch
+    ALLOCATED = 2            # subject: allocation id; values: address, bytes per slice, mappings
+    FORKED = 3               # subject: allocation id; values: mappings before, mappings after
+    FAILED = 4               # subject: allocation id; values: size, FailureReason
+    NETWORK_ADDED = 5        # subject: network type; values: line id
+    MERGED = 6               # subject: allocation id; values: mappings before, mappings after
+
+
+class FailureReason(IntEnum):
+    NO_ADDRESS = 0       # Resources resolved, but no common free range fits
+    NO_COMBINATION = 1   # No resource combination can hold the requirement
+
+
+@dataclass(frozen=True)
+class Event:
+    type: EventType
+    subject: str
+    values: Tuple[int, int, int] = (0, 0, 0)
+
+
+class EventSink:
+    """Base sink; disabled, drops every event"""
+    enabled = False
+
+    def emit(self, event_type: EventType, subject: str, a: int = 0, b: int = 0, c: int = 0) -> None:
+        pass
+
+
+class CallbackSink(EventSink):
+    """Passes every event to a callback"""
+    enabled = True
+
+    def __init__(self, callback: Callable[[Event], None]):
+        self.callback = callback
+
+    def emit(self, event_type: EventType, subject: str, a: int = 0, b: int = 0, c: int = 0) -> None:
+        self.callback(Event(event_type, subject, (a, b, c)))
+
+
+class PrintSink(EventSink):
+    """Prints one line per event, for interactive use"""
+    enabled = True
+
+    def emit(self, event_type: EventType, subject: str, a: int = 0, b: int = 0, c: int = 0) -> None:
+        print(f"{event_type.name} {subject} {a} {b} {c}")
+
+
+class RingBufferSink(EventSink):
+    """Keeps the latest capacity events as binary records
+
+    Subjects no kept record refers to give their index to new ones, so
+    subjects never has more than capacity entries; free entries are empty.
+    """
+    enabled = True
+    RECORD = struct.Struct("<B3xIQQQ")
+
+    def __init__(self, capacity: int = 4096):
+        if capacity <= 0:
+            raise ValueError("Ring buffer capacity must be positive")
+        self.capacity = capacity
+        self.buffer = bytearray(capacity * self.RECORD.size)
+        self.subjects: List[str] = []
+        self._subject_ids: Dict[str, int] = {}
+        self._subject_refs: List[int] = []     # Kept records per subject
+        self._free_subjects: List[int] = []
+        self.count = 0      # Events emitted so far, kept or not
+
+    @property
+    def dropped(self) -> int:
+        """Events overwritten by newer ones"""
+        return max(0, self.count - self.capacity)
+
+    def _intern(self, subject: str) -> int:
+        subject_id = self._subject_ids.get(subject)
+        if subject_id is not None:
+            self._subject_refs[subject_id] += 1
+            return subject_id
+        if self._free_subjects:
+            subject_id = self._free_subjects.pop()
+            self.subjects[subject_id] = subject
+            self._subject_refs[subject_id] = 1
+        else:
+            subject_id = len(self.subjects)
+            self.subjects.append(subject)
+            self._subject_refs.append(1)
+        self._subject_ids[subject] = subject_id
+        return subject_id
+
+    def _release(self, subject_id: int) -> None:
+        self._subject_refs[subject_id] -= 1
+        if self._subject_refs[subject_id] == 0:
+            del self._subject_ids[self.subjects[subject_id]]
+            self.subjects[subject_id] = ""
+            self._free_subjects.append(subject_id)
+
+    def emit(self, event_type: EventType, subject: str, a: int = 0, b: int = 0, c: int = 0) -> None:
+        offset = (self.count % self.capacity) * self.RECORD.size
+        if self.count >= self.capacity:
+            self._release(self.RECORD.unpack_from(self.buffer, offset)[1])
+        self.RECORD.pack_into(self.buffer, offset, event_type, self._intern(subject), a, b, c)
+        self.count += 1
+
+    def to_bytes(self) -> bytes:
+        """Kept records, oldest first"""
+        if self.count <= self.capacity:
+            return bytes(self.buffer[:self.count * self.RECORD.size])
+        split = (self.count % self.capacity) * self.RECORD.size
+        return bytes(self.buffer[split:] + self.buffer[:split])
+
+    def events(self) -> List[Event]:
+        """Kept events, oldest first"""
+        return decode(self.to_bytes(), self.subjects)
+
+    def clear(self) -> None:
+        self.count = 0
+        self.subjects.clear()
+        self._subject_ids.clear()
+        self._subject_refs.clear()
+        self._free_subjects.clear()
+
+
+def decode(data: bytes, subjects: List[str]) -> List[Event]:
+    """Events of binary records, e.g. a native ring buffer dump"""
+    if len(data) % RingBufferSink.RECORD.size:
+        raise ValueError("Trace data is not a whole number of records")
+    return [Event(EventType(event_type), subjects[subject_id], (a, b, c))
+            for event_type, subject_id, a, b, c in RingBufferSink.RECORD.iter_unpack(data)]
+
+
+_default_sink: EventSink = EventSink()
+
+
+def default_sink() -> EventSink:
+    """Sink of components constructed without one"""
+    return _default_sink
+
+
+def set_default_sink(sink: EventSink) -> EventSink:
+    """Replace the default sink, returning the previous one"""
+    global _default_sink
+    previous, _default_sink = _default_sink, sink
+    return previous